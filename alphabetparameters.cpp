@@ -18,6 +18,7 @@
 
 #include <algorithm>
 #include <cassert>
+#include <type_traits>
 
 #include "alphabetparameters.h"
 #include "datamanager.h"
@@ -101,6 +102,18 @@ void String::counts(const LongLetterString &letterString, char *countsArray)
 		countsArray[(int)*it]++;
 }
 
+LetterMask LetterMasks::fromLetters(const LetterString &letterString)
+{
+	LetterMask ret = 0;
+
+	LetterString::const_iterator myEnd(letterString.end());
+	for (LetterString::const_iterator it = letterString.begin(); it != myEnd; ++it)
+		if (*it >= QUACKLE_FIRST_LETTER && *it < QUACKLE_FIRST_LETTER + QUACKLE_MAXIMUM_ALPHABET_SIZE)
+			ret |= bit(*it);
+
+	return ret;
+}
+
 ////////////
 
 AlphabetParameters::AlphabetParameters()
@@ -120,7 +133,8 @@ void AlphabetParameters::setAlphabet(const Alphabet &alphabet)
 		assert(m_letterLookup.find(alphabetIt->text()) == m_letterLookup.end());
 		m_letterLookup[alphabetIt->text()] = int(alphabetIt - m_alphabet.begin());
 	}
-	
+
+	updateTables();
 }
 
 void AlphabetParameters::setLetterParameter(Letter letter, const LetterParameter &letterParameter)
@@ -134,6 +148,7 @@ void AlphabetParameters::setLetterParameter(Letter letter, const LetterParameter
 
 	m_alphabet[letter] = letterParameter;
 	m_letterLookup[letterParameter.text()] = letter;
+	updateTables();
 }
 
 void AlphabetParameters::updateLength()
@@ -141,6 +156,107 @@ void AlphabetParameters::updateLength()
 	m_length = int(m_alphabet.size() - QUACKLE_FIRST_LETTER);
 }
 
+namespace
+{
+
+unsigned int characterCode(UVChar character)
+{
+	return (make_unsigned<UVChar>::type)character;
+}
+
+}
+
+void AlphabetParameters::updateTables()
+{
+	// the trie with each node's children in a map, until it's flattened
+	vector<map<UVChar, unsigned int> > children(1);
+	vector<int> letters(1, -1);
+
+	auto insert = [&](const UVString &text, int letter) {
+		if (text.empty())
+			return;
+
+		unsigned int node = 0;
+		for (const UVChar character : text)
+		{
+			const auto it = children[node].find(character);
+			if (it != children[node].end())
+			{
+				node = it->second;
+				continue;
+			}
+
+			const unsigned int child = (unsigned int)letters.size();
+			children[node][character] = child;
+			children.emplace_back();
+			letters.push_back(-1);
+			node = child;
+		}
+
+		// encode looks texts up before blank texts, and blank texts
+		// in alphabet order, so the first to claim a node keeps it
+		if (letters[node] < 0)
+			letters[node] = letter;
+	};
+
+	for (const auto &it : m_letterLookup)
+		if (it.second < (int)m_alphabet.size())
+			insert(it.first, m_alphabet[it.second].letter());
+	for (const auto &it : m_alphabet)
+		insert(it.blankText(), setBlankness(it.letter()));
+
+	m_trieNodes.clear();
+	m_trieEdges.clear();
+	m_trieTable.assign(children.size() * 256, 0);
+	for (size_t node = 0; node < children.size(); ++node)
+	{
+		TrieNode trieNode = { letters[node], (unsigned int)m_trieEdges.size(), 0 };
+		for (const auto &it : children[node])
+		{
+			if (characterCode(it.first) < 256)
+			{
+				m_trieTable[node * 256 + characterCode(it.first)] = it.second;
+				continue;
+			}
+
+			TrieEdge edge = { it.first, it.second };
+			m_trieEdges.push_back(edge);
+			++trieNode.edgeCount;
+		}
+		m_trieNodes.push_back(trieNode);
+	}
+
+	m_decodeText.clear();
+	for (int letter = 0; letter < 256; ++letter)
+	{
+		UVString text;
+		if (letter <= lastLetter())
+		{
+			if (letter < (int)m_alphabet.size())
+				text = m_alphabet[letter].text();
+		}
+		else if (letter >= QUACKLE_BLANK_OFFSET && letter - QUACKLE_BLANK_OFFSET < (int)m_alphabet.size())
+			text = m_alphabet[letter - QUACKLE_BLANK_OFFSET].blankText();
+
+		m_decodeStart[letter] = (unsigned int)m_decodeText.size();
+		m_decodeLength[letter] = (unsigned int)text.size();
+		m_decodeText += text;
+	}
+}
+
+unsigned int AlphabetParameters::trieChild(unsigned int node, UVChar character) const
+{
+	if (characterCode(character) < 256)
+		return m_trieTable[node * 256 + characterCode(character)];
+
+	const TrieNode &trieNode = m_trieNodes[node];
+	for (unsigned int i = trieNode.firstEdge; i < trieNode.firstEdge + trieNode.edgeCount; ++i)
+		if (m_trieEdges[i].character == character)
+			return m_trieEdges[i].node;
+
+	return 0;
+}
+
 Alphabet AlphabetParameters::emptyAlphabet()
 {
 	Alphabet ret(QUACKLE_FIRST_LETTER);
@@ -175,66 +291,61 @@ LetterString AlphabetParameters::clearBlankness(const LetterString &letterString
 
 UVString AlphabetParameters::userVisible(const LetterString &letterString) const
 {
-	UVString ret;
-
+	size_t length = 0;
 	const LetterString::const_iterator end(letterString.end());
 	for (LetterString::const_iterator it = letterString.begin(); it != end; ++it)
-		ret += userVisible(*it);
+		length += m_decodeLength[(Letter)*it];
+
+	UVString ret;
+	ret.reserve(length);
+	for (LetterString::const_iterator it = letterString.begin(); it != end; ++it)
+		ret.append(m_decodeText, m_decodeStart[(Letter)*it], m_decodeLength[(Letter)*it]);
 
 	return ret;
 }
 
 UVString AlphabetParameters::userVisible(Letter letter) const
 {
-	if (isBlankLetter(letter))
-		return letterParameter(letter - QUACKLE_BLANK_OFFSET).blankText();
-	else
-		return letterParameter(letter).text();
+	return m_decodeText.substr(m_decodeStart[letter], m_decodeLength[letter]);
 }
 
 LetterString AlphabetParameters::encode(const UVString &word, UVString *leftover) const
 {
-	LetterString ret;
-
-	UVString leftoverQuery;
-	const Alphabet::const_iterator alphabetEnd(m_alphabet.end());
-	LetterLookupMap::const_iterator lookupEnd = m_letterLookup.end();
-	
-	const UVString::const_iterator end(word.end());
-	for (UVString::const_iterator it = word.begin(); it != end; ++it)
-	{
-		UVString query(leftoverQuery);
-		query += *it;
+	size_t leftoverLength;
+	LetterString ret = encode(word.data(), word.length(), &leftoverLength);
 
-		bool blank = false;
+	if (leftover)
+		*leftover = word.substr(word.length() - leftoverLength);
 
-		Alphabet::const_iterator alphabetIt;
-		LetterLookupMap::const_iterator lookupIt = m_letterLookup.find(query);
+	return ret;
+}
 
-		if (lookupIt == lookupEnd)
-		{
-			for (alphabetIt = m_alphabet.begin(); alphabetIt != alphabetEnd; ++alphabetIt)
-				if (alphabetIt->blankText() == query)
-					break;
+// Letters are matched as soon as the text since the last one spells
+// one, so a letter whose text begins another's hides the longer one.
+// Once no letter begins with the text since the last, none can, and
+// the rest is left over.
+LetterString AlphabetParameters::encode(const UVChar *text, size_t length, size_t *leftoverLength) const
+{
+	LetterString ret;
 
-			if (alphabetIt == alphabetEnd)
-			{
-				leftoverQuery = query;
-				continue;
-			}
+	size_t start = 0;
+	unsigned int node = 0;
+	for (size_t i = 0; i < length; ++i)
+	{
+		node = trieChild(node, text[i]);
+		if (node == 0)
+			break;
 
-			blank = true;
-			ret += blank? setBlankness(alphabetIt->letter()) : alphabetIt->letter();
-		} else {
-			ret += blank? setBlankness(m_alphabet[lookupIt->second].letter()) : m_alphabet[lookupIt->second].letter();
+		if (m_trieNodes[node].letter >= 0)
+		{
+			ret += (Letter)m_trieNodes[node].letter;
+			node = 0;
+			start = i + 1;
 		}
-		leftoverQuery.clear();
 	}
 
-	//UVcout << "encoded " << word << " to " << ret << endl; 
-
-	if (leftover)
-		*leftover = leftoverQuery;
+	if (leftoverLength)
+		*leftoverLength = length - start;
 
 	return ret;
 }
@@ -19,6 +19,7 @@
 #ifndef QUACKLE_ALPHABETPARAMETERS_H
 #define QUACKLE_ALPHABETPARAMETERS_H
 
+#include <cstdint>
 #include <vector>
 #include <map>
 
@@ -59,6 +60,41 @@ typedef std::string LongLetterString;
 
 typedef std::vector<LetterString> WordList;
 
+// A set of (blankless) letters, one bit per letter starting at
+// QUACKLE_FIRST_LETTER. Used for cross sets and rack contents.
+typedef uint64_t LetterMask;
+
+namespace LetterMasks
+{
+
+// every letter of the largest alphabet
+constexpr LetterMask full()
+{
+	return (LetterMask(1) << QUACKLE_MAXIMUM_ALPHABET_SIZE) - 1;
+}
+
+// letter must be a real letter, ie at least QUACKLE_FIRST_LETTER
+constexpr LetterMask bit(Letter letter)
+{
+	return LetterMask(1) << (letter - QUACKLE_FIRST_LETTER);
+}
+
+constexpr bool contains(LetterMask mask, Letter letter)
+{
+	return (mask & bit(letter)) != 0;
+}
+
+constexpr bool isFull(LetterMask mask)
+{
+	return mask == full();
+}
+
+// mask of the plain letters in letterString; blanks (designated
+// or not) and the other marks are skipped
+LetterMask fromLetters(const LetterString &letterString);
+
+}
+
 namespace String
 {
 
@@ -278,6 +314,11 @@ public:
 	// stored in leftover if it is non-null.
 	LetterString encode(const UVString &word, UVString *leftover = 0) const;
 
+	// As above, over the length characters at text, so they needn't be
+	// made into a string first. leftoverLength is set to the number of
+	// characters at the end that could not be encoded.
+	LetterString encode(const UVChar *text, size_t length, size_t *leftoverLength = 0) const;
+
 	// a convenience field; this is unused by libquackle
 	string alphabetName() const;
 	void setAlphabetName(const string &name);
@@ -288,11 +329,46 @@ public:
 protected:
 	void updateLength();
 
+	// Rebuilds the encoding trie and decoding table from m_alphabet
+	// and m_letterLookup; called whenever either changes.
+	void updateTables();
+
+	// the node under node along character, or 0, the root, if none
+	unsigned int trieChild(unsigned int node, UVChar character) const;
+
 	int m_length;
 	Alphabet m_alphabet;
 	typedef map<UVString, int> LetterLookupMap;
 	LetterLookupMap m_letterLookup;
 
+	// A trie of every letter's text and blank text, one character per
+	// step, so encoding is a walk with no strings made. A node's
+	// letter is what the text leading to it encodes, or -1. Node n's
+	// child along a character below 256 is m_trieTable[n * 256 +
+	// character], or 0 if there's none; its children along wider
+	// characters, which only wide user-visible strings have, are a
+	// run of m_trieEdges.
+	struct TrieNode
+	{
+		int letter;
+		unsigned int firstEdge;
+		unsigned int edgeCount;
+	};
+	struct TrieEdge
+	{
+		UVChar character;
+		unsigned int node;
+	};
+	vector<TrieNode> m_trieNodes;
+	vector<TrieEdge> m_trieEdges;
+	vector<unsigned int> m_trieTable;
+
+	// userVisible(letter) is m_decodeLength[letter] characters of
+	// m_decodeText from m_decodeStart[letter]
+	UVString m_decodeText;
+	unsigned int m_decodeStart[256];
+	unsigned int m_decodeLength[256];
+
 	string m_alphabetName;
 };
 
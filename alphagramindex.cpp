@@ -0,0 +1,390 @@
+/*
+ *  Quackle -- Crossword game artificial intelligence and analysis tool
+ *  Copyright (C) 2005-2019 Jason Katz-Brown, John O'Laughlin, and John Fultz.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+#include "alphagramindex.h"
+#include "binaryio.h"
+#include "lexiconparameters.h"
+
+using namespace Quackle;
+
+namespace
+{
+
+const uint8_t FileVersion = 1;
+
+struct IndexedWord
+{
+	LetterString alphagram;
+	LetterString word;
+	uint32_t info;
+
+	bool operator<(const IndexedWord &other) const
+	{
+		return alphagram < other.alphagram || (alphagram == other.alphagram && word < other.word);
+	}
+};
+
+void collectWords(const LexiconParameters &lexicon, int index, LetterString &prefix, vector<IndexedWord> &words)
+{
+	unsigned int p;
+	Letter letter;
+	bool t;
+	bool lastchild;
+	bool british;
+	int playability;
+
+	do
+	{
+		lexicon.dawgAt(index, p, letter, t, lastchild, british, playability);
+		prefix.push_back(letter);
+		if (t)
+		{
+			IndexedWord word = { String::alphabetize(prefix), prefix, (uint32_t)playability << 1 | british };
+			words.push_back(word);
+		}
+		if (p)
+			collectWords(lexicon, p, prefix, words);
+		index++;
+		prefix.pop_back();
+	} while (!lastchild);
+}
+
+}
+
+AlphagramIndex::AlphagramIndex()
+{
+	clear();
+}
+
+void AlphagramIndex::clear()
+{
+	m_letters.clear();
+	m_groupStart.assign(1, 0);
+	m_groupFirstWord.assign(1, 0);
+	m_wordInfo.clear();
+	m_table.clear();
+	m_lexiconHash.clear();
+}
+
+void AlphagramIndex::build(const LexiconParameters &lexicon)
+{
+	clear();
+	if (!lexicon.hasDawg())
+		return;
+
+	vector<IndexedWord> words;
+	LetterString prefix;
+	collectWords(lexicon, 1, prefix, words);
+	sort(words.begin(), words.end());
+
+	for (const auto &word : words)
+		addWord(word.alphagram, word.word, word.info);
+
+	m_lexiconHash = lexicon.hashString(false);
+	buildTable();
+}
+
+void AlphagramIndex::addWord(const LetterString &alphagram, const LetterString &word, uint32_t info)
+{
+	const int lastGroup = (int)m_groupStart.size() - 2;
+	const size_t length = alphagram.length();
+	const Letter *letters = (const Letter *)alphagram.constData();
+	if (lastGroup < 0 || groupLength(lastGroup) != (int)length || !equal(letters, letters + length, m_letters.begin() + m_groupStart[lastGroup]))
+	{
+		m_groupStart.push_back(m_groupStart.back());
+		m_groupFirstWord.push_back(m_groupFirstWord.back());
+		m_letters.insert(m_letters.end(), alphagram.begin(), alphagram.end());
+	}
+
+	m_letters.insert(m_letters.end(), word.begin(), word.end());
+	m_wordInfo.push_back(info);
+	m_groupStart.back() = (uint32_t)m_letters.size();
+	m_groupFirstWord.back() = (uint32_t)m_wordInfo.size();
+}
+
+// File layout, little-endian: version, the lexicon hash, the group
+// count, then each group's word length and word count followed by
+// its words, each as its letters and its info. Alphagrams are left
+// out as they're just a group's first word sorted.
+bool AlphagramIndex::save(const string &filename) const
+{
+	const int groupCount = (int)m_groupStart.size() - 1;
+
+	BinaryWriter writer;
+	writer.writeU8(FileVersion);
+	writer.writeString(m_lexiconHash);
+	writer.writeU32(groupCount);
+
+	for (int group = 0; group < groupCount; ++group)
+	{
+		const int length = groupLength(group);
+		const uint32_t wordCount = m_groupFirstWord[group + 1] - m_groupFirstWord[group];
+		if (wordCount > 255)
+			return false;
+
+		writer.writeU8(length);
+		writer.writeU8(wordCount);
+		for (uint32_t word = 0; word < wordCount; ++word)
+		{
+			const uint32_t start = m_groupStart[group] + (word + 1) * length;
+			for (int i = 0; i < length; ++i)
+				writer.writeU8(m_letters[start + i]);
+			writer.writeU32(m_wordInfo[m_groupFirstWord[group] + word]);
+		}
+	}
+
+	ofstream file(filename.c_str(), ios::out | ios::binary | ios::trunc);
+	file.write(writer.data().data(), writer.data().size());
+	return file.good();
+}
+
+bool AlphagramIndex::load(const string &filename, const LexiconParameters &lexicon)
+{
+	clear();
+
+	ifstream file(filename.c_str(), ios::in | ios::binary);
+	if (!file.is_open())
+		return false;
+
+	stringstream contents;
+	contents << file.rdbuf();
+	const string data = contents.str();
+
+	BinaryReader reader(data);
+	if (reader.readU8() != FileVersion || reader.readString() != lexicon.hashString(false))
+		return false;
+
+	const uint32_t groupCount = reader.readU32();
+	for (uint32_t group = 0; group < groupCount && reader.ok(); ++group)
+	{
+		const int length = reader.readU8();
+		const int wordCount = reader.readU8();
+		if (length == 0 || length > LETTER_STRING_MAXIMUM_LENGTH || wordCount == 0)
+		{
+			clear();
+			return false;
+		}
+
+		LetterString alphagram;
+		for (int word = 0; word < wordCount && reader.ok(); ++word)
+		{
+			LetterString letters;
+			for (int i = 0; i < length; ++i)
+				letters.push_back(reader.readU8());
+			if (word == 0)
+				alphagram = String::alphabetize(letters);
+			addWord(alphagram, letters, reader.readU32());
+		}
+	}
+
+	if (!reader.ok() || !reader.atEnd())
+	{
+		clear();
+		return false;
+	}
+
+	m_lexiconHash = lexicon.hashString(false);
+	buildTable();
+	return true;
+}
+
+int AlphagramIndex::groupLength(int group) const
+{
+	return (m_groupStart[group + 1] - m_groupStart[group]) / (m_groupFirstWord[group + 1] - m_groupFirstWord[group] + 1);
+}
+
+size_t AlphagramIndex::hashLetters(const Letter *letters, size_t length)
+{
+	size_t hash = 5381;
+	for (size_t i = 0; i < length; ++i)
+		hash = hash * 33 + letters[i];
+	return hash ^ (hash >> 17);
+}
+
+void AlphagramIndex::buildTable()
+{
+	const size_t groupCount = m_groupStart.size() - 1;
+	size_t size = 1024;
+	while (size < groupCount * 2)
+		size *= 2;
+
+	m_table.assign(size, 0);
+	const size_t mask = size - 1;
+	for (size_t group = 0; group < groupCount; ++group)
+	{
+		size_t slot = hashLetters(&m_letters[m_groupStart[group]], groupLength(group)) & mask;
+		while (m_table[slot] != 0)
+			slot = (slot + 1) & mask;
+		m_table[slot] = (uint32_t)group + 1;
+	}
+}
+
+int AlphagramIndex::findGroup(const LetterString &alphagram) const
+{
+	if (m_table.empty())
+		return -1;
+
+	const size_t length = alphagram.length();
+	const Letter *letters = (const Letter *)alphagram.constData();
+	const size_t mask = m_table.size() - 1;
+	for (size_t slot = hashLetters(letters, length) & mask; m_table[slot] != 0; slot = (slot + 1) & mask)
+	{
+		const int group = m_table[slot] - 1;
+		if (groupLength(group) == (int)length && equal(letters, letters + length, m_letters.begin() + m_groupStart[group]))
+			return group;
+	}
+
+	return -1;
+}
+
+vector<WordWithInfo> AlphagramIndex::anagrams(const LetterString &letters) const
+{
+	vector<WordWithInfo> ret;
+	const int group = findGroup(String::alphabetize(letters));
+	if (group < 0)
+		return ret;
+
+	const size_t length = letters.length();
+	for (uint32_t word = m_groupFirstWord[group]; word < m_groupFirstWord[group + 1]; ++word)
+	{
+		const Letter *start = &m_letters[m_groupStart[group] + (word - m_groupFirstWord[group] + 1) * length];
+
+		WordWithInfo wordWithInfo;
+		for (size_t i = 0; i < length; ++i)
+			wordWithInfo.wordLetterString.push_back(start[i]);
+		wordWithInfo.playability = m_wordInfo[word] >> 1;
+		wordWithInfo.british = m_wordInfo[word] & 1;
+		ret.push_back(wordWithInfo);
+	}
+
+	return ret;
+}
+
+WordList AlphagramIndex::words(const LetterString &letters, bool requireAll) const
+{
+	WordList ret;
+	const LetterString alphagram = String::alphabetize(letters);
+	if (requireAll)
+	{
+		const int group = findGroup(alphagram);
+		if (group >= 0)
+			appendGroup(group, ret);
+	}
+	else
+	{
+		LetterString chosen;
+		appendSubanagrams(alphagram, 0, chosen, ret);
+	}
+
+	return ret;
+}
+
+bool AlphagramIndex::canListSubanagrams(const LetterString &letters)
+{
+	// the number of picks is the product of one more than each
+	// distinct letter's count
+	const LetterString alphagram = String::alphabetize(letters);
+	size_t picks = 1;
+	size_t start = 0;
+	while (start < alphagram.length())
+	{
+		size_t end = start;
+		while (end < alphagram.length() && alphagram[end] == alphagram[start])
+			++end;
+
+		picks *= end - start + 1;
+		if (picks > maximumSubanagrams)
+			return false;
+
+		start = end;
+	}
+
+	return true;
+}
+
+void AlphagramIndex::appendGroup(int group, WordList &words) const
+{
+	const int length = groupLength(group);
+	for (uint32_t i = m_groupStart[group] + length; i < m_groupStart[group + 1]; i += length)
+	{
+		LetterString word;
+		for (int j = 0; j < length; ++j)
+			word.push_back(m_letters[i + j]);
+		words.push_back(word);
+	}
+}
+
+// chosen, a sorted pick of the letters before start, is itself an
+// alphagram; each distinct letter from start on is then taken from
+// none up to all of its copies
+void AlphagramIndex::appendSubanagrams(const LetterString &alphagram, size_t start, LetterString &chosen, WordList &words) const
+{
+	if (start == alphagram.length())
+	{
+		if (!chosen.empty())
+		{
+			const int group = findGroup(chosen);
+			if (group >= 0)
+				appendGroup(group, words);
+		}
+		return;
+	}
+
+	size_t end = start;
+	while (end < alphagram.length() && alphagram[end] == alphagram[start])
+		++end;
+
+	appendSubanagrams(alphagram, end, chosen, words);
+	for (size_t i = start; i < end; ++i)
+	{
+		chosen.push_back(alphagram[start]);
+		appendSubanagrams(alphagram, end, chosen, words);
+	}
+
+	for (size_t i = start; i < end; ++i)
+		chosen.pop_back();
+}
+
+bool AlphagramIndex::contains(const LetterString &word, WordWithInfo *info) const
+{
+	const int group = findGroup(String::alphabetize(word));
+	if (group < 0)
+		return false;
+
+	const size_t length = word.length();
+	const Letter *letters = (const Letter *)word.constData();
+	uint32_t wordNumber = m_groupFirstWord[group];
+	for (uint32_t i = m_groupStart[group] + length; i < m_groupStart[group + 1]; i += length, ++wordNumber)
+	{
+		if (equal(letters, letters + length, m_letters.begin() + i))
+		{
+			if (info)
+			{
+				info->playability = m_wordInfo[wordNumber] >> 1;
+				info->british = m_wordInfo[wordNumber] & 1;
+			}
+			return true;
+		}
+	}
+
+	return false;
+}
@@ -0,0 +1,111 @@
+/*
+ *  Quackle -- Crossword game artificial intelligence and analysis tool
+ *  Copyright (C) 2005-2019 Jason Katz-Brown, John O'Laughlin, and John Fultz.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QUACKLE_ALPHAGRAMINDEX_H
+#define QUACKLE_ALPHAGRAMINDEX_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "alphabetparameters.h"
+#include "generator.h"
+
+namespace Quackle
+{
+
+class LexiconParameters;
+
+// Maps alphagrams, a word's letters in sorted order, to the words
+// they spell, so exact anagrams are one hash lookup instead of a
+// walk of the lexicon. Each alphagram is stored once followed by its
+// words, all as plain letters in one array.
+//
+// Building walks the whole dawg, so a lexicon's index is usually
+// built once and saved next to the dawg as <lexicon>.alphagrams.
+class AlphagramIndex
+{
+public:
+	AlphagramIndex();
+
+	// indexes every word of the lexicon's dawg
+	void build(const LexiconParameters &lexicon);
+	void clear();
+
+	// Saves the index in a compact form that leaves out the
+	// alphagrams. Returns false if the file can't be written.
+	bool save(const string &filename) const;
+
+	// Loads what save wrote, if it was built from the same dawg as
+	// lexicon's. Returns false and leaves the index empty otherwise.
+	bool load(const string &filename, const LexiconParameters &lexicon);
+
+	bool isEmpty() const { return wordCount() == 0; };
+	int wordCount() const { return (int)m_wordInfo.size(); };
+
+	// The words spelled by exactly letters, alphabetically, with their
+	// playability and britishness. Letters mustn't include blanks.
+	vector<WordWithInfo> anagrams(const LetterString &letters) const;
+
+	// The words spelled by all of letters or, if not requireAll, by
+	// any of them, grouped by alphagram. Letters mustn't include
+	// blanks.
+	WordList words(const LetterString &letters, bool requireAll) const;
+
+	// Whether words(letters, false) is quick. It looks up every pick
+	// of the letters, a number that grows exponentially with their
+	// count, so for long strings a walk of the lexicon is faster.
+	static bool canListSubanagrams(const LetterString &letters);
+
+	// whether word is in the index; if so and info isn't null, its
+	// playability and britishness are stored in info
+	bool contains(const LetterString &word, WordWithInfo *info = 0) const;
+
+private:
+	// the most picks canListSubanagrams allows
+	static const size_t maximumSubanagrams = 4096;
+
+	// the group of words for alphagram, or -1
+	int findGroup(const LetterString &alphagram) const;
+	static size_t hashLetters(const Letter *letters, size_t length);
+	void buildTable();
+	void addWord(const LetterString &alphagram, const LetterString &word, uint32_t info);
+	int groupLength(int group) const;
+	void appendGroup(int group, WordList &words) const;
+	void appendSubanagrams(const LetterString &alphagram, size_t start, LetterString &chosen, WordList &words) const;
+
+	// group n is its alphagram then its words, from m_groupStart[n]
+	// up to m_groupStart[n + 1]
+	vector<Letter> m_letters;
+	vector<uint32_t> m_groupStart;
+
+	// group n's words are numbered from m_groupFirstWord[n]; a word's
+	// info is its playability shifted left one, or'd with britishness
+	vector<uint32_t> m_groupFirstWord;
+	vector<uint32_t> m_wordInfo;
+
+	// open addressing on the alphagram, holding group + 1
+	vector<uint32_t> m_table;
+
+	// of the dawg the index was built from
+	string m_lexiconHash;
+};
+
+}
+
+#endif
@@ -0,0 +1,503 @@
+/*
+ *  Quackle -- Crossword game artificial intelligence and analysis tool
+ *  Copyright (C) 2005-2019 Jason Katz-Brown, John O'Laughlin, and John Fultz.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstring>
+#include <fstream>
+#include <typeinfo>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "analysiscache.h"
+#include "binaryio.h"
+#include "boardparameters.h"
+#include "datamanager.h"
+#include "evaluator.h"
+#include "game.h"
+#include "gameparameters.h"
+#include "lexiconparameters.h"
+#include "strategyparameters.h"
+
+using namespace Quackle;
+
+namespace
+{
+
+const char cacheMagic[] = "QKLCACHE";
+const uint32_t cacheVersion = 2;
+const size_t cacheHeaderSize = 8 + 4;
+
+// each record is a marker, a 64-bit key, a 32-bit payload length and
+// a checksum of the key and payload, then the payload; the marker is
+// what we look for to find the next record after a damaged one
+const uint32_t recordMarker = 0x4345524B;
+const size_t recordHeaderSize = 4 + 8 + 4 + 8;
+
+// FNV-1a, which is plenty for keying analysis
+class Hasher
+{
+public:
+	Hasher() : m_hash(14695981039346656037ULL) {}
+
+	void add(const void *data, size_t length)
+	{
+		const unsigned char *bytes = static_cast<const unsigned char *>(data);
+		for (size_t i = 0; i < length; ++i)
+		{
+			m_hash ^= bytes[i];
+			m_hash *= 1099511628211ULL;
+		}
+	}
+
+	void add(int value)
+	{
+		int32_t fixed = value;
+		add(&fixed, sizeof(fixed));
+	}
+
+	void add(uint64_t value) { add(&value, sizeof(value)); }
+	void add(const string &value) { add(value.data(), value.size()); }
+	void add(const LetterString &value) { add((int)value.length()); add(value.begin(), value.length()); }
+
+	uint64_t hash() const { return m_hash; }
+
+private:
+	uint64_t m_hash;
+};
+
+uint64_t recordChecksum(uint64_t key, const char *payload, size_t length)
+{
+	Hasher hasher;
+	hasher.add(key);
+	hasher.add(payload, length);
+	return hasher.hash();
+}
+
+}
+
+AnalysisCache::AnalysisCache()
+	: m_data(0), m_size(0), m_indexedSize(0)
+{
+}
+
+AnalysisCache::~AnalysisCache()
+{
+	close();
+}
+
+bool AnalysisCache::open(const string &filename)
+{
+	lock_guard<mutex> lock(m_mutex);
+
+	unmapFile();
+	m_entries.clear();
+	m_indexedSize = 0;
+	m_filename = filename;
+
+	{
+		ifstream file(filename.c_str(), ios::in | ios::binary);
+		if (!file.good() || file.peek() == ifstream::traits_type::eof())
+		{
+			file.close();
+
+			BinaryWriter header;
+			for (int i = 0; i < 8; ++i)
+				header.writeU8(cacheMagic[i]);
+			header.writeU32(cacheVersion);
+
+			ofstream out(filename.c_str(), ios::out | ios::binary | ios::trunc);
+			out.write(header.data().data(), header.data().size());
+			if (!out.good())
+			{
+				m_filename.clear();
+				return false;
+			}
+		}
+	}
+
+	if (!mapFile() || m_size < cacheHeaderSize || memcmp(m_data, cacheMagic, 8) != 0)
+	{
+		unmapFile();
+		m_filename.clear();
+		return false;
+	}
+
+	BinaryReader version(m_data + 8, 4);
+	if (version.readU32() != cacheVersion)
+	{
+		unmapFile();
+		m_filename.clear();
+		return false;
+	}
+
+	m_indexedSize = cacheHeaderSize;
+	index();
+	return true;
+}
+
+void AnalysisCache::close()
+{
+	lock_guard<mutex> lock(m_mutex);
+
+	unmapFile();
+	m_entries.clear();
+	m_indexedSize = 0;
+	m_filename.clear();
+}
+
+bool AnalysisCache::isOpen() const
+{
+	lock_guard<mutex> lock(m_mutex);
+	return !m_filename.empty();
+}
+
+size_t AnalysisCache::size() const
+{
+	lock_guard<mutex> lock(m_mutex);
+	return m_entries.size();
+}
+
+uint64_t AnalysisCache::positionHash(const GamePosition &position)
+{
+	Hasher hasher;
+
+	const Board &board = position.board();
+	hasher.add(board.width());
+	hasher.add(board.height());
+	for (int row = 0; row < board.height(); ++row)
+	{
+		for (int col = 0; col < board.width(); ++col)
+		{
+			hasher.add((int)board.letter(row, col));
+			hasher.add((int)board.isBlank(row, col));
+			hasher.add(QUACKLE_BOARD_PARAMETERS->letterMultiplier(row, col));
+			hasher.add(QUACKLE_BOARD_PARAMETERS->wordMultiplier(row, col));
+		}
+	}
+
+	hasher.add(String::alphabetize(position.currentPlayer().rack().tiles()));
+
+	char counts[QUACKLE_FIRST_LETTER + QUACKLE_MAXIMUM_ALPHABET_SIZE];
+	position.unseenBag().letterCounts(counts);
+	hasher.add(counts, sizeof(counts));
+	hasher.add(position.bag().size());
+
+	// scores starting with the player on turn
+	const PlayerList &players = position.players();
+	hasher.add((int)players.size());
+	hasher.add(position.currentPlayer().score());
+	for (const auto &it : players)
+		if (it.id() != position.currentPlayer().id())
+			hasher.add(it.score());
+
+	hasher.add(position.scorelessTurnsInARow());
+
+	return hasher.hash();
+}
+
+uint64_t AnalysisCache::key(const GamePosition &position, EntryType type, uint64_t detail) const
+{
+	Hasher hasher;
+	hasher.add(positionHash(position));
+	hasher.add(QUACKLE_LEXICON_PARAMETERS->hashString(false));
+
+	const AlphabetParameters *alphabet = QUACKLE_ALPHABET_PARAMETERS;
+	hasher.add(alphabet->alphabetName());
+	for (Letter letter = QUACKLE_BLANK_MARK; letter <= alphabet->lastLetter(); ++letter)
+	{
+		hasher.add(alphabet->score(letter));
+		hasher.add(alphabet->count(letter));
+	}
+
+	hasher.add(QUACKLE_BOARD_PARAMETERS->startRow());
+	hasher.add(QUACKLE_BOARD_PARAMETERS->startColumn());
+	hasher.add(QUACKLE_PARAMETERS->rackSize());
+	hasher.add(QUACKLE_PARAMETERS->bingoBonus());
+
+	hasher.add(QUACKLE_STRATEGY_PARAMETERS->hash());
+	if (QUACKLE_EVALUATOR)
+		hasher.add(string(typeid(*QUACKLE_EVALUATOR).name()));
+
+	hasher.add((int)type);
+	hasher.add(detail);
+	return hasher.hash();
+}
+
+uint64_t AnalysisCache::simulationDetail(int plies, const Rack &partialOppoRack, const ProbableRackList &inferredOppoLeaves)
+{
+	Hasher detail;
+	detail.add(plies);
+	detail.add(String::alphabetize(partialOppoRack.tiles()));
+
+	// inferred leaves only matter to sims without known oppo tiles
+	if (partialOppoRack.empty())
+	{
+		detail.add((int)inferredOppoLeaves.size());
+		for (const auto &it : inferredOppoLeaves)
+		{
+			detail.add(String::alphabetize(it.rack.tiles()));
+			detail.add(&it.probability, sizeof(it.probability));
+		}
+	}
+
+	return detail.hash();
+}
+
+bool AnalysisCache::findKibitz(const GamePosition &position, unsigned int nmoves, MoveList *moves)
+{
+	string payload;
+	if (!find(key(position, KibitzEntry, 0), &payload))
+		return false;
+
+	BinaryReader reader(payload);
+	const unsigned int storedMoves = reader.readU32();
+	if (storedMoves < nmoves)
+		return false;
+
+	MoveList ret;
+	const unsigned int count = reader.readU32();
+	for (unsigned int i = 0; i < count && reader.ok(); ++i)
+		ret.push_back(reader.readMove());
+
+	if (!reader.ok())
+		return false;
+
+	if (ret.size() > nmoves)
+		ret.resize(nmoves);
+
+	*moves = ret;
+	return true;
+}
+
+void AnalysisCache::storeKibitz(const GamePosition &position, unsigned int nmoves, const MoveList &moves)
+{
+	BinaryWriter writer;
+	writer.writeU32(nmoves);
+	writer.writeU32(moves.size());
+	for (const auto &it : moves)
+		writer.writeMove(it);
+
+	store(key(position, KibitzEntry, 0), writer.data());
+}
+
+bool AnalysisCache::findSimulation(const GamePosition &position, int plies, const Rack &partialOppoRack, const ProbableRackList &inferredOppoLeaves, string *state)
+{
+	return find(key(position, SimulationEntry, simulationDetail(plies, partialOppoRack, inferredOppoLeaves)), state);
+}
+
+void AnalysisCache::storeSimulation(const GamePosition &position, int plies, const Rack &partialOppoRack, const ProbableRackList &inferredOppoLeaves, const string &state)
+{
+	store(key(position, SimulationEntry, simulationDetail(plies, partialOppoRack, inferredOppoLeaves)), state);
+}
+
+bool AnalysisCache::findEndgame(const GamePosition &position, Move *solution)
+{
+	string payload;
+	if (!find(key(position, EndgameEntry, 0), &payload))
+		return false;
+
+	BinaryReader reader(payload);
+	Move move = reader.readMove();
+	if (!reader.ok())
+		return false;
+
+	*solution = move;
+	return true;
+}
+
+void AnalysisCache::storeEndgame(const GamePosition &position, const Move &solution)
+{
+	BinaryWriter writer;
+	writer.writeMove(solution);
+	store(key(position, EndgameEntry, 0), writer.data());
+}
+
+bool AnalysisCache::find(uint64_t key, string *payload)
+{
+	lock_guard<mutex> lock(m_mutex);
+
+	const auto it = m_entries.find(key);
+	if (it == m_entries.end())
+		return false;
+
+	payload->assign(m_data + it->second.offset, it->second.length);
+	return true;
+}
+
+void AnalysisCache::store(uint64_t key, const string &payload)
+{
+	lock_guard<mutex> lock(m_mutex);
+
+	if (m_filename.empty())
+		return;
+
+	BinaryWriter record;
+	record.writeU32(recordMarker);
+	record.writeU64(key);
+	record.writeU32(payload.size());
+	record.writeU64(recordChecksum(key, payload.data(), payload.size()));
+	const string data = record.data() + payload;
+
+#ifdef _WIN32
+	{
+		ofstream out(m_filename.c_str(), ios::out | ios::binary | ios::app);
+		out.write(data.data(), data.size());
+		if (!out.good())
+			return;
+	}
+#else
+	{
+		// a single append so other processes appending to the same
+		// file don't interleave with us; if it comes up short, the
+		// checksum makes readers skip what did get written
+		const int fd = ::open(m_filename.c_str(), O_WRONLY | O_APPEND);
+		if (fd < 0)
+			return;
+
+		const ssize_t written = ::write(fd, data.data(), data.size());
+		::close(fd);
+		if (written != (ssize_t)data.size())
+			return;
+	}
+#endif
+
+	// pick up our record along with anything anyone else appended
+	unmapFile();
+	if (mapFile())
+		index();
+}
+
+bool AnalysisCache::mapFile()
+{
+#ifdef _WIN32
+	ifstream file(m_filename.c_str(), ios::in | ios::binary);
+	if (!file.good())
+		return false;
+
+	m_buffer.assign(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+	m_data = m_buffer.data();
+	m_size = m_buffer.size();
+	return true;
+#else
+	const int fd = ::open(m_filename.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	struct stat buf;
+	if (fstat(fd, &buf) != 0 || buf.st_size == 0)
+	{
+		::close(fd);
+		return false;
+	}
+
+	void *data = mmap(0, buf.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	::close(fd);
+
+	if (data == MAP_FAILED)
+		return false;
+
+	m_data = static_cast<const char *>(data);
+	m_size = buf.st_size;
+	return true;
+#endif
+}
+
+void AnalysisCache::unmapFile()
+{
+#ifdef _WIN32
+	m_buffer.clear();
+#else
+	if (m_data)
+		munmap(const_cast<char *>(m_data), m_size);
+#endif
+
+	m_data = 0;
+	m_size = 0;
+}
+
+void AnalysisCache::index()
+{
+	size_t offset = m_indexedSize;
+	while (offset + recordHeaderSize <= m_size)
+	{
+		if (!recordIsIntact(offset))
+		{
+			// Either cut short by a crash, in which case later records
+			// follow it, or still being appended, in which case we'll
+			// look again next time.
+			const size_t next = findRecord(offset + 1);
+			if (next == 0)
+				break;
+
+			offset = next;
+		}
+
+		BinaryReader reader(m_data + offset + 4, recordHeaderSize - 4);
+		const uint64_t key = reader.readU64();
+		const size_t length = reader.readU32();
+
+		m_entries[key] = Entry{offset + recordHeaderSize, length};
+		offset += recordHeaderSize + length;
+	}
+
+	m_indexedSize = offset;
+}
+
+bool AnalysisCache::recordIsIntact(size_t offset) const
+{
+	if (offset + recordHeaderSize > m_size)
+		return false;
+
+	BinaryReader reader(m_data + offset, recordHeaderSize);
+	if (reader.readU32() != recordMarker)
+		return false;
+
+	const uint64_t key = reader.readU64();
+	const size_t length = reader.readU32();
+	const uint64_t checksum = reader.readU64();
+	if (length > m_size - offset - recordHeaderSize)
+		return false;
+
+	return recordChecksum(key, m_data + offset + recordHeaderSize, length) == checksum;
+}
+
+size_t AnalysisCache::findRecord(size_t offset) const
+{
+	char marker[4];
+	for (int i = 0; i < 4; ++i)
+		marker[i] = (recordMarker >> (8 * i)) & 0xFF;
+
+	while (offset + recordHeaderSize <= m_size)
+	{
+		const char *found = static_cast<const char *>(memchr(m_data + offset, marker[0], m_size - offset));
+		if (!found)
+			return 0;
+
+		offset = found - m_data;
+		if (offset + recordHeaderSize <= m_size && memcmp(found, marker, 4) == 0 && recordIsIntact(offset))
+			return offset;
+
+		++offset;
+	}
+
+	return 0;
+}
@@ -0,0 +1,115 @@
+/*
+ *  Quackle -- Crossword game artificial intelligence and analysis tool
+ *  Copyright (C) 2005-2019 Jason Katz-Brown, John O'Laughlin, and John Fultz.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QUACKLE_ANALYSISCACHE_H
+#define QUACKLE_ANALYSISCACHE_H
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "enumerator.h"
+#include "move.h"
+#include "rack.h"
+
+using namespace std;
+
+namespace Quackle
+{
+
+class GamePosition;
+
+// Remembers analysis of positions across runs in a single append-only
+// file that is memory-mapped for reading. Entries are keyed by a hash
+// of everything about the position the analysis depends on together
+// with the loaded lexicon, alphabet, strategy and game rules. When an
+// entry is stored twice the later one wins, so the file only ever
+// grows; delete it to start over. Records carry a checksum, so ones
+// cut short by a crash are skipped. Safe to use from several threads
+// and, where appends are atomic, several processes.
+class AnalysisCache
+{
+public:
+	AnalysisCache();
+	~AnalysisCache();
+
+	// Opens the cache at filename, creating it if need be. Returns
+	// false if the file can't be opened or isn't an analysis cache.
+	bool open(const string &filename);
+	void close();
+	bool isOpen() const;
+
+	// number of entries that can be looked up
+	size_t size() const;
+
+	// Hash of the board, its bonus squares, the current player's
+	// rack, the unseen tiles, and the scores. Turn numbers and player
+	// names don't matter, so transposed positions hash alike.
+	static uint64_t positionHash(const GamePosition &position);
+
+	// kibitz list of at least nmoves moves, truncated to nmoves
+	bool findKibitz(const GamePosition &position, unsigned int nmoves, MoveList *moves);
+	void storeKibitz(const GamePosition &position, unsigned int nmoves, const MoveList &moves);
+
+	// Simulation state, as from Simulator::serializeState(), for a
+	// number of plies, so a simulation can be picked up where it left
+	// off. Sims with different known or inferred oppo tiles are kept
+	// apart.
+	bool findSimulation(const GamePosition &position, int plies, const Rack &partialOppoRack, const ProbableRackList &inferredOppoLeaves, string *state);
+	void storeSimulation(const GamePosition &position, int plies, const Rack &partialOppoRack, const ProbableRackList &inferredOppoLeaves, const string &state);
+
+	// solved endgame
+	bool findEndgame(const GamePosition &position, Move *solution);
+	void storeEndgame(const GamePosition &position, const Move &solution);
+
+	enum EntryType { KibitzEntry = 1, SimulationEntry = 2, EndgameEntry = 3 };
+
+private:
+	struct Entry
+	{
+		size_t offset;
+		size_t length;
+	};
+
+	uint64_t key(const GamePosition &position, EntryType type, uint64_t detail) const;
+	static uint64_t simulationDetail(int plies, const Rack &partialOppoRack, const ProbableRackList &inferredOppoLeaves);
+	bool find(uint64_t key, string *payload);
+	void store(uint64_t key, const string &payload);
+
+	bool mapFile();
+	void unmapFile();
+	void index();
+
+	// offset of the first intact record at or after offset, or 0
+	size_t findRecord(size_t offset) const;
+	bool recordIsIntact(size_t offset) const;
+
+	string m_filename;
+	const char *m_data;
+	size_t m_size;
+	size_t m_indexedSize;
+	string m_buffer;
+
+	unordered_map<uint64_t, Entry> m_entries;
+	mutable mutex m_mutex;
+};
+
+}
+
+#endif
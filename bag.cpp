@@ -17,6 +17,7 @@
  */
 
 #include <algorithm>
+#include <cstring>
 #include <iostream>
 
 #include "alphabetparameters.h"
@@ -36,23 +37,27 @@ Bag::Bag()
 
 Bag::Bag(const LetterString &contents)
 {
+	clear();
 	toss(contents);
 }
 
 void Bag::clear()
 {
-	m_tiles.clear();
+	memset(m_counts, 0, sizeof(m_counts));
+	m_size = 0;
 }
 
 void Bag::prepareFullBag()
 {
 	// put stuff in here to fill the bag
-	m_tiles.clear();
+	clear();
 
 	// we start at 0 because we want to include blanks etcetera
 	for (Letter letter = 0; letter <= QUACKLE_ALPHABET_PARAMETERS->lastLetter(); ++letter)
-		for (int i = 0; i < QUACKLE_ALPHABET_PARAMETERS->count(letter); ++i)
-			m_tiles.push_back(letter);
+	{
+		m_counts[letter] = QUACKLE_ALPHABET_PARAMETERS->count(letter);
+		m_size += m_counts[letter];
+	}
 }
 
 int Bag::fullBagTileCount()
@@ -68,26 +73,14 @@ void Bag::toss(const LetterString &letters)
 {
 	const LetterString::const_iterator end(letters.end());
 	for (LetterString::const_iterator it = letters.begin(); it != end; ++it)
-		m_tiles.push_back(*it);
+		add(*it);
 }
 
 void Bag::toss(const LongLetterString &letters)
 {
 	const LongLetterString::const_iterator end(letters.end());
 	for (LongLetterString::const_iterator it = letters.begin(); it != end; ++it)
-		m_tiles.push_back(*it);
-}
-
-Letter Bag::erase(int pos)
-{
-	LongLetterString::iterator it = m_tiles.begin();
-
-	for (int i = 0; i < pos; ++it, ++i) ;
-
-	Letter ret = *it;
-	m_tiles.erase(it);
-
-	return ret;
+		add(*it);
 }
 
 void Bag::exch(const Move &move, Rack &rack)
@@ -101,7 +94,16 @@ void Bag::exch(const Move &move, Rack &rack)
 
 Letter Bag::pluck()
 {
-	return erase(DataManager::self()->randomInteger(0, (int)m_tiles.size() - 1));
+	// each tile is equally likely, so each letter by its count
+	int pick = DataManager::self()->randomInteger(0, m_size - 1);
+
+	Letter letter = 0;
+	while (pick >= m_counts[letter])
+		pick -= m_counts[letter++];
+
+	--m_counts[letter];
+	--m_size;
+	return letter;
 }
 
 bool Bag::removeLetters(const LetterString &letters)
@@ -130,53 +132,61 @@ bool Bag::removeLetters(const LongLetterString &letters)
 
 void Bag::letterCounts(char *countsArray) const
 {
-	String::counts(m_tiles, countsArray);
+	for (int letter = 0; letter < letterSlots; ++letter)
+		countsArray[letter] = m_counts[letter];
 }
 
-bool Bag::removeLetter(Letter letter)
+LongLetterString Bag::tiles() const
 {
-	LongLetterString::iterator it;
-	const LongLetterString::iterator end(m_tiles.end());
-	for (it = m_tiles.begin(); it != end; ++it)
-		if (*it == letter)
-			break;
+	LongLetterString ret;
+	ret.reserve(m_size);
 
-	if (it == m_tiles.end())
-		return false;
+	for (int letter = 0; letter < letterSlots; ++letter)
+		ret.append(m_counts[letter], static_cast<char>(letter));
 
-	m_tiles.erase(it);
-	return true;
+	return ret;
 }
 
 void Bag::refill(Rack &rack)
 {
-	for (int number = QUACKLE_PARAMETERS->rackSize() - rack.tiles().length(); number > 0 && !m_tiles.empty(); --number)
-		rack.setTiles(String::alphabetize(rack.tiles() + pluck()));
+	LetterString tiles(rack.tiles());
+	for (int number = QUACKLE_PARAMETERS->rackSize() - tiles.length(); number > 0 && !empty(); --number)
+		tiles += pluck();
+
+	if (tiles.length() != rack.tiles().length())
+		rack.setTiles(String::alphabetize(tiles));
 }
 
 LetterString Bag::refill(Rack &rack, const LetterString &drawingOrder)
 {
 	LetterString ret(drawingOrder);
+	LetterString tiles(rack.tiles());
 
-	for (int number = QUACKLE_PARAMETERS->rackSize() - rack.tiles().length(); number > 0 && !m_tiles.empty(); --number)
+	for (int number = QUACKLE_PARAMETERS->rackSize() - tiles.length(); number > 0 && !empty(); --number)
 	{
 		if (drawingOrder.empty())
-			rack.setTiles(String::alphabetize(rack.tiles() + pluck()));
+			tiles += pluck();
 		else
 		{
 			removeLetter(String::back(ret));
-			rack.setTiles(String::alphabetize(rack.tiles() + String::back(ret)));
+			tiles += String::back(ret);
 			String::pop_back(ret);
 		}
 	}
 
+	if (tiles.length() != rack.tiles().length())
+		rack.setTiles(String::alphabetize(tiles));
 	return ret;
 }
 
 LongLetterString Bag::shuffledTiles() const
 {
-	LongLetterString ret(m_tiles);
-	random_shuffle(ret.begin(), ret.end());
+	LongLetterString ret(tiles());
+
+	// drawn from the data manager, as pluck is, so a thread's
+	// RandomNumberScope decides the order
+	for (int i = (int)ret.length() - 1; i > 0; --i)
+		iter_swap(ret.begin() + i, ret.begin() + DataManager::self()->randomInteger(0, i));
 	return ret;
 }
 
@@ -191,51 +201,22 @@ LetterString Bag::someShuffledTiles() const
 	return ret;
 }
 
-int factorial(int n)
+double Bag::choose(int n, int r)
 {
-	if (n < 0)
+	// don't worry about blanks yet
+	if (r < 0 || r > n)
 		return 0;
 
-	switch (n)
-	{
-	case 0:
-	case 1:
-		return 1;
-	case 2:
-		return 2;
-	case 3:
-		return 6;
-	case 4:
-		return 24;
-	case 5:
-		return 120;
-	case 6:
-		return 720;
-	case 7:
-		return 5040;
-	case 8:
-		return 40320;
-	case 9:
-		return 362880;
-	case 10:
-		return 3628800;
-	case 11:
-		return 39916800;
-	case 12:
-		return 479001600;
-	
-	default:
-		return factorial(n - 1) * n;
-	}
-}
+	if (r > n - r)
+		r = n - r;
 
-int nCr(int n, int r)
-{
-	// don't worry about blanks yet
-	if (r > n)
-		return 0;
+	// the running product is always an integer, so this is exact
+	// for any bag we are going to see
+	double ret = 1;
+	for (int i = 1; i <= r; ++i)
+		ret = ret * (n - r + i) / i;
 
-	return factorial(n) / (factorial(r) * factorial(n - r));
+	return ret;
 }
 
 double Bag::probabilityOfDrawingFromFullBag(const LetterString &letters)
@@ -243,11 +224,11 @@ double Bag::probabilityOfDrawingFromFullBag(const LetterString &letters)
 	char counts[QUACKLE_FIRST_LETTER + QUACKLE_MAXIMUM_ALPHABET_SIZE];
 	String::counts(String::clearBlankness(letters), counts);
 
-	float ret = 1;
+	double ret = 1;
 
 	for (Letter letter = 0; letter <= QUACKLE_ALPHABET_PARAMETERS->lastLetter(); ++letter)
 		if (counts[(int)letter] > 0)
-			ret *= nCr(QUACKLE_ALPHABET_PARAMETERS->count(letter), counts[(int)letter]);
+			ret *= choose(QUACKLE_ALPHABET_PARAMETERS->count(letter), counts[(int)letter]);
 
 	return ret;
 }
@@ -255,16 +236,16 @@ double Bag::probabilityOfDrawingFromFullBag(const LetterString &letters)
 double Bag::probabilityOfDrawingFromBag(const LetterString &letters, const Bag &bag)
 {
 	char bagCounts[QUACKLE_FIRST_LETTER + QUACKLE_MAXIMUM_ALPHABET_SIZE];
-	String::counts(bag.tiles(), bagCounts);
+	bag.letterCounts(bagCounts);
 
 	char counts[QUACKLE_FIRST_LETTER + QUACKLE_MAXIMUM_ALPHABET_SIZE];
 	String::counts(String::clearBlankness(letters), counts);
 
-	float ret = 1;
+	double ret = 1;
 
 	for (Letter letter = 0; letter < QUACKLE_FIRST_LETTER + QUACKLE_MAXIMUM_ALPHABET_SIZE; ++letter)
 		if (counts[(int)letter] > 0)
-			ret *= nCr(bagCounts[(int)letter], counts[(int)letter]);
+			ret *= choose(bagCounts[(int)letter], counts[(int)letter]);
 
 	return ret;
 }
@@ -279,8 +260,7 @@ UVString Bag::toString() const
 {
 	UVString ret;
 
-	LongLetterString sortedLetters = m_tiles;
-	sort(sortedLetters.begin(), sortedLetters.end());
+	const LongLetterString sortedLetters = tiles();
 
 	const LongLetterString::const_iterator end(sortedLetters.end());
 	for (LongLetterString::const_iterator it = sortedLetters.begin(); it != end; ++it)
@@ -54,6 +54,9 @@ public:
 	// how many of each letter are in the bag
 	void letterCounts(char *countsArray) const;
 
+	// how many of letter are in the bag
+	int count(Letter letter) const;
+
 	// put letters back in the bag
 	void toss(const LetterString &letters);
 	void toss(const LongLetterString &letters);
@@ -81,7 +84,8 @@ public:
 	// returns number of tiles left in the bag
 	int size() const;
 
-	const LongLetterString &tiles() const;
+	// our tiles in alphabetical order
+	LongLetterString tiles() const;
 	
 	// returns our tiles in a random order
 	LongLetterString shuffledTiles() const;
@@ -94,15 +98,53 @@ public:
 	static double probabilityOfDrawingFromBag(const LetterString &letters, const Bag &bag);
 	double probabilityOfDrawing(const LetterString &letters);
 
+	// number of ways to pick r of n tiles, computed exactly in
+	// double precision so large bags don't overflow
+	static double choose(int n, int r);
+
 	UVString toString() const;
 
 private:
-	// remove letter from the bag
-	Letter erase(int pos);
+	enum { letterSlots = QUACKLE_FIRST_LETTER + QUACKLE_MAXIMUM_ALPHABET_SIZE };
+
+	// a designated blank goes in the bag as a blank
+	static int slot(Letter letter);
 
-	LongLetterString m_tiles;
+	void add(Letter letter);
+
+	// The bag is kept as how many of each letter it has, so copying
+	// it is cheap and taking out a tile doesn't shift the rest.
+	unsigned char m_counts[letterSlots];
+	int m_size;
 };
 
+inline int Bag::slot(Letter letter)
+{
+	return letter < letterSlots? letter : QUACKLE_BLANK_MARK;
+}
+
+inline void Bag::add(Letter letter)
+{
+	++m_counts[slot(letter)];
+	++m_size;
+}
+
+inline bool Bag::removeLetter(Letter letter)
+{
+	unsigned char &count = m_counts[slot(letter)];
+	if (count == 0)
+		return false;
+
+	--count;
+	--m_size;
+	return true;
+}
+
+inline int Bag::count(Letter letter) const
+{
+	return m_counts[slot(letter)];
+}
+
 inline void Bag::toss(const Rack &rack)
 {
 	toss(rack.tiles());
@@ -110,17 +152,12 @@ inline void Bag::toss(const Rack &rack)
 
 inline bool Bag::empty() const
 {
-    return m_tiles.empty();
+    return m_size == 0;
 }
 
 inline int Bag::size() const
 {
-    return (int)m_tiles.size();
-}
-
-inline const LongLetterString &Bag::tiles() const
-{
-	return m_tiles;
+    return m_size;
 }
 
 }
@@ -0,0 +1,184 @@
+/*
+ *  Quackle -- Crossword game artificial intelligence and analysis tool
+ *  Copyright (C) 2005-2019 Jason Katz-Brown, John O'Laughlin, and John Fultz.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cstring>
+
+#include "binaryio.h"
+
+using namespace Quackle;
+
+void BinaryWriter::writeU8(uint8_t value)
+{
+	m_data.push_back((char)value);
+}
+
+void BinaryWriter::writeU32(uint32_t value)
+{
+	for (int i = 0; i < 4; ++i)
+		writeU8((value >> (8 * i)) & 0xFF);
+}
+
+void BinaryWriter::writeU64(uint64_t value)
+{
+	for (int i = 0; i < 8; ++i)
+		writeU8((value >> (8 * i)) & 0xFF);
+}
+
+void BinaryWriter::writeI32(int value)
+{
+	writeU32((uint32_t)value);
+}
+
+void BinaryWriter::writeDouble(double value)
+{
+	uint64_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	writeU64(bits);
+}
+
+void BinaryWriter::writeLetters(const LetterString &letters)
+{
+	writeU8(letters.length());
+	m_data.append(letters.begin(), letters.length());
+}
+
+void BinaryWriter::writeString(const string &value)
+{
+	writeU32(value.size());
+	m_data += value;
+}
+
+void BinaryWriter::writeMove(const Move &move)
+{
+	writeU8(move.action);
+	writeU8(move.horizontal);
+	writeI32(move.startrow);
+	writeI32(move.startcol);
+	writeI32(move.score);
+	writeU8(move.isBingo);
+	writeDouble(move.equity);
+	writeDouble(move.win);
+	writeDouble(move.possibleWin);
+	writeLetters(move.tiles());
+	writeLetters(move.prettyTiles());
+	writeU8(move.isChallengedPhoney());
+	writeI32(move.scoreAddition());
+}
+
+BinaryReader::BinaryReader(const string &data)
+	: m_at(data.data()), m_end(data.data() + data.size()), m_ok(true)
+{
+}
+
+BinaryReader::BinaryReader(const char *data, size_t length)
+	: m_at(data), m_end(data + length), m_ok(true)
+{
+}
+
+uint8_t BinaryReader::readU8()
+{
+	if (m_at >= m_end)
+	{
+		m_ok = false;
+		return 0;
+	}
+
+	return (uint8_t)*m_at++;
+}
+
+uint32_t BinaryReader::readU32()
+{
+	uint32_t ret = 0;
+	for (int i = 0; i < 4; ++i)
+		ret |= (uint32_t)readU8() << (8 * i);
+	return ret;
+}
+
+uint64_t BinaryReader::readU64()
+{
+	uint64_t ret = 0;
+	for (int i = 0; i < 8; ++i)
+		ret |= (uint64_t)readU8() << (8 * i);
+	return ret;
+}
+
+int BinaryReader::readI32()
+{
+	return (int32_t)readU32();
+}
+
+double BinaryReader::readDouble()
+{
+	const uint64_t bits = readU64();
+	double ret;
+	memcpy(&ret, &bits, sizeof(ret));
+	return ret;
+}
+
+LetterString BinaryReader::readLetters()
+{
+	LetterString ret;
+	const unsigned int length = readU8();
+
+	// more than a LetterString holds can only be a corrupt record
+	if (length > LetterString::maxSize - 1)
+	{
+		m_ok = false;
+		m_at += min((size_t)length, (size_t)(m_end - m_at));
+		return ret;
+	}
+
+	for (unsigned int i = 0; i < length && m_ok; ++i)
+		ret.push_back(readU8());
+	return ret;
+}
+
+string BinaryReader::readString()
+{
+	const size_t length = readU32();
+	if ((size_t)(m_end - m_at) < length)
+	{
+		m_ok = false;
+		m_at = m_end;
+		return string();
+	}
+
+	string ret(m_at, length);
+	m_at += length;
+	return ret;
+}
+
+Move BinaryReader::readMove()
+{
+	Move move;
+	move.action = (Move::Action)readU8();
+	move.horizontal = readU8();
+	move.startrow = readI32();
+	move.startcol = readI32();
+	move.score = readI32();
+	move.isBingo = readU8();
+	move.equity = readDouble();
+	move.win = readDouble();
+	move.possibleWin = readDouble();
+	move.setTiles(readLetters());
+	move.setPrettyTiles(readLetters());
+	move.setIsChallengedPhoney(readU8());
+	move.setScoreAddition(readI32());
+	return move;
+}
@@ -0,0 +1,102 @@
+/*
+ *  Quackle -- Crossword game artificial intelligence and analysis tool
+ *  Copyright (C) 2005-2019 Jason Katz-Brown, John O'Laughlin, and John Fultz.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QUACKLE_BINARYIO_H
+#define QUACKLE_BINARYIO_H
+
+#include <cstdint>
+#include <string>
+
+#include "move.h"
+
+using namespace std;
+
+namespace Quackle
+{
+
+// Builds up the compact little-endian encoding we use for analysis
+// that is saved to disk or handed to another process.
+class BinaryWriter
+{
+public:
+	void writeU8(uint8_t value);
+	void writeU32(uint32_t value);
+	void writeU64(uint64_t value);
+	void writeI32(int value);
+	void writeDouble(double value);
+
+	// length-prefixed
+	void writeLetters(const LetterString &letters);
+	void writeString(const string &value);
+
+	void writeMove(const Move &move);
+
+	const string &data() const;
+
+private:
+	string m_data;
+};
+
+// Reads what a BinaryWriter wrote. Reading past the end yields zeros
+// and makes ok() return false, so callers can read a whole record and
+// check once at the end. The data must outlive the reader.
+class BinaryReader
+{
+public:
+	BinaryReader(const string &data);
+	BinaryReader(const char *data, size_t length);
+
+	bool ok() const;
+	bool atEnd() const;
+
+	uint8_t readU8();
+	uint32_t readU32();
+	uint64_t readU64();
+	int readI32();
+	double readDouble();
+
+	// fails rather than reading more letters than a LetterString holds
+	LetterString readLetters();
+	string readString();
+
+	Move readMove();
+
+private:
+	const char *m_at;
+	const char *m_end;
+	bool m_ok;
+};
+
+inline const string &BinaryWriter::data() const
+{
+	return m_data;
+}
+
+inline bool BinaryReader::ok() const
+{
+	return m_ok;
+}
+
+inline bool BinaryReader::atEnd() const
+{
+	return m_at >= m_end;
+}
+
+}
+
+#endif
@@ -22,6 +22,7 @@
 #include "board.h"
 #include "boardparameters.h"
 #include "datamanager.h"
+#include "enginecontext.h"
 #include "gameparameters.h"
 #include "generator.h"
 
@@ -44,11 +45,13 @@ Board::Board()
       m_height(QUACKLE_BOARD_PARAMETERS->height()), 
       m_empty(true)
 {
+	prepareEmptyBoard();
 }
 
 Board::Board(int width, int height)
     : m_width(width), m_height(height), m_empty(true)
 {
+	prepareEmptyBoard();
 }
 
 Bag Board::tilesOnBoard() const
@@ -60,10 +63,10 @@ Bag Board::tilesOnBoard() const
 	{
 		for (int col = 0; col < m_width; col++)
 		{
-			if (m_letters[row][col] != QUACKLE_NULL_MARK)
+			if (letter(row, col) != QUACKLE_NULL_MARK)
 			{
 				LetterString letters;
-				letters += m_isBlank[row][col]? QUACKLE_BLANK_MARK : m_letters[row][col];
+				letters += isBlank(row, col)? QUACKLE_BLANK_MARK : letter(row, col);
 				ret.toss(letters);
 			}
 		}
@@ -78,8 +81,8 @@ Bag Board::tilesNotOnBoard() const
 
 	for (int row = 0; row < m_height; row++)
 		for (int col = 0; col < m_width; col++)
-			if (m_letters[row][col] != QUACKLE_NULL_MARK)
-				ret.removeLetter(m_isBlank[row][col]? QUACKLE_BLANK_MARK : m_letters[row][col]);
+			if (letter(row, col) != QUACKLE_NULL_MARK)
+				ret.removeLetter(isBlank(row, col)? QUACKLE_BLANK_MARK : letter(row, col));
 
 	return ret;
 }
@@ -141,25 +144,25 @@ void Board::updateBritishness()
 		{
 			bool isBritish = false;
 
-			if (m_letters[row][col] != QUACKLE_NULL_MARK)
+			if (letter(row, col) != QUACKLE_NULL_MARK)
 			{
 				word.clear();
-				word += QUACKLE_ALPHABET_PARAMETERS->clearBlankness(m_letters[row][col]);
+				word += QUACKLE_ALPHABET_PARAMETERS->clearBlankness(letter(row, col));
 
 				for (int j = row - 1; j >= 0; --j)
 				{
-					if (m_letters[j][col] == QUACKLE_NULL_MARK)
+					if (letter(j, col) == QUACKLE_NULL_MARK)
 						break;
 					else
-						word = QUACKLE_ALPHABET_PARAMETERS->clearBlankness(m_letters[j][col]) + word;
+						word = QUACKLE_ALPHABET_PARAMETERS->clearBlankness(letter(j, col)) + word;
 				}
 
 				for (int j = row + 1; j < m_height; ++j)
 				{
-					if (m_letters[j][col] == QUACKLE_NULL_MARK)
+					if (letter(j, col) == QUACKLE_NULL_MARK)
 						break;
 					else
-						word += QUACKLE_ALPHABET_PARAMETERS->clearBlankness(m_letters[j][col]);
+						word += QUACKLE_ALPHABET_PARAMETERS->clearBlankness(letter(j, col));
 				}
 
 				if (word.length() > 1)
@@ -173,22 +176,22 @@ void Board::updateBritishness()
 				}
 
 				word.clear();
-				word += QUACKLE_ALPHABET_PARAMETERS->clearBlankness(m_letters[row][col]);
+				word += QUACKLE_ALPHABET_PARAMETERS->clearBlankness(letter(row, col));
 
 				for (int j = col - 1; j >= 0; --j)
 				{
-					if (m_letters[row][j] == QUACKLE_NULL_MARK)
+					if (letter(row, j) == QUACKLE_NULL_MARK)
 						break;
 					else
-						word = QUACKLE_ALPHABET_PARAMETERS->clearBlankness(m_letters[row][j]) + word;
+						word = QUACKLE_ALPHABET_PARAMETERS->clearBlankness(letter(row, j)) + word;
 				}
 
 				for (int j = col + 1; j < m_width; ++j)
 				{
-					if (m_letters[row][j] == QUACKLE_NULL_MARK)
+					if (letter(row, j) == QUACKLE_NULL_MARK)
 						break;
 					else
-						word += QUACKLE_ALPHABET_PARAMETERS->clearBlankness(m_letters[row][j]);
+						word += QUACKLE_ALPHABET_PARAMETERS->clearBlankness(letter(row, j));
 				}
 
 				if (word.length() > 1)
@@ -202,7 +205,10 @@ void Board::updateBritishness()
 				}
 			}
 
-			m_isBritish[row][col] = isBritish;
+			if (isBritish)
+				square(row, col).flags |= BritishFlag;
+			else
+				square(row, col).flags &= ~BritishFlag;
 		}
 	}
 }
@@ -229,7 +235,7 @@ MoveList Board::allWordsFormedBy(const Move &move) const
 				int i = 0;
 				for (const auto& it : move.tiles())
 				{
-					if (m_letters[move.startrow][i + move.startcol] == QUACKLE_NULL_MARK)
+					if (letter(move.startrow, i + move.startcol) == QUACKLE_NULL_MARK)
 					{
 						word.clear();
 						word += it;
@@ -237,23 +243,23 @@ MoveList Board::allWordsFormedBy(const Move &move) const
 						int startRow = 0;
 						for (int j = move.startrow - 1; j >= 0; --j)
 						{
-							if (m_letters[j][i + move.startcol] == QUACKLE_NULL_MARK)
+							if (letter(j, i + move.startcol) == QUACKLE_NULL_MARK)
 							{
 								startRow = j + 1;
 								break;
 							}
 							else
 							{
-								word = m_letters[j][i + move.startcol] + word;
+								word = letter(j, i + move.startcol) + word;
 							}
 						}
 
 						for (int j = move.startrow + 1; j < m_height; ++j)
 						{
-							if (m_letters[j][i + move.startcol] == QUACKLE_NULL_MARK)
+							if (letter(j, i + move.startcol) == QUACKLE_NULL_MARK)
 								j = m_height;
 							else
-								word += m_letters[j][i + move.startcol];
+								word += letter(j, i + move.startcol);
 						}
 
 						if (word.length() > 1)
@@ -269,7 +275,7 @@ MoveList Board::allWordsFormedBy(const Move &move) const
 				int i = 0;
 				for (const auto& it : move.tiles())
 				{
-					if (m_letters[i + move.startrow][move.startcol] == QUACKLE_NULL_MARK)
+					if (letter(i + move.startrow, move.startcol) == QUACKLE_NULL_MARK)
 					{
 						word.clear();
 						word += it;
@@ -277,23 +283,23 @@ MoveList Board::allWordsFormedBy(const Move &move) const
 						int startColumn = 0;
 						for (int j = move.startcol - 1; j >= 0; --j)
 						{
-							if (m_letters[i + move.startrow][j] == QUACKLE_NULL_MARK)
+							if (letter(i + move.startrow, j) == QUACKLE_NULL_MARK)
 							{
 								startColumn = j + 1;
 								break;
 							}
 							else
 							{
-								word = m_letters[i + move.startrow][j] + word;
+								word = letter(i + move.startrow, j) + word;
 							}
 						}
 
 						for (int j = move.startcol + 1; j < m_width; ++j)
 						{
-							if (m_letters[i + move.startrow][j] == QUACKLE_NULL_MARK)
+							if (letter(i + move.startrow, j) == QUACKLE_NULL_MARK)
 								j = m_width;
 							else
-								word += m_letters[i + move.startrow][j];
+								word += letter(i + move.startrow, j);
 						}
 
 						if (word.length() > 1)
@@ -318,6 +324,11 @@ MoveList Board::allWordsFormedBy(const Move &move) const
 }
 
 int Board::score(const Move &move, bool *isBingo) const
+{
+	return score(move, EngineContext(), isBingo);
+}
+
+int Board::score(const Move &move, const EngineContext &context, bool *isBingo) const
 {
 	if (isBingo != 0)
 		*isBingo = false;
@@ -336,55 +347,55 @@ int Board::score(const Move &move, bool *isBingo) const
 			const LetterString::const_iterator end(move.tiles().end());
 			for (LetterString::const_iterator it = move.tiles().begin(); it != end; ++it, ++i)
 			{
-				if (m_letters[move.startrow][i + move.startcol] == QUACKLE_NULL_MARK)
+				if (letter(move.startrow, i + move.startcol) == QUACKLE_NULL_MARK)
 				{
-					if (QUACKLE_ALPHABET_PARAMETERS->isPlainLetter(*it))
-						mainscore += QUACKLE_ALPHABET_PARAMETERS->score(*it) * letterMultiplier(move.startrow, i + move.startcol);
+					if (context.isPlainLetter(*it))
+						mainscore += context.score(*it) * context.letterMultiplier(move.startrow, i + move.startcol);
 
 					++laid;
 
-					wordmult *= wordMultiplier(move.startrow, i + move.startcol);
+					wordmult *= context.wordMultiplier(move.startrow, i + move.startcol);
 
 					int thishook = 0;
 					int hooked = 0;
 
 					for (int j = move.startrow - 1; j >= 0; --j)
 					{
-						if (m_letters[j][i + move.startcol] == QUACKLE_NULL_MARK)
+						if (letter(j, i + move.startcol) == QUACKLE_NULL_MARK)
 							j = -1;
 						else
 						{
 							++hooked;
 
-							if (!m_isBlank[j][i + move.startcol])
-								thishook += QUACKLE_ALPHABET_PARAMETERS->score(m_letters[j][i + move.startcol]);
+							if (!isBlank(j, i + move.startcol))
+								thishook += context.score(letter(j, i + move.startcol));
 						}
 					}
 
 					for (int j = move.startrow + 1; j < m_height; ++j)
 					{
-						if (m_letters[j][i + move.startcol] == QUACKLE_NULL_MARK)
+						if (letter(j, i + move.startcol) == QUACKLE_NULL_MARK)
 							j = m_height;
 						else
 						{
 							++hooked;
 
-							if (!m_isBlank[j][i + move.startcol])
-								thishook += QUACKLE_ALPHABET_PARAMETERS->score(m_letters[j][i + move.startcol]);
+							if (!isBlank(j, i + move.startcol))
+								thishook += context.score(letter(j, i + move.startcol));
 						}
 					}
 
 					if (hooked > 0)
 					{
-						if (QUACKLE_ALPHABET_PARAMETERS->isPlainLetter(*it))
-							thishook += QUACKLE_ALPHABET_PARAMETERS->score(*it) * letterMultiplier(move.startrow, i + move.startcol);
+						if (context.isPlainLetter(*it))
+							thishook += context.score(*it) * context.letterMultiplier(move.startrow, i + move.startcol);
 
-						thishook *= wordMultiplier(move.startrow, i + move.startcol);
+						thishook *= context.wordMultiplier(move.startrow, i + move.startcol);
 						hookscore += thishook;
 					} 
 				}
-				else if (!m_isBlank[move.startrow][i + move.startcol])
-					mainscore += QUACKLE_ALPHABET_PARAMETERS->score(m_letters[move.startrow][i + move.startcol]);
+				else if (!isBlank(move.startrow, i + move.startcol))
+					mainscore += context.score(letter(move.startrow, i + move.startcol));
 			}
 		}
 		else
@@ -393,55 +404,55 @@ int Board::score(const Move &move, bool *isBingo) const
 			const LetterString::const_iterator end(move.tiles().end());
 			for (LetterString::const_iterator it = move.tiles().begin(); it != end; ++it, ++i)
 			{
-				if (m_letters[i + move.startrow][move.startcol] == QUACKLE_NULL_MARK)
+				if (letter(i + move.startrow, move.startcol) == QUACKLE_NULL_MARK)
 				{
-					if (QUACKLE_ALPHABET_PARAMETERS->isPlainLetter(*it))
-						mainscore += QUACKLE_ALPHABET_PARAMETERS->score(*it) * letterMultiplier(i + move.startrow, move.startcol);
+					if (context.isPlainLetter(*it))
+						mainscore += context.score(*it) * context.letterMultiplier(i + move.startrow, move.startcol);
 
 					++laid;
 
-					wordmult *= wordMultiplier(i + move.startrow, move.startcol);
+					wordmult *= context.wordMultiplier(i + move.startrow, move.startcol);
 
 					int thishook = 0;
 					int hooked = 0;
 
 					for (int j = move.startcol - 1; j >= 0; --j)
 					{
-						if (m_letters[i + move.startrow][j] == QUACKLE_NULL_MARK)
+						if (letter(i + move.startrow, j) == QUACKLE_NULL_MARK)
 							j = -1;
 						else
 						{
 							++hooked;
 
-							if (!m_isBlank[i + move.startrow][j])
-								thishook += QUACKLE_ALPHABET_PARAMETERS->score(m_letters[i + move.startrow][j]);
+							if (!isBlank(i + move.startrow, j))
+								thishook += context.score(letter(i + move.startrow, j));
 						}
 					}
 
 					for (int j = move.startcol + 1; j < m_width; ++j)
 					{
-						if (m_letters[i + move.startrow][j] == QUACKLE_NULL_MARK)
+						if (letter(i + move.startrow, j) == QUACKLE_NULL_MARK)
 							j = m_width;
 						else
 						{
 							++hooked;
 
-							if (!m_isBlank[i + move.startrow][j])
-								thishook += QUACKLE_ALPHABET_PARAMETERS->score(m_letters[i + move.startrow][j]);
+							if (!isBlank(i + move.startrow, j))
+								thishook += context.score(letter(i + move.startrow, j));
 						}
 					}
 
 					if (hooked > 0)
 					{
-						if (QUACKLE_ALPHABET_PARAMETERS->isPlainLetter(*it))
-							thishook += QUACKLE_ALPHABET_PARAMETERS->score(*it) * letterMultiplier(i + move.startrow, move.startcol);
+						if (context.isPlainLetter(*it))
+							thishook += context.score(*it) * context.letterMultiplier(i + move.startrow, move.startcol);
 
-						thishook *= wordMultiplier(i + move.startrow, move.startcol);
+						thishook *= context.wordMultiplier(i + move.startrow, move.startcol);
 						hookscore += thishook;
 					}
 				}
-				else if (!m_isBlank[i + move.startrow][move.startcol])
-					mainscore += QUACKLE_ALPHABET_PARAMETERS->score(m_letters[i + move.startrow][move.startcol]);
+				else if (!isBlank(i + move.startrow, move.startcol))
+					mainscore += context.score(letter(i + move.startrow, move.startcol));
 			}
 		}
 
@@ -450,11 +461,11 @@ int Board::score(const Move &move, bool *isBingo) const
 		if (move.tiles().length() > 1)
 			total += mainscore * wordmult;
 
-		if (laid == QUACKLE_PARAMETERS->rackSize())
+		if (laid == context.rackSize())
 		{
 			if (isBingo != 0)
 				*isBingo = true;
-			total += QUACKLE_PARAMETERS->bingoBonus();
+			total += context.bingoBonus();
 		}
 
 #ifdef DEBUG_BOARD
@@ -494,7 +505,7 @@ LetterString Board::prettyTilesOfMove(const Move &move, bool markPlayThruTiles)
 				insidePlayThru = true;
 			}
 
-			ret += m_letters[currentTileRow][currentTileCol];
+			ret += letter(currentTileRow, currentTileCol);
 		}
 		else 
 		{
@@ -536,7 +547,7 @@ LetterString Board::sanitizedTilesOfMove(const Move &move) const
 			else
 				currentTileRow += i;
 
-			if (m_letters[currentTileRow][currentTileCol] == QUACKLE_NULL_MARK)
+			if (letter(currentTileRow, currentTileCol) == QUACKLE_NULL_MARK)
 				ret += *it;
 			else
 				ret += QUACKLE_PLAYED_THRU_MARK;
@@ -556,10 +567,14 @@ void Board::makeMove(const Move &move)
 		const LetterString::const_iterator end(move.tiles().end());
 		for (LetterString::const_iterator it = move.tiles().begin(); it != end; ++it)
 		{
-			if (m_letters[row][col] == QUACKLE_NULL_MARK)
+			if (letter(row, col) == QUACKLE_NULL_MARK)
 			{
-				m_letters[row][col] = *it;
-				m_isBlank[row][col] = QUACKLE_ALPHABET_PARAMETERS->isBlankLetter(*it);
+				square(row, col).letter = *it;
+				if (QUACKLE_ALPHABET_PARAMETERS->isBlankLetter(*it))
+					square(row, col).flags |= BlankFlag;
+
+				m_staleRows |= uint64_t(1) << row;
+				m_staleColumns |= uint64_t(1) << col;
 			}
 
 			if (move.horizontal)
@@ -595,9 +610,9 @@ UVString Board::toString() const
 
 		for (int col = 0; col < m_width; col++)
 		{
-			if (m_letters[row][col] != QUACKLE_NULL_MARK)
+			if (letter(row, col) != QUACKLE_NULL_MARK)
 			{
-				ss << QUACKLE_ALPHABET_PARAMETERS->userVisible(m_letters[row][col]);
+				ss << QUACKLE_ALPHABET_PARAMETERS->userVisible(letter(row, col));
 			}
 			else
 			{
@@ -674,15 +689,15 @@ UVString Board::htmlBoard(const int tileSize) const
 				bgcolor = "goldenrod";
 
 			ss << "<td height=" << tdHeight << " width=" << tdWidth << " bgcolor=\"" << bgcolor << "\" " << centerAlign << ">";
-			if (m_letters[row][col] != QUACKLE_NULL_MARK)
+			if (letter(row, col) != QUACKLE_NULL_MARK)
 			{
 				const int fontSize = static_cast<int>(tileSize * 5/9);
-				if (QUACKLE_ALPHABET_PARAMETERS->isBlankLetter(m_letters[row][col]))
+				if (QUACKLE_ALPHABET_PARAMETERS->isBlankLetter(letter(row, col)))
 				{
 					const int blankFontSize = static_cast<int>(fontSize * 0.8);
 					ss << "<table style=\"border: 1pt; border-style: dashed\"><tr><td width=" << tdWidth * 0.8 << " height=" << tdHeight * 0.8 << " bgcolor=\"" << bgcolor << "\" " << centerAlign << ">";
 					ss << "<span style=\"font-size: " << blankFontSize << "px\">";
-					ss << QUACKLE_ALPHABET_PARAMETERS->userVisible(QUACKLE_ALPHABET_PARAMETERS->clearBlankness(m_letters[row][col]));
+					ss << QUACKLE_ALPHABET_PARAMETERS->userVisible(QUACKLE_ALPHABET_PARAMETERS->clearBlankness(letter(row, col)));
 					ss << "</span>";
 					ss << "</td></tr></table>";
 				}
@@ -692,10 +707,10 @@ UVString Board::htmlBoard(const int tileSize) const
 					const int minimumValueFontSize = 7;
 					const int valueFontSize = minimumValueFontSize > idealValueFontSize? minimumValueFontSize : idealValueFontSize;
 					ss << "<span style=\"font-size: " << fontSize << "px\">";
-					ss << QUACKLE_ALPHABET_PARAMETERS->userVisible(m_letters[row][col]);
+					ss << QUACKLE_ALPHABET_PARAMETERS->userVisible(letter(row, col));
 					ss << "</span>";
 					ss << "<span style=\"font-size: " << valueFontSize << "px\">";
-					ss << QUACKLE_ALPHABET_PARAMETERS->score(m_letters[row][col]);
+					ss << QUACKLE_ALPHABET_PARAMETERS->score(letter(row, col));
 					ss << "</span>";
 				}
 			}
@@ -738,14 +753,86 @@ void Board::prepareEmptyBoard()
 {
 	m_empty = true;
 
-	for (int i = 0; i < m_height; ++i)
+	Square empty;
+	empty.vcross = empty.hcross = LetterMasks::full();
+	empty.letter = QUACKLE_NULL_MARK;
+	empty.flags = 0;
+	empty.horizontalLeftLimit = empty.verticalLeftLimit = 0;
+	m_squares.assign(m_width * m_height, empty);
+
+	// an empty board has no anchors
+	m_horizontalAnchors.assign(m_height, 0);
+	m_verticalAnchors.assign(m_height, 0);
+	m_staleRows = m_staleColumns = 0;
+}
+
+void Board::updateAnchors()
+{
+	for (int row = 0; m_staleRows; ++row, m_staleRows >>= 1)
+		if (m_staleRows & 1)
+			updateRowAnchors(row);
+
+	for (int col = 0; m_staleColumns; ++col, m_staleColumns >>= 1)
+		if (m_staleColumns & 1)
+			updateColumnAnchors(col);
+}
+
+void Board::updateRowAnchors(int row)
+{
+	// freeRun[col] counts the empty squares ending at col that a play
+	// could extend onto without touching other tiles
+	int freeRun[QUACKLE_MAXIMUM_BOARD_SIZE];
+	int wordLength = 0;
+	uint64_t anchors = 0;
+
+	for (int col = 0; col < m_width; ++col)
+	{
+		Square &here = square(row, col);
+		const bool occupied = isNonempty(row, col);
+		const bool leftEmpty = col == 0 || !isNonempty(row, col - 1);
+		const bool rightEmpty = col == m_width - 1 || !isNonempty(row, col + 1);
+		const bool fullCross = LetterMasks::isFull(here.vcross);
+
+		wordLength = occupied? wordLength + 1 : 0;
+		freeRun[col] = (!occupied && fullCross && leftEmpty)? (col > 0? freeRun[col - 1] : 0) + 1 : 0;
+
+		if (occupied? rightEmpty : !fullCross && leftEmpty && rightEmpty)
+		{
+			anchors |= uint64_t(1) << col;
+			const int before = col - wordLength - 1;
+			here.horizontalLeftLimit = wordLength + (before >= 0? freeRun[before] : 0);
+		}
+	}
+
+	m_horizontalAnchors[row] = anchors;
+}
+
+void Board::updateColumnAnchors(int col)
+{
+	int freeRun[QUACKLE_MAXIMUM_BOARD_SIZE];
+	int wordLength = 0;
+	const uint64_t bit = uint64_t(1) << col;
+
+	for (int row = 0; row < m_height; ++row)
 	{
-		for (int j = 0; j < m_width; ++j)
+		Square &here = square(row, col);
+		const bool occupied = isNonempty(row, col);
+		const bool aboveEmpty = row == 0 || !isNonempty(row - 1, col);
+		const bool belowEmpty = row == m_height - 1 || !isNonempty(row + 1, col);
+		const bool fullCross = LetterMasks::isFull(here.hcross);
+
+		wordLength = occupied? wordLength + 1 : 0;
+		freeRun[row] = (!occupied && fullCross && aboveEmpty)? (row > 0? freeRun[row - 1] : 0) + 1 : 0;
+
+		if (occupied? belowEmpty : !fullCross && aboveEmpty && belowEmpty)
+		{
+			m_verticalAnchors[row] |= bit;
+			const int before = row - wordLength - 1;
+			here.verticalLeftLimit = wordLength + (before >= 0? freeRun[before] : 0);
+		}
+		else
 		{
-			m_letters[i][j] = QUACKLE_NULL_MARK;
-			m_isBlank[i][j] = false;
-			m_vcross[i][j].set();
-			m_hcross[i][j].set();
+			m_verticalAnchors[row] &= ~bit;
 		}
 	}
 }
@@ -754,12 +841,12 @@ Board::TileInformation Board::tileInformation(int row, int col) const
 {
 	TileInformation ret;
 
-	if (m_letters[row][col] != QUACKLE_NULL_MARK)
+	if (letter(row, col) != QUACKLE_NULL_MARK)
 	{
 		ret.tileType = LetterTile;
-		ret.isBlank = m_isBlank[row][col];
-		ret.letter = QUACKLE_ALPHABET_PARAMETERS->clearBlankness(m_letters[row][col]);
-		ret.isBritish = m_isBritish[row][col];
+		ret.isBlank = isBlank(row, col);
+		ret.letter = QUACKLE_ALPHABET_PARAMETERS->clearBlankness(letter(row, col));
+		ret.isBritish = isBritish(row, col);
 	}
 	else
 	{
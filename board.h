@@ -19,8 +19,8 @@
 #ifndef QUACKLE_BOARD_H
 #define QUACKLE_BOARD_H
 
+#include <cstdint>
 #include <vector>
-#include <bitset>
 
 #include "alphabetparameters.h"
 #include "bag.h"
@@ -29,14 +29,14 @@
 
 using namespace std;
 
-typedef bitset<QUACKLE_MAXIMUM_ALPHABET_SIZE> LetterBitset;
-
 #define QUACKLE_MAXIMUM_BOARD_SIZE LETTER_STRING_MAXIMUM_LENGTH
 #define QUACKLE_MINIMUM_BOARD_SIZE 7
 
 namespace Quackle
 {
 
+class EngineContext;
+
 class Board
 {
 public:
@@ -82,6 +82,9 @@ public:
 	// is stored in isBingo.
 	int score(const Move &move, bool *isBingo = 0) const;
 
+	// as above but reading scores and bonuses from context
+	int score(const Move &move, const EngineContext &context, bool *isBingo = 0) const;
+
 	// Return string suitable for prettyTiles field of move.
 	// If markPlayThruTiles is true, wrap tiles played thru in
 	// parentheses
@@ -125,23 +128,65 @@ public:
 	bool isBlank(int row, int col) const;
 	bool isBritish(int row, int col) const;
 
-	const LetterBitset &vcross(int row, int col) const;
-	void setVCross(int row, int col, const LetterBitset &vcross);
+	LetterMask vcross(int row, int col) const;
+	void setVCross(int row, int col, LetterMask vcross);
+
+	LetterMask hcross(int row, int col) const;
+	void setHCross(int row, int col, LetterMask hcross);
+
+	// Anchors for GADDAG move generation: the last square of each
+	// word, and empty squares with a nontrivial cross set between two
+	// empty squares. Bit col of horizontalAnchors(row) marks an anchor
+	// for horizontal plays at (row, col), and likewise for vertical
+	// plays. Rows and columns whose letters or crosses changed are
+	// recomputed by updateAnchors, which must be called before these
+	// are read.
+	void updateAnchors();
+	uint64_t horizontalAnchors(int row) const;
+	uint64_t verticalAnchors(int row) const;
 
-	const LetterBitset &hcross(int row, int col) const;
-	void setHCross(int row, int col, const LetterBitset &hcross);
+	// how many tiles a play through the anchor at (row, col) may lay
+	// before it, counting the anchor's word if it's on a letter
+	int horizontalLeftLimit(int row, int col) const;
+	int verticalLeftLimit(int row, int col) const;
 
 protected:
+	// Squares are stored row by row for just width x height, so
+	// copying a board copies only what's in use.
+	struct Square
+	{
+		LetterMask vcross;
+		LetterMask hcross;
+
+		// as placed, so blanks are in their blank form
+		Letter letter;
+		uint8_t flags;
+
+		// only meaningful at anchors
+		uint8_t horizontalLeftLimit;
+		uint8_t verticalLeftLimit;
+	};
+
+	enum SquareFlags { BlankFlag = 1, BritishFlag = 2 };
+
+	Square &square(int row, int col);
+	const Square &square(int row, int col) const;
+
 	int m_width;
 	int m_height;
 	bool m_empty;
 
-	Letter m_letters[QUACKLE_MAXIMUM_BOARD_SIZE][QUACKLE_MAXIMUM_BOARD_SIZE];
-	bool m_isBlank[QUACKLE_MAXIMUM_BOARD_SIZE][QUACKLE_MAXIMUM_BOARD_SIZE];
-	bool m_isBritish[QUACKLE_MAXIMUM_BOARD_SIZE][QUACKLE_MAXIMUM_BOARD_SIZE];
+	vector<Square> m_squares;
 
-	LetterBitset m_vcross[QUACKLE_MAXIMUM_BOARD_SIZE][QUACKLE_MAXIMUM_BOARD_SIZE];
-	LetterBitset m_hcross[QUACKLE_MAXIMUM_BOARD_SIZE][QUACKLE_MAXIMUM_BOARD_SIZE];
+	// anchor bits per row, and bitsets of rows and columns whose
+	// anchors are out of date
+	vector<uint64_t> m_horizontalAnchors;
+	vector<uint64_t> m_verticalAnchors;
+	uint64_t m_staleRows;
+	uint64_t m_staleColumns;
+
+	void updateRowAnchors(int row);
+	void updateColumnAnchors(int col);
 
 	inline bool isNonempty(int row, int column) const;
 };
@@ -151,44 +196,82 @@ inline bool Board::isEmpty() const
 	return m_empty;
 }
 
+inline Board::Square &Board::square(int row, int col)
+{
+	return m_squares[row * m_width + col];
+}
+
+inline const Board::Square &Board::square(int row, int col) const
+{
+	return m_squares[row * m_width + col];
+}
+
 inline Letter Board::letter(int row, int col) const
 {
-	return m_letters[row][col];
+	return square(row, col).letter;
 }
 
 inline bool Board::isBlank(int row, int col) const
 {
-	return m_isBlank[row][col];
+	return square(row, col).flags & BlankFlag;
 }
 
 inline bool Board::isBritish(int row, int col) const
 {
-	return m_isBritish[row][col];
+	return square(row, col).flags & BritishFlag;
+}
+
+inline LetterMask Board::vcross(int row, int col) const
+{
+	return square(row, col).vcross;
+}
+
+inline void Board::setVCross(int row, int col, LetterMask vcross)
+{
+	if (square(row, col).vcross != vcross)
+	{
+		square(row, col).vcross = vcross;
+		m_staleRows |= uint64_t(1) << row;
+	}
+}
+
+inline LetterMask Board::hcross(int row, int col) const
+{
+	return square(row, col).hcross;
+}
+
+inline void Board::setHCross(int row, int col, LetterMask hcross)
+{
+	if (square(row, col).hcross != hcross)
+	{
+		square(row, col).hcross = hcross;
+		m_staleColumns |= uint64_t(1) << col;
+	}
 }
 
-inline const LetterBitset &Board::vcross(int row, int col) const
+inline uint64_t Board::horizontalAnchors(int row) const
 {
-	return m_vcross[row][col];
+	return m_horizontalAnchors[row];
 }
 
-inline void Board::setVCross(int row, int col, const LetterBitset &vcross)
+inline uint64_t Board::verticalAnchors(int row) const
 {
-	m_vcross[row][col] = vcross;
+	return m_verticalAnchors[row];
 }
 
-inline const LetterBitset &Board::hcross(int row, int col) const
+inline int Board::horizontalLeftLimit(int row, int col) const
 {
-	return m_hcross[row][col];
+	return square(row, col).horizontalLeftLimit;
 }
 
-inline void Board::setHCross(int row, int col, const LetterBitset &hcross)
+inline int Board::verticalLeftLimit(int row, int col) const
 {
-	m_hcross[row][col] = hcross;
+	return square(row, col).verticalLeftLimit;
 }
 
 inline bool Board::isNonempty(int row, int column) const
 {
-	return m_letters[row][column] != QUACKLE_NULL_MARK;
+	return square(row, column).letter != QUACKLE_NULL_MARK;
 }
 
 }
@@ -50,8 +50,6 @@ protected:
 	int m_maxIterationsPerSecond;
 	int m_nestedMinIterationsPerSecond;
 	int m_nestedMaxIterationsPerSecond;
-
-    bool m_inferring;
 };
 
 inline bool SmartBogowin::isSlow() const
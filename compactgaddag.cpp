@@ -0,0 +1,59 @@
+/*
+ *  Quackle -- Crossword game artificial intelligence and analysis tool
+ *  Copyright (C) 2005-2019 Jason Katz-Brown, John O'Laughlin, and John Fultz.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+
+#include "compactgaddag.h"
+
+using namespace Quackle;
+
+CompactGaddag::CompactGaddag(const GaddagNode *nodes, size_t nodeCount)
+{
+	pack(nodes, nodeCount);
+}
+
+CompactGaddag::CompactGaddag(const NarrowGaddagNode *nodes, size_t nodeCount)
+{
+	pack(nodes, nodeCount);
+}
+
+template <class Node>
+void CompactGaddag::pack(const Node *nodes, size_t nodeCount)
+{
+	uint32_t largestOffset = 0;
+	for (size_t i = 0; i < nodeCount; ++i)
+		largestOffset = max(largestOffset, nodes[i].childOffset());
+
+	int offsetBits = 1;
+	while (offsetBits < 32 && (largestOffset >> offsetBits) != 0)
+		++offsetBits;
+
+	m_bitsPerNode = 8 + offsetBits;
+	m_mask = ((uint64_t)1 << m_bitsPerNode) - 1;
+
+	// node() reads 8 bytes wherever a node starts
+	m_bytes.assign((nodeCount * m_bitsPerNode + 7) / 8 + sizeof(uint64_t), 0);
+	for (size_t i = 0; i < nodeCount; ++i)
+	{
+		const uint64_t value = (uint64_t)nodes[i].childOffset() << 8 | nodes[i].flags();
+		const uint64_t bit = (uint64_t)i * m_bitsPerNode;
+		for (int j = 0; j < m_bitsPerNode; ++j)
+			if (value & ((uint64_t)1 << j))
+				m_bytes[(bit + j) >> 3] |= 1 << ((bit + j) & 7);
+	}
+}
@@ -0,0 +1,162 @@
+/*
+ *  Quackle -- Crossword game artificial intelligence and analysis tool
+ *  Copyright (C) 2005-2019 Jason Katz-Brown, John O'Laughlin, and John Fultz.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QUACKLE_COMPACTGADDAG_H
+#define QUACKLE_COMPACTGADDAG_H
+
+#include <cstring>
+#include <vector>
+
+#include "gaddag.h"
+
+namespace Quackle
+{
+
+class CompactGaddag;
+
+// A handle on a node of a CompactGaddag. It answers what a
+// const GaddagNode * does, with the same -> and truth-test syntax,
+// so the generator can walk either.
+class CompactGaddagNode
+{
+public:
+	CompactGaddagNode();
+
+	Letter letter() const;
+	bool isTerminal() const;
+	CompactGaddagNode firstChild() const;
+	CompactGaddagNode nextSibling() const;
+	CompactGaddagNode child(Letter l) const;
+
+	explicit operator bool() const;
+	const CompactGaddagNode *operator->() const { return this; };
+
+private:
+	friend class CompactGaddag;
+	CompactGaddagNode(const CompactGaddag *gaddag, uint32_t index);
+
+	const CompactGaddag *m_gaddag;
+	uint32_t m_index;
+	uint64_t m_node;
+};
+
+// A GADDAG with every node packed into just the bits it needs: the
+// letter and flags byte of GaddagNode, then a child offset as wide as
+// the largest offset in this lexicon. That is about 28 bits a node
+// for TWL06 rather than 64, for hosting many lexica at once.
+class CompactGaddag
+{
+public:
+	CompactGaddag(const GaddagNode *nodes, size_t nodeCount);
+	CompactGaddag(const NarrowGaddagNode *nodes, size_t nodeCount);
+
+	CompactGaddagNode root() const { return CompactGaddagNode(this, 0); };
+
+	int bitsPerNode() const { return m_bitsPerNode; };
+	size_t bytes() const { return m_bytes.size(); };
+
+private:
+	friend class CompactGaddagNode;
+	uint64_t node(uint32_t index) const;
+
+	template <class Node> void pack(const Node *nodes, size_t nodeCount);
+
+	std::vector<unsigned char> m_bytes;
+	int m_bitsPerNode;
+	uint64_t m_mask;
+};
+
+inline uint64_t
+CompactGaddag::node(uint32_t index) const
+{
+	const uint64_t bit = (uint64_t)index * m_bitsPerNode;
+	uint64_t word;
+	memcpy(&word, &m_bytes[bit >> 3], sizeof(word));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	word = __builtin_bswap64(word);
+#endif
+	return (word >> (bit & 7)) & m_mask;
+}
+
+inline
+CompactGaddagNode::CompactGaddagNode()
+	: m_gaddag(0), m_index(0), m_node(0)
+{
+}
+
+inline
+CompactGaddagNode::CompactGaddagNode(const CompactGaddag *gaddag, uint32_t index)
+	: m_gaddag(gaddag), m_index(index), m_node(gaddag->node(index))
+{
+}
+
+inline
+CompactGaddagNode::operator bool() const
+{
+	return m_gaddag != 0;
+}
+
+inline Letter
+CompactGaddagNode::letter() const
+{
+	return (m_node & 0x3F /*0b00111111*/);
+}
+
+inline bool
+CompactGaddagNode::isTerminal() const
+{
+	return (m_node & 0x40) != 0 /*0b01000000*/;
+}
+
+inline CompactGaddagNode
+CompactGaddagNode::firstChild() const
+{
+	const uint32_t p = (uint32_t)(m_node >> 8);
+	if (p == 0) {
+		return CompactGaddagNode();
+	} else {
+		return CompactGaddagNode(m_gaddag, m_index + p);
+	}
+}
+
+inline CompactGaddagNode
+CompactGaddagNode::nextSibling() const
+{
+	if (m_node & 0x80 /*0b10000000*/) {
+		return CompactGaddagNode();
+	} else {
+		return CompactGaddagNode(m_gaddag, m_index + 1);
+	}
+}
+
+inline CompactGaddagNode
+CompactGaddagNode::child(Letter l) const
+{
+	for (CompactGaddagNode child = firstChild(); child; child = child.nextSibling()) {
+		if (child.letter() == l) {
+			return child;
+		} else if (l != QUACKLE_GADDAG_SEPARATOR && child.letter() > l) {
+			return CompactGaddagNode();
+		}
+	}
+	return CompactGaddagNode();
+}
+
+}
+
+#endif
@@ -16,13 +16,15 @@
  *  along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include "analysiscache.h"
 #include "computerplayer.h"
+#include "datamanager.h"
 #include "endgameplayer.h"
 
 using namespace Quackle;
 
 ComputerPlayer::ComputerPlayer()
-	: m_name(MARK_UV("Computer Player")), m_id(0), m_dispatch(0)
+	: m_name(MARK_UV("Computer Player")), m_id(0), m_dispatch(0), m_hasPreviousPosition(false)
 {
 	m_parameters.secondsPerTurn = 10;
     m_parameters.inferring = false;
@@ -41,6 +43,13 @@ void ComputerPlayer::setDispatch(ComputerDispatch *dispatch)
 void ComputerPlayer::setPosition(const GamePosition &position)
 {
 	m_simulator.setPosition(position);
+	m_hasPreviousPosition = false;
+}
+
+void ComputerPlayer::setPreviousPosition(const GamePosition &position)
+{
+	m_previousPosition = position;
+	m_hasPreviousPosition = true;
 }
 
 bool ComputerPlayer::shouldAbort()
@@ -85,12 +94,29 @@ StaticPlayer::~StaticPlayer()
 
 Move StaticPlayer::move()
 {
+	if (QUACKLE_ANALYSIS_CACHE)
+		return moves(1).back();
+
 	return m_simulator.currentPosition().staticBestMove();
 }
 
 MoveList StaticPlayer::moves(int nmoves)
 {
+	AnalysisCache *cache = QUACKLE_ANALYSIS_CACHE;
+	const bool useCache = cache && currentPosition().nestedness() == 0;
+
+	MoveList cachedMoves;
+	if (useCache && cache->findKibitz(currentPosition(), nmoves, &cachedMoves))
+	{
+		m_simulator.currentPosition().setMoves(cachedMoves);
+		return cachedMoves;
+	}
+
 	m_simulator.currentPosition().kibitz(nmoves);
+
+	if (useCache)
+		cache->storeKibitz(currentPosition(), nmoves, currentPosition().moves());
+
 	return m_simulator.currentPosition().moves();
 }
 
@@ -83,6 +83,13 @@ public:
     // on this position
     virtual void setPosition(const GamePosition &position);
 
+    // the position the player before us made their play from, for
+    // players that infer something from that play; setPosition
+    // forgets it
+    void setPreviousPosition(const GamePosition &position);
+    bool hasPreviousPosition() const;
+    const GamePosition &previousPosition() const;
+
     // get access to the position that we're playing from
     GamePosition &currentPosition();
     const GamePosition &currentPosition() const;
@@ -139,6 +146,9 @@ protected:
 	int m_id;
 	ComputerParameters m_parameters;
 	ComputerDispatch *m_dispatch;
+
+	GamePosition m_previousPosition;
+	bool m_hasPreviousPosition;
 };
 
 inline GamePosition &ComputerPlayer::currentPosition()
@@ -151,6 +161,16 @@ inline const GamePosition &ComputerPlayer::currentPosition() const
 	return m_simulator.currentPosition();
 }
 
+inline bool ComputerPlayer::hasPreviousPosition() const
+{
+	return m_hasPreviousPosition;
+}
+
+inline const GamePosition &ComputerPlayer::previousPosition() const
+{
+	return m_previousPosition;
+}
+
 inline void ComputerPlayer::setParameters(const ComputerParameters &parameters)
 {
 	m_parameters = parameters;
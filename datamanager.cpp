@@ -20,6 +20,7 @@
 #include <sys/stat.h>
 #include <cstdlib>
 
+#include "analysiscache.h"
 #include "catchall.h"
 #include "computerplayer.h"
 #include "datamanager.h"
@@ -36,11 +37,18 @@
 using namespace Quackle;
 
 DataManager *DataManager::m_self = 0;
+thread_local DataManager *DataManager::m_current = 0;
+thread_local mt19937_64 *DataManager::m_threadRng = 0;
 
 DataManager::DataManager()
-	: m_evaluator(0), m_parameters(0), m_alphabetParameters(0), m_boardParameters(0), m_lexiconParameters(0), m_strategyParameters(0)
+	: m_evaluator(0), m_parameters(0), m_alphabetParameters(0), m_boardParameters(0), m_strategyParameters(0), m_analysisCache(0)
 {
-	m_self = this;
+	if (!m_self)
+		m_self = this;
+
+	// parameters made here see this data manager
+	DataManagerScope scope(this);
+
 	setAppDataDirectory(".");
 	setUserDataDirectory(".");
 
@@ -51,20 +59,28 @@ DataManager::DataManager()
 	m_evaluator = new CatchallEvaluator;
 	m_parameters = new EnglishParameters;
 	m_boardParameters = new EnglishBoard;
-	m_lexiconParameters = new LexiconParameters;
+	m_lexiconParameters = make_shared<LexiconParameters>();
 	m_strategyParameters = new StrategyParameters;
 }
 
 DataManager::~DataManager()
 {
-	delete m_evaluator;
-	delete m_parameters;
-	delete m_alphabetParameters;
-	delete m_boardParameters;
-	delete m_lexiconParameters;
-	delete m_strategyParameters;
+	{
+		DataManagerScope scope(this);
 
-	cleanupComputerPlayers();
+		delete m_evaluator;
+		delete m_parameters;
+		delete m_alphabetParameters;
+		delete m_boardParameters;
+		m_lexiconParameters.reset();
+		delete m_strategyParameters;
+		delete m_analysisCache;
+
+		cleanupComputerPlayers();
+	}
+
+	if (m_self == this)
+		m_self = 0;
 }
 
 bool DataManager::isGood() const
@@ -98,7 +114,11 @@ void DataManager::setBoardParameters(BoardParameters *boardParameters)
 
 void DataManager::setLexiconParameters(LexiconParameters *lexiconParameters)
 {
-	delete m_lexiconParameters;
+	m_lexiconParameters.reset(lexiconParameters);
+}
+
+void DataManager::setLexiconParameters(const shared_ptr<LexiconParameters> &lexiconParameters)
+{
 	m_lexiconParameters = lexiconParameters;
 }
 
@@ -108,6 +128,12 @@ void DataManager::setStrategyParameters(StrategyParameters *strategyParameters)
 	m_strategyParameters = strategyParameters;
 }
 
+void DataManager::setAnalysisCache(AnalysisCache *analysisCache)
+{
+	delete m_analysisCache;
+	m_analysisCache = analysisCache;
+}
+
 void DataManager::setComputerPlayers(const PlayerList &playerList)
 {
 	cleanupComputerPlayers();
@@ -192,6 +218,31 @@ void DataManager::seedRandomNumbers(seed_seq& seed)
 
 int DataManager::randomInteger(int low, int high)
 {
+	if (m_threadRng)
+		return uniform_int_distribution<>(low, high)(*m_threadRng);
+
 	lock_guard<mutex> lock(m_RngMutex);
 	return uniform_int_distribution<>(low, high)(m_mersenneTwisterRng);
 }
+
+DataManagerScope::DataManagerScope(DataManager *dataManager)
+	: m_previous(DataManager::m_current)
+{
+	DataManager::m_current = dataManager;
+}
+
+DataManagerScope::~DataManagerScope()
+{
+	DataManager::m_current = m_previous;
+}
+
+RandomNumberScope::RandomNumberScope(seed_seq &seed)
+	: m_rng(seed), m_previous(DataManager::m_threadRng)
+{
+	DataManager::m_threadRng = &m_rng;
+}
+
+RandomNumberScope::~RandomNumberScope()
+{
+	DataManager::m_threadRng = m_previous;
+}
@@ -19,6 +19,7 @@
 #ifndef QUACKLE_DATAMANAGER_H
 #define QUACKLE_DATAMANAGER_H
 
+#include <memory>
 #include <mutex>
 #include <random>
 #include <string>
@@ -36,6 +37,7 @@ using namespace std;
 #define QUACKLE_LEXICON_PARAMETERS Quackle::DataManager::self()->lexiconParameters()
 #define QUACKLE_STRATEGY_PARAMETERS Quackle::DataManager::self()->strategyParameters()
 #define QUACKLE_COMPUTER_PLAYERS Quackle::DataManager::self()->computerPlayers()
+#define QUACKLE_ANALYSIS_CACHE Quackle::DataManager::self()->analysisCache()
 
 namespace Quackle
 {
@@ -43,9 +45,13 @@ namespace Quackle
 // General singleton type that will be around whenever
 // you use libquackle.
 // It provides access to lexica (todo), random numbers,
-// and all parameters for a game
+// and all parameters for a game.
+// The first data manager made is the process's default. Others can
+// be made current on a thread with a DataManagerScope, so one
+// process can analyze with several lexica or rulesets at once.
 
 class AlphabetParameters;
+class AnalysisCache;
 class BoardParameters;
 class Evaluator;
 class GameParameters;
@@ -62,6 +68,7 @@ public:
 
 	~DataManager();
 
+	// the data manager current on this thread, or else the default
 	static DataManager *self();
 	static bool exists();
 
@@ -86,9 +93,20 @@ public:
 	LexiconParameters *lexiconParameters();
 	void setLexiconParameters(LexiconParameters *lexiconParameters);
 
+	// Lexica are big and only read once loaded, so data managers for
+	// the same lexicon can share one. Don't reload a shared lexicon
+	// while another thread might be using it.
+	shared_ptr<LexiconParameters> sharedLexiconParameters() const;
+	void setLexiconParameters(const shared_ptr<LexiconParameters> &lexiconParameters);
+
 	StrategyParameters *strategyParameters();
 	void setStrategyParameters(StrategyParameters *strategyParameters);
 
+	// Optional cache of analysis that outlives the program; null
+	// unless set. Owned and deleted by this data manager.
+	AnalysisCache *analysisCache();
+	void setAnalysisCache(AnalysisCache *analysisCache);
+
 	// When the data manager dies or setComputerPlayers is called, it deletes
 	// all of the computer players pointed to by the players in this list. The
 	// players' names are the names of the computer players, and the players'
@@ -125,10 +143,18 @@ public:
 
 	void seedRandomNumbers(unsigned int seed);
 	void seedRandomNumbers(seed_seq& seed);
+
+	// draws from the calling thread's RandomNumberScope if it has one,
+	// or else from this data manager's generator
 	int randomInteger(int low, int high);
 
 private:
+	friend class DataManagerScope;
+	friend class RandomNumberScope;
+
 	static DataManager *m_self;
+	static thread_local DataManager *m_current;
+	static thread_local mt19937_64 *m_threadRng;
 
 	bool fileExists(const string &filename);
 
@@ -143,8 +169,9 @@ private:
 	GameParameters *m_parameters;
 	AlphabetParameters *m_alphabetParameters;
 	BoardParameters *m_boardParameters;
-	LexiconParameters *m_lexiconParameters;
+	shared_ptr<LexiconParameters> m_lexiconParameters;
 	StrategyParameters *m_strategyParameters;
+	AnalysisCache *m_analysisCache;
 
 	PlayerList m_computerPlayers;
 
@@ -154,12 +181,12 @@ private:
 
 inline DataManager *DataManager::self()
 {
-	return m_self;
+	return m_current? m_current : m_self;
 }
 
 inline bool DataManager::exists()
 {
-	return m_self != 0;
+	return self() != 0;
 }
 
 inline Evaluator *DataManager::evaluator()
@@ -183,6 +210,11 @@ inline BoardParameters *DataManager::boardParameters()
 }
 
 inline LexiconParameters *DataManager::lexiconParameters()
+{
+	return m_lexiconParameters.get();
+}
+
+inline shared_ptr<LexiconParameters> DataManager::sharedLexiconParameters() const
 {
 	return m_lexiconParameters;
 }
@@ -192,11 +224,50 @@ inline StrategyParameters *DataManager::strategyParameters()
 	return m_strategyParameters;
 }
 
+inline AnalysisCache *DataManager::analysisCache()
+{
+	return m_analysisCache;
+}
+
 inline const PlayerList &DataManager::computerPlayers() const
 {
 	return m_computerPlayers;
 }
 
+// Makes dataManager current on the calling thread, and so what the
+// QUACKLE_* macros there refer to, until the scope ends. Threads
+// started meanwhile don't inherit it and need scopes of their own.
+class DataManagerScope
+{
+public:
+	explicit DataManagerScope(DataManager *dataManager);
+	~DataManagerScope();
+
+	DataManagerScope(const DataManagerScope &) = delete;
+	DataManagerScope &operator=(const DataManagerScope &) = delete;
+
+private:
+	DataManager *m_previous;
+};
+
+// Gives the calling thread a generator of its own, seeded with seed,
+// until the scope ends. Random numbers drawn on the thread meanwhile
+// depend only on the seed and not on what other threads draw, so
+// games played on many threads at once can each be replayed.
+class RandomNumberScope
+{
+public:
+	explicit RandomNumberScope(seed_seq &seed);
+	~RandomNumberScope();
+
+	RandomNumberScope(const RandomNumberScope &) = delete;
+	RandomNumberScope &operator=(const RandomNumberScope &) = delete;
+
+private:
+	mt19937_64 m_rng;
+	mt19937_64 *m_previous;
+};
+
 }
 
 #endif
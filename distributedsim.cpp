@@ -0,0 +1,514 @@
+/*
+ *  Quackle -- Crossword game artificial intelligence and analysis tool
+ *  Copyright (C) 2005-2019 Jason Katz-Brown, John O'Laughlin, and John Fultz.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#ifndef _WIN32
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#include "binaryio.h"
+#include "computerplayer.h"
+#include "datamanager.h"
+#include "distributedsim.h"
+#include "game.h"
+#include "lexiconparameters.h"
+#include "sim.h"
+
+using namespace Quackle;
+
+#ifndef _WIN32
+
+namespace
+{
+
+// frames bigger than this are taken to be garbage
+const uint32_t maximumFrameLength = 1 << 28;
+
+bool sendAll(int fd, const char *data, size_t length)
+{
+#ifdef MSG_NOSIGNAL
+	const int flags = MSG_NOSIGNAL;
+#else
+	const int flags = 0;
+#endif
+
+	while (length > 0)
+	{
+		const ssize_t sent = ::send(fd, data, length, flags);
+		if (sent <= 0)
+			return false;
+		data += sent;
+		length -= sent;
+	}
+
+	return true;
+}
+
+bool receiveAll(int fd, char *data, size_t length)
+{
+	while (length > 0)
+	{
+		const ssize_t received = ::recv(fd, data, length, 0);
+		if (received <= 0)
+			return false;
+		data += received;
+		length -= received;
+	}
+
+	return true;
+}
+
+// Frames are a little-endian 32-bit length followed by the payload,
+// whose first byte is a DistributedSimulator::MessageType.
+bool sendFrame(int fd, const string &payload)
+{
+	BinaryWriter header;
+	header.writeU32(payload.size());
+	return sendAll(fd, header.data().data(), header.data().size()) && sendAll(fd, payload.data(), payload.size());
+}
+
+bool receiveFrame(int fd, string *payload)
+{
+	char header[4];
+	if (!receiveAll(fd, header, sizeof(header)))
+		return false;
+
+	BinaryReader reader(header, sizeof(header));
+	const uint32_t length = reader.readU32();
+	if (length == 0 || length > maximumFrameLength)
+		return false;
+
+	payload->resize(length);
+	return receiveAll(fd, &(*payload)[0], length);
+}
+
+void ignoreSigpipe(int fd)
+{
+#ifdef SO_NOSIGPIPE
+	int on = 1;
+	setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#else
+	(void)fd;
+#endif
+}
+
+bool socketAddress(const string &socketPath, sockaddr_un *address)
+{
+	memset(address, 0, sizeof(*address));
+	address->sun_family = AF_UNIX;
+	if (socketPath.empty() || socketPath.size() >= sizeof(address->sun_path))
+		return false;
+
+	socketPath.copy(address->sun_path, socketPath.size());
+	return true;
+}
+
+string reply(DistributedSimulator::MessageType type, uint32_t unitId, const string &body)
+{
+	BinaryWriter writer;
+	writer.writeU8(type);
+	writer.writeU32(unitId);
+	writer.writeString(body);
+	return writer.data();
+}
+
+}
+
+SimulationWorker::SimulationWorker()
+	: m_unitsDone(0)
+{
+}
+
+bool SimulationWorker::connectAndServe(const string &socketPath)
+{
+	sockaddr_un address;
+	if (!socketAddress(socketPath, &address))
+		return false;
+
+	const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd < 0)
+		return false;
+
+	ignoreSigpipe(fd);
+
+	bool ret = false;
+	if (::connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) == 0)
+		ret = serve(fd);
+
+	::close(fd);
+	return ret;
+}
+
+bool SimulationWorker::serve(int fd)
+{
+	string frame;
+	while (receiveFrame(fd, &frame))
+	{
+		switch (static_cast<uint8_t>(frame[0]))
+		{
+		case DistributedSimulator::WorkUnitMessage:
+			if (!sendFrame(fd, work(frame)))
+				return false;
+			break;
+
+		case DistributedSimulator::ShutdownMessage:
+			return true;
+
+		default:
+			return false;
+		}
+	}
+
+	return false;
+}
+
+string SimulationWorker::work(const string &unit)
+{
+	BinaryReader reader(unit);
+	reader.readU8();
+	const uint32_t unitId = reader.readU32();
+	const int iterations = reader.readI32();
+	const unsigned int seed = reader.readU32();
+
+	if (reader.readString() != QUACKLE_LEXICON_PARAMETERS->hashString(false))
+		return reply(DistributedSimulator::FailedMessage, unitId, "lexicon mismatch");
+
+	GamePosition position((PlayerList()));
+	if (!position.deserialize(reader))
+		return reply(DistributedSimulator::FailedMessage, unitId, "corrupt position");
+
+	const int plies = reader.readI32();
+	const bool ignoreOppos = reader.readU8();
+	const Rack partialOppoRack(reader.readLetters());
+
+	ProbableRackList leaves;
+	const unsigned int leaveCount = reader.readU32();
+	for (unsigned int i = 0; i < leaveCount && reader.ok(); ++i)
+	{
+		ProbableRack leave;
+		leave.rack = Rack(reader.readLetters());
+		leave.probability = reader.readDouble();
+		leave.possibility = reader.readDouble();
+		leaves.push_back(leave);
+	}
+
+	if (!reader.ok() || !reader.atEnd())
+		return reply(DistributedSimulator::FailedMessage, unitId, "corrupt work unit");
+
+	Simulator simulator;
+	simulator.setPosition(position);
+	simulator.setIgnoreOppos(ignoreOppos);
+	simulator.setPartialOppoRack(partialOppoRack);
+	if (!leaves.empty())
+		simulator.setInferredOppoLeaves(leaves);
+
+	QUACKLE_DATAMANAGER->seedRandomNumbers(seed);
+	simulator.simulate(plies, iterations);
+
+	++m_unitsDone;
+	return reply(DistributedSimulator::ResultMessage, unitId, simulator.serializeState());
+}
+
+DistributedSimulator::DistributedSimulator(Simulator &simulator)
+	: m_simulator(simulator), m_listenFd(-1), m_nextUnitId(0)
+{
+}
+
+DistributedSimulator::~DistributedSimulator()
+{
+	shutdownWorkers();
+	close();
+}
+
+bool DistributedSimulator::listen(const string &socketPath)
+{
+	close();
+
+	sockaddr_un address;
+	if (!socketAddress(socketPath, &address))
+		return false;
+
+	m_listenFd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+	if (m_listenFd < 0)
+		return false;
+
+	::unlink(socketPath.c_str());
+	if (::bind(m_listenFd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0 || ::listen(m_listenFd, SOMAXCONN) != 0)
+	{
+		::close(m_listenFd);
+		m_listenFd = -1;
+		return false;
+	}
+
+	m_socketPath = socketPath;
+	return true;
+}
+
+void DistributedSimulator::close()
+{
+	if (m_listenFd < 0)
+		return;
+
+	::close(m_listenFd);
+	::unlink(m_socketPath.c_str());
+	m_listenFd = -1;
+	m_socketPath.clear();
+}
+
+void DistributedSimulator::acceptWorker()
+{
+	const int fd = ::accept(m_listenFd, 0, 0);
+	if (fd < 0)
+		return;
+
+	ignoreSigpipe(fd);
+
+	Worker worker;
+	worker.fd = fd;
+	worker.unit = -1;
+	m_workers.push_back(worker);
+}
+
+void DistributedSimulator::dropWorker(size_t index, vector<int> *pending)
+{
+	if (pending && m_workers[index].unit >= 0)
+		pending->push_back(m_workers[index].unit);
+
+	::close(m_workers[index].fd);
+	m_workers.erase(m_workers.begin() + index);
+}
+
+bool DistributedSimulator::waitForWorkers(int count, int timeoutSeconds)
+{
+	if (m_listenFd < 0)
+		return false;
+
+	const auto deadline = chrono::steady_clock::now() + chrono::seconds(timeoutSeconds);
+	while (workerCount() < count)
+	{
+		const auto left = chrono::duration_cast<chrono::milliseconds>(deadline - chrono::steady_clock::now()).count();
+		if (left <= 0)
+			break;
+
+		pollfd listener = { m_listenFd, POLLIN, 0 };
+		if (::poll(&listener, 1, left) > 0 && (listener.revents & POLLIN))
+			acceptWorker();
+	}
+
+	return workerCount() >= count;
+}
+
+bool DistributedSimulator::simulate(int plies, int iterations, int iterationsPerUnit, unsigned int seed)
+{
+	if (iterations <= 0)
+		return true;
+
+	if (!m_simulator.hasSimulationResults())
+		m_simulator.resumeFromAnalysisCache(plies);
+
+	// workers only need to see the moves still in the running
+	GamePosition position(m_simulator.currentPosition());
+	MoveList included;
+	for (const auto &it : m_simulator.simmedMoves())
+		if (it.includeInSimulation())
+			included.push_back(it.move);
+	position.setMoves(included);
+
+	BinaryWriter common;
+	common.writeString(QUACKLE_LEXICON_PARAMETERS->hashString(false));
+	position.serialize(common);
+	common.writeI32(plies);
+	common.writeU8(m_simulator.ignoreOppos());
+	common.writeLetters(m_simulator.partialOppoRack().tiles());
+	common.writeU32(m_simulator.inferredOppoLeaves().size());
+	for (const auto &it : m_simulator.inferredOppoLeaves())
+	{
+		common.writeLetters(it.rack.tiles());
+		common.writeDouble(it.probability);
+		common.writeDouble(it.possibility);
+	}
+
+	iterationsPerUnit = max(iterationsPerUnit, 1);
+	const int unitCount = (iterations + iterationsPerUnit - 1) / iterationsPerUnit;
+
+	// unit ids are unique across calls so that results still owed
+	// from an aborted call can be told apart and thrown away
+	const int firstUnitId = m_nextUnitId;
+	m_nextUnitId += unitCount;
+
+	vector<int> pending;
+	for (int i = unitCount - 1; i >= 0; --i)
+		pending.push_back(firstUnitId + i);
+
+	int remaining = unitCount;
+	bool complete = true;
+
+	while (remaining > 0)
+	{
+		if (m_simulator.dispatch() && m_simulator.dispatch()->shouldAbort())
+		{
+			complete = false;
+			break;
+		}
+
+		for (size_t i = m_workers.size(); i-- > 0; )
+		{
+			if (m_workers[i].unit >= 0 || pending.empty())
+				continue;
+
+			const int unitId = pending.back();
+			const int unitIndex = unitId - firstUnitId;
+			const int unitIterations = min(iterationsPerUnit, iterations - unitIndex * iterationsPerUnit);
+
+			BinaryWriter header;
+			header.writeU8(WorkUnitMessage);
+			header.writeU32(unitId);
+			header.writeI32(unitIterations);
+			header.writeU32(seed + unitIndex);
+
+			pending.pop_back();
+			m_workers[i].unit = unitId;
+			if (!sendFrame(m_workers[i].fd, header.data() + common.data()))
+				dropWorker(i, &pending);
+		}
+
+		if (m_workers.empty())
+		{
+			complete = false;
+			break;
+		}
+
+		vector<pollfd> fds;
+		for (const auto &it : m_workers)
+			fds.push_back(pollfd{ it.fd, POLLIN, 0 });
+		if (m_listenFd >= 0)
+			fds.push_back(pollfd{ m_listenFd, POLLIN, 0 });
+
+		if (::poll(fds.data(), fds.size(), 100) <= 0)
+			continue;
+
+		for (size_t i = m_workers.size(); i-- > 0; )
+		{
+			if (!fds[i].revents)
+				continue;
+
+			string frame;
+			if (!receiveFrame(m_workers[i].fd, &frame))
+			{
+				dropWorker(i, &pending);
+				continue;
+			}
+
+			BinaryReader reader(frame);
+			const uint8_t type = reader.readU8();
+			const int unitId = reader.readU32();
+			const string state = reader.readString();
+			if (!reader.ok() || unitId != m_workers[i].unit)
+			{
+				dropWorker(i, &pending);
+				continue;
+			}
+
+			m_workers[i].unit = -1;
+			if (unitId < firstUnitId)
+				continue;
+
+			--remaining;
+			if (type != ResultMessage || !m_simulator.mergeState(state, false))
+				complete = false;
+		}
+
+		if (m_listenFd >= 0 && (fds.back().revents & POLLIN))
+			acceptWorker();
+
+		if (m_simulator.dispatch())
+			m_simulator.dispatch()->signalFractionDone(static_cast<double>(unitCount - remaining) / unitCount);
+	}
+
+	m_simulator.storeInAnalysisCache();
+	return complete && remaining == 0;
+}
+
+void DistributedSimulator::shutdownWorkers()
+{
+	BinaryWriter shutdown;
+	shutdown.writeU8(ShutdownMessage);
+
+	while (!m_workers.empty())
+	{
+		sendFrame(m_workers.back().fd, shutdown.data());
+		dropWorker(m_workers.size() - 1, 0);
+	}
+}
+
+#else // _WIN32
+
+SimulationWorker::SimulationWorker()
+	: m_unitsDone(0)
+{
+}
+
+bool SimulationWorker::serve(int)
+{
+	return false;
+}
+
+bool SimulationWorker::connectAndServe(const string &)
+{
+	return false;
+}
+
+DistributedSimulator::DistributedSimulator(Simulator &simulator)
+	: m_simulator(simulator), m_listenFd(-1), m_nextUnitId(0)
+{
+}
+
+DistributedSimulator::~DistributedSimulator()
+{
+}
+
+bool DistributedSimulator::listen(const string &)
+{
+	return false;
+}
+
+void DistributedSimulator::close()
+{
+}
+
+bool DistributedSimulator::waitForWorkers(int, int)
+{
+	return false;
+}
+
+bool DistributedSimulator::simulate(int, int, int, unsigned int)
+{
+	return false;
+}
+
+void DistributedSimulator::shutdownWorkers()
+{
+}
+
+#endif // _WIN32
@@ -0,0 +1,128 @@
+/*
+ *  Quackle -- Crossword game artificial intelligence and analysis tool
+ *  Copyright (C) 2005-2019 Jason Katz-Brown, John O'Laughlin, and John Fultz.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QUACKLE_DISTRIBUTEDSIM_H
+#define QUACKLE_DISTRIBUTEDSIM_H
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace Quackle
+{
+
+class Simulator;
+
+// Runs chunks of simulations for a DistributedSimulator, usually in
+// another process on this machine. The worker must have loaded the
+// same lexicon and parameters as the simulator it serves, and should
+// not have an analysis cache open or cached iterations would be
+// counted twice.
+class SimulationWorker
+{
+public:
+	SimulationWorker();
+
+	// Answers work units on a connected socket until the simulator
+	// shuts us down. Returns false if the connection breaks first.
+	bool serve(int fd);
+
+	// Connects to the simulator listening at socketPath and serves it.
+	bool connectAndServe(const string &socketPath);
+
+	// number of work units simulated so far
+	int unitsDone() const;
+
+private:
+	string work(const string &unit);
+
+	int m_unitsDone;
+};
+
+// Spreads the iterations of a Simulator's simulation across
+// SimulationWorkers connected over a Unix domain socket. Every work
+// unit is given its own random seed and its results are merged into
+// the simulator as they come back; units held by a worker that dies
+// are handed to another. Only available on POSIX systems.
+class DistributedSimulator
+{
+public:
+	DistributedSimulator(Simulator &simulator);
+	~DistributedSimulator();
+
+	// Listens for workers at socketPath, replacing any stale socket
+	// file there. Returns false if the socket can't be set up.
+	bool listen(const string &socketPath);
+	bool isListening() const;
+
+	// Accepts workers until count are connected or timeoutSeconds
+	// pass. Returns true if count workers are connected.
+	bool waitForWorkers(int count, int timeoutSeconds);
+	int workerCount() const;
+
+	// Runs iterations more iterations of the simulator's included
+	// moves on the workers, iterationsPerUnit at a time, seeding unit
+	// i with seed + i. Honors the simulator's dispatch. Returns false
+	// if some iterations didn't complete, because of an abort, a
+	// failing work unit or all workers going away.
+	bool simulate(int plies, int iterations, int iterationsPerUnit, unsigned int seed);
+
+	// Asks all workers to exit and hangs up on them.
+	void shutdownWorkers();
+
+	// Stops listening and removes the socket file.
+	void close();
+
+	enum MessageType { WorkUnitMessage = 1, ResultMessage = 2, ShutdownMessage = 3, FailedMessage = 4 };
+
+private:
+	struct Worker
+	{
+		int fd;
+		int unit;
+	};
+
+	void acceptWorker();
+	void dropWorker(size_t index, vector<int> *pending);
+
+	Simulator &m_simulator;
+	string m_socketPath;
+	int m_listenFd;
+	int m_nextUnitId;
+	vector<Worker> m_workers;
+};
+
+inline int SimulationWorker::unitsDone() const
+{
+	return m_unitsDone;
+}
+
+inline bool DistributedSimulator::isListening() const
+{
+	return m_listenFd >= 0;
+}
+
+inline int DistributedSimulator::workerCount() const
+{
+	return m_workers.size();
+}
+
+}
+
+#endif
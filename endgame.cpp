@@ -21,6 +21,7 @@
 
 #include "computerplayer.h"
 #include "endgame.h"
+#include "enginecontext.h"
 #include "game.h"
 #include "move.h"
 
@@ -203,6 +204,7 @@ double Endgame::disappoint(EndgameMove &hope, double bestPessimistic)
 	MoveList moves = m_endgameGame.currentPosition().moves();
 	
 	MoveList::const_iterator moveIt = moves.begin();
+	const EngineContext context;
 
 #ifdef DEBUG_ENDGAME		
 	UVcout << "    disappoint's moves has " << moves.size() << " moves." << endl;
@@ -233,7 +235,7 @@ double Endgame::disappoint(EndgameMove &hope, double bestPessimistic)
 				if (playerId == startPlayerId && levelNumber == 1)
 					move = (*moveIt);
 				else
-					move = m_endgameGame.currentPosition().staticBestMove();
+					move = m_endgameGame.currentPosition().staticBestMove(context);
 				
 #ifdef DEBUG_ENDGAME
 				UVcout << "      level:" << levelNumber << ", player: " << playerId << ", move: " << move << ", score: " << move.score << ", equity: " << move.equity << endl;
@@ -288,6 +290,7 @@ Move Endgame::solve(int /* nestedness */)
 	double bestPessimistic = -1000;
 	EndgameMove bestPessMove(Move::createNonmove());
 	
+	const EngineContext context;
 	EndgameMoveList::iterator moveEnd = m_endgameMoves.end();
 	for (EndgameMoveList::iterator moveIt = m_endgameMoves.begin(); moveIt != moveEnd; ++moveIt)
 	{
@@ -321,7 +324,7 @@ Move Endgame::solve(int /* nestedness */)
 				if (playerId == startPlayerId && levelNumber == 1)
 					move = (*moveIt).move;
 				else
-					move = m_endgameGame.currentPosition().staticBestMove();
+					move = m_endgameGame.currentPosition().staticBestMove(context);
 				
 #ifdef DEBUG_ENDGAME
 				UVcout << "    level:" << levelNumber << ", player: " << playerId << ", move: " << move << ", score: " << move.score << ", equity: " << move.equity << endl;
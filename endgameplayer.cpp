@@ -18,6 +18,8 @@
 
 #include <iostream>
 
+#include "analysiscache.h"
+#include "datamanager.h"
 #include "endgameplayer.h"
 
 //#define DEBUG_COMPUTERPLAYER
@@ -62,8 +64,19 @@ MoveList EndgamePlayer::moves(int nmoves)
 	UVcout << currentPosition() << endl;
 #endif
 
+	AnalysisCache *cache = QUACKLE_ANALYSIS_CACHE;
+	const bool useCache = cache && currentPosition().nestedness() == 0;
+
 	MoveList ret;
-	Move solution = m_endgame.solve(currentPosition().nestedness());
+	Move solution;
+	if (!useCache || !cache->findEndgame(currentPosition(), &solution))
+	{
+		solution = m_endgame.solve(currentPosition().nestedness());
+
+		// an aborted solve isn't worth remembering
+		if (useCache && !shouldAbort())
+			cache->storeEndgame(currentPosition(), solution);
+	}
 
 	ret.push_back(solution);
 #ifdef DEBUG_ENDGAME
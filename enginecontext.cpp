@@ -0,0 +1,64 @@
+/*
+ *  Quackle -- Crossword game artificial intelligence and analysis tool
+ *  Copyright (C) 2005-2019 Jason Katz-Brown, John O'Laughlin, and John Fultz.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "enginecontext.h"
+#include "boardparameters.h"
+#include "datamanager.h"
+#include "gameparameters.h"
+
+using namespace Quackle;
+
+EngineContext::EngineContext()
+{
+	snapshot();
+}
+
+void EngineContext::snapshot()
+{
+	const AlphabetParameters *alphabet = QUACKLE_ALPHABET_PARAMETERS;
+	m_lastLetter = alphabet->lastLetter();
+	for (int letter = 0; letter < letterSlots; ++letter)
+	{
+		// blanks designated as letters score nothing
+		const bool inAlphabet = letter <= m_lastLetter;
+		m_scores[letter] = inAlphabet? alphabet->score(letter) : 0;
+		m_vowels[letter] = inAlphabet && alphabet->isVowel(letter);
+	}
+
+	const BoardParameters *board = QUACKLE_BOARD_PARAMETERS;
+	m_width = board->width();
+	m_height = board->height();
+	m_startRow = board->startRow();
+	m_startColumn = board->startColumn();
+	// copied for every square the parameters have, not just the
+	// current size, as a board may be bigger than the parameters say
+	for (int row = 0; row < QUACKLE_MAXIMUM_BOARD_SIZE; ++row)
+	{
+		for (int column = 0; column < QUACKLE_MAXIMUM_BOARD_SIZE; ++column)
+		{
+			m_letterMultipliers[row * QUACKLE_MAXIMUM_BOARD_SIZE + column] = board->letterMultiplier(row, column);
+			m_wordMultipliers[row * QUACKLE_MAXIMUM_BOARD_SIZE + column] = board->wordMultiplier(row, column);
+		}
+	}
+
+	m_rackSize = QUACKLE_PARAMETERS->rackSize();
+	m_bingoBonus = QUACKLE_PARAMETERS->bingoBonus();
+
+	m_evaluator = QUACKLE_EVALUATOR;
+	m_lexicon = QUACKLE_LEXICON_PARAMETERS;
+}
@@ -0,0 +1,184 @@
+/*
+ *  Quackle -- Crossword game artificial intelligence and analysis tool
+ *  Copyright (C) 2005-2019 Jason Katz-Brown, John O'Laughlin, and John Fultz.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QUACKLE_ENGINECONTEXT_H
+#define QUACKLE_ENGINECONTEXT_H
+
+#include <cstdint>
+
+#include "alphabetparameters.h"
+#include "board.h"
+
+namespace Quackle
+{
+
+class Evaluator;
+class LexiconParameters;
+
+// A snapshot of the global parameters that move generation and
+// scoring read in their inner loops: letter scores and vowels, the
+// bonus squares, rack size and bingo bonus, the evaluator and the
+// lexicon. Tables are flat
+// arrays indexed by letter or square, so lookups skip the data
+// manager and AlphabetParameters' letter records. A snapshot doesn't
+// follow later changes to the globals; take a new one after those.
+class EngineContext
+{
+public:
+	// snapshots the data manager's current parameters
+	EngineContext();
+
+	void snapshot();
+
+	Letter lastLetter() const;
+	bool isBlankLetter(Letter letter) const;
+	bool isPlainLetter(Letter letter) const;
+	bool isSomeLetter(Letter letter) const;
+	Letter clearBlankness(Letter letter) const;
+	Letter setBlankness(Letter letter) const;
+
+	int score(Letter letter) const;
+	bool isVowel(Letter letter) const;
+
+	int width() const;
+	int height() const;
+	int startRow() const;
+	int startColumn() const;
+	int letterMultiplier(int row, int column) const;
+	int wordMultiplier(int row, int column) const;
+
+	int rackSize() const;
+	int bingoBonus() const;
+
+	const Evaluator *evaluator() const;
+	const LexiconParameters *lexicon() const;
+
+private:
+	enum { letterSlots = 256, squareSlots = QUACKLE_MAXIMUM_BOARD_SIZE * QUACKLE_MAXIMUM_BOARD_SIZE };
+
+	Letter m_lastLetter;
+	int16_t m_scores[letterSlots];
+	bool m_vowels[letterSlots];
+
+	int m_width;
+	int m_height;
+	int m_startRow;
+	int m_startColumn;
+	uint8_t m_letterMultipliers[squareSlots];
+	uint8_t m_wordMultipliers[squareSlots];
+
+	int m_rackSize;
+	int m_bingoBonus;
+
+	const Evaluator *m_evaluator;
+	const LexiconParameters *m_lexicon;
+};
+
+inline Letter EngineContext::lastLetter() const
+{
+	return m_lastLetter;
+}
+
+inline bool EngineContext::isBlankLetter(Letter letter) const
+{
+	return letter > m_lastLetter;
+}
+
+inline bool EngineContext::isPlainLetter(Letter letter) const
+{
+	return letter >= QUACKLE_FIRST_LETTER && letter <= m_lastLetter;
+}
+
+inline bool EngineContext::isSomeLetter(Letter letter) const
+{
+	return letter >= QUACKLE_FIRST_LETTER;
+}
+
+inline Letter EngineContext::clearBlankness(Letter letter) const
+{
+	return isBlankLetter(letter)? letter - QUACKLE_BLANK_OFFSET : letter;
+}
+
+inline Letter EngineContext::setBlankness(Letter letter) const
+{
+	return isBlankLetter(letter)? letter : letter + QUACKLE_BLANK_OFFSET;
+}
+
+inline int EngineContext::score(Letter letter) const
+{
+	return m_scores[letter];
+}
+
+inline bool EngineContext::isVowel(Letter letter) const
+{
+	return m_vowels[letter];
+}
+
+inline int EngineContext::width() const
+{
+	return m_width;
+}
+
+inline int EngineContext::height() const
+{
+	return m_height;
+}
+
+inline int EngineContext::startRow() const
+{
+	return m_startRow;
+}
+
+inline int EngineContext::startColumn() const
+{
+	return m_startColumn;
+}
+
+inline int EngineContext::letterMultiplier(int row, int column) const
+{
+	return m_letterMultipliers[row * QUACKLE_MAXIMUM_BOARD_SIZE + column];
+}
+
+inline int EngineContext::wordMultiplier(int row, int column) const
+{
+	return m_wordMultipliers[row * QUACKLE_MAXIMUM_BOARD_SIZE + column];
+}
+
+inline int EngineContext::rackSize() const
+{
+	return m_rackSize;
+}
+
+inline int EngineContext::bingoBonus() const
+{
+	return m_bingoBonus;
+}
+
+inline const Evaluator *EngineContext::evaluator() const
+{
+	return m_evaluator;
+}
+
+inline const LexiconParameters *EngineContext::lexicon() const
+{
+	return m_lexicon;
+}
+
+}
+
+#endif
@@ -17,6 +17,7 @@
  */
 
 #include <algorithm>
+#include <cstring>
 #include <iostream>
 
 #include "enumerator.h"
@@ -50,14 +51,7 @@ void Enumerator::normalizeProbabilities(ProbableRackList *racks)
 void Enumerator::enumerate(ProbableRackList *racks, unsigned int rackSize)
 {
 	racks->clear();
-
-	m_bag.letterCounts(m_bagcounts);
-
-	m_possibleBag = m_bag;
-	
-	recurse(LetterString(), 0, 0, racks, rackSize);
-
-	normalizeProbabilities(racks);
+	enumerate([racks](const ProbableRack &rack) { racks->push_back(rack); }, rackSize);
 }
 
 void Enumerator::enumerate(ProbableRackList *racks)
@@ -68,42 +62,81 @@ void Enumerator::enumerate(ProbableRackList *racks)
 void Enumerator::enumeratePossible(ProbableRackList *racks, const Bag &bag)
 {
 	racks->clear();
+	enumeratePossible([racks](const ProbableRack &rack) { racks->push_back(rack); }, bag, QUACKLE_PARAMETERS->rackSize());
+}
+
+void Enumerator::enumerate(const ProbableRackCallback &callback, unsigned int rackSize)
+{
+	m_bag.letterCounts(m_bagcounts);
+	memcpy(m_possiblecounts, m_bagcounts, sizeof(m_bagcounts));
+
+	start(callback, rackSize);
+}
 
+void Enumerator::enumeratePossible(const ProbableRackCallback &callback, const Bag &bag, unsigned int rackSize)
+{
 	m_bag.letterCounts(m_bagcounts);
 
-	//UVcout << "enumeratePossible called with bag: " << bag << endl;
+	Bag possibleBag(m_bag);
+	possibleBag.removeLetters(bag.tiles());
+	possibleBag.letterCounts(m_possiblecounts);
 
-	m_possibleBag = m_bag;
-	m_possibleBag.removeLetters(bag.tiles());
+	start(callback, rackSize);
+}
 
-	//UVcout << "m_bag: " << m_bag << endl;
-	//UVcout << "m_possibleBag: " << m_possibleBag << endl;
+void Enumerator::start(const ProbableRackCallback &callback, unsigned int rackSize)
+{
+	m_lastLetter = QUACKLE_ALPHABET_PARAMETERS->lastLetter();
+
+	int bagSize = 0;
+	int possibleSize = 0;
+	m_tilesFrom[m_lastLetter + 1] = 0;
+	for (int letter = m_lastLetter; letter >= 0; --letter)
+	{
+		m_tilesFrom[letter] = m_tilesFrom[letter + 1] + m_bagcounts[letter];
+		bagSize += m_bagcounts[letter];
+		possibleSize += m_possiblecounts[letter];
+	}
 
-	recurse(LetterString(), 0, 0, racks, QUACKLE_PARAMETERS->rackSize());
+	// Summed over every rack, the number of ways to draw each one is
+	// just the number of ways to draw rackSize tiles from the whole
+	// bag, so we can normalize as we go rather than after the fact.
+	m_probabilityTotal = Bag::choose(bagSize, rackSize);
+	m_possibilityTotal = Bag::choose(possibleSize, rackSize);
 
-	normalizeProbabilities(racks);
+	if (m_probabilityTotal == 0)
+		return;
 
+	m_prefix.clear();
+	m_callback = &callback;
+	recurse(0, rackSize, 1, 1);
 }
 
-void Enumerator::recurse(LetterString prefix, int i, Letter start, ProbableRackList *racks, unsigned int rackSize)
+void Enumerator::recurse(Letter letter, unsigned int remaining, double probability, double possibility)
 {
-	if (prefix.length() == rackSize)
+	if (remaining == 0)
 	{
 		ProbableRack probableRack;
-		probableRack.rack = Rack(prefix);
-		probableRack.probability = m_bag.probabilityOfDrawing(probableRack.rack.tiles());
-		probableRack.possibility = m_possibleBag.probabilityOfDrawing(probableRack.rack.tiles());
-		racks->push_back(probableRack);
+		probableRack.rack = Rack(m_prefix);
+		probableRack.probability = probability / m_probabilityTotal;
+		probableRack.possibility = m_possibilityTotal > 0? possibility / m_possibilityTotal : 0;
+		(*m_callback)(probableRack);
 		return;
 	}
 
-	for (Letter c = start; c <= QUACKLE_ALPHABET_PARAMETERS->lastLetter(); ++i, ++c)
+	if (letter > m_lastLetter || m_tilesFrom[letter] < (int)remaining)
+		return;
+
+	// take as many of this letter as we can first so racks come out in
+	// the same sorted order as before
+	const int most = min((int)m_bagcounts[letter], (int)remaining);
+	for (int i = 0; i < most; ++i)
+		m_prefix.push_back(letter);
+
+	for (int i = most; i >= 0; --i)
 	{
-		if (m_bagcounts[i] > 0)
-		{
-			m_bagcounts[i]--;
-			recurse(prefix + c, i, c, racks, rackSize);
-			m_bagcounts[i]++;
-		}
+		recurse(letter + 1, remaining - i, probability * Bag::choose(m_bagcounts[letter], i), possibility * Bag::choose(m_possiblecounts[letter], i));
+		if (i > 0)
+			m_prefix.pop_back();
 	}
 }
@@ -19,6 +19,7 @@
 #ifndef QUACKLE_ENUMERATOR_H
 #define QUACKLE_ENUMERATOR_H
 
+#include <functional>
 #include <vector>
 
 #include "bag.h"
@@ -36,6 +37,7 @@ struct ProbableRack
 	double possibility;
 };
 typedef vector<ProbableRack> ProbableRackList;
+typedef std::function<void (const ProbableRack &)> ProbableRackCallback;
 
 class Enumerator
 {
@@ -49,14 +51,32 @@ public:
 	void enumerate(ProbableRackList *racks);
 	void enumeratePossible(ProbableRackList *racks, const Bag &bag);
 
+	// Streaming versions of the above. Each rack is handed to the
+	// callback as soon as it is found and is not stored anywhere;
+	// probabilities and possibilities passed along already sum to 1.
+	void enumerate(const ProbableRackCallback &callback, unsigned int rackSize);
+	void enumeratePossible(const ProbableRackCallback &callback, const Bag &bag, unsigned int rackSize);
+
 	// makes all of the probabilities sum to 1
 	static void normalizeProbabilities(ProbableRackList *racks);
 
 private:	
-	void recurse(LetterString prefix, int i, Letter start, ProbableRackList *racks, unsigned int rackSize);
+	void start(const ProbableRackCallback &callback, unsigned int rackSize);
+	void recurse(Letter letter, unsigned int remaining, double probability, double possibility);
+
+	// how many of each letter are in the bag and in the bag we deem
+	// possible, and how many tiles of the bag are at or after each letter
 	char m_bagcounts[QUACKLE_FIRST_LETTER + QUACKLE_MAXIMUM_ALPHABET_SIZE];
+	char m_possiblecounts[QUACKLE_FIRST_LETTER + QUACKLE_MAXIMUM_ALPHABET_SIZE];
+	int m_tilesFrom[QUACKLE_FIRST_LETTER + QUACKLE_MAXIMUM_ALPHABET_SIZE + 1];
+
+	Letter m_lastLetter;
+	LetterString m_prefix;
+	double m_probabilityTotal;
+	double m_possibilityTotal;
+	const ProbableRackCallback *m_callback;
+
 	Bag m_bag;
-	Bag m_possibleBag;
 };
 
 
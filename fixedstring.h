@@ -20,6 +20,8 @@
 #define QUACKLE_FIXEDSTRING_H
 
 #include <cassert>
+#include <cstdint>
+#include <functional>
 #include <string>
 #include <string.h>
 
@@ -28,6 +30,8 @@
 namespace Quackle
 {
 
+// Holds up to maxSize - 1 chars inline with a one-byte length, so it
+// is trivially copyable and copies are a fixed-size memcpy.
 class FixedLengthString 
 {
   public:
@@ -41,8 +45,6 @@ class FixedLengthString
     FixedLengthString(const char* s, size_type n);
     FixedLengthString(size_type n, char c);
     FixedLengthString(const char* s);
-    FixedLengthString(const FixedLengthString& s);
-    FixedLengthString(FixedLengthString&& s);
 
     const_iterator begin() const;
     const_iterator end() const;
@@ -53,25 +55,27 @@ class FixedLengthString
     FixedLengthString substr(size_type pos, size_type n) const;
     bool empty() const;
     size_type size() const { return length(); }
-    void clear() { m_end = m_data; }
+    void clear() { m_length = 0; }
     void push_back(char c);
     void pop_back();
     const char* constData() const { return m_data; }
 
     int compare(const FixedLengthString& s) const;
+    bool equals(const FixedLengthString& s) const;
+
+    // hash of the contents, for unordered containers
+    size_t hash() const;
 
     FixedLengthString& operator+=(char c);
     FixedLengthString& operator+=(const FixedLengthString& s);
 
     const_reference operator[](size_type n) const { return m_data[n]; }
-    FixedLengthString& operator=(const FixedLengthString &s);
 
     static const unsigned int maxSize = FIXED_STRING_MAXIMUM_LENGTH;
 
   private:
-    static const std::string dummyString; // just to get to traits
-    char m_data[maxSize];
-    char* m_end; // points at the terminating NULL
+    char m_data[maxSize - 1];
+    uint8_t m_length;
 };
 
 
@@ -101,7 +105,7 @@ operator+(const FixedLengthString &lhs, char rhs)
 
 inline
 FixedLengthString::FixedLengthString()
-    : m_end(m_data)
+    : m_length(0)
 {
 }
 
@@ -110,17 +114,15 @@ FixedLengthString::FixedLengthString(const char* s, size_type n)
 {
     assert(n < maxSize);
     memcpy(m_data, s, n);
-    m_end = m_data + n;
+    m_length = n;
 }
 
 inline
 FixedLengthString::FixedLengthString(size_type n, char c)
-    : m_end(m_data)
 {
     assert(n < maxSize);
-    for (unsigned int i = 0; i < n; ++i) {
-	*m_end++ = c;
-    }
+    memset(m_data, c, n);
+    m_length = n;
 }
 
 inline
@@ -129,32 +131,7 @@ FixedLengthString::FixedLengthString(const char* s)
     size_t sz = strlen(s);
     assert(sz < maxSize);
     memcpy(m_data, s, sz);
-    m_end = m_data + sz;
-}
-
-inline
-FixedLengthString::FixedLengthString(const FixedLengthString& s)
-{
-    int sz = s.size();
-    memcpy(m_data, s.m_data, sz);
-    m_end = m_data + sz;
-}
-
-inline
-FixedLengthString::FixedLengthString(FixedLengthString&& s)
-{
-    int sz = s.size();
-    memcpy(m_data, s.m_data, sz);
-    m_end = m_data + sz;
-}
-
-inline FixedLengthString & 
-FixedLengthString::operator=(const FixedLengthString &s)
-{
-    int sz = s.size();
-    memcpy(m_data, s.m_data, sz);
-    m_end = m_data + sz;
-    return *this;
+    m_length = sz;
 }
 
 inline FixedLengthString::const_iterator
@@ -166,7 +143,7 @@ FixedLengthString::begin() const
 inline FixedLengthString::const_iterator
 FixedLengthString::end() const
 {
-    return m_end;
+    return m_data + m_length;
 }
 
 inline FixedLengthString::iterator
@@ -178,20 +155,20 @@ FixedLengthString::begin()
 inline FixedLengthString::iterator
 FixedLengthString::end()
 {
-    return m_end;
+    return m_data + m_length;
 }
 
 inline void
 FixedLengthString::erase(const iterator i)
 {
-    memmove(i, i+1, m_end - i);
-    --m_end;
+    memmove(i, i+1, end() - i - 1);
+    --m_length;
 }
 
 inline FixedLengthString::size_type
 FixedLengthString::length() const
 {
-    return FixedLengthString::size_type(m_end - m_data);
+    return m_length;
 }
 
 inline FixedLengthString
@@ -211,7 +188,7 @@ inline FixedLengthString &
 FixedLengthString::operator+=(char c)
 {
     assert(size() < maxSize - 1);
-    *m_end++ = c;
+    m_data[m_length++] = c;
     return *this;
 }
 
@@ -220,8 +197,8 @@ FixedLengthString::operator+=(const FixedLengthString& s)
 {
     int sz = s.size();
     assert(size() + sz < maxSize);
-    memcpy(m_end, s.m_data, sz);
-    m_end += sz;
+    memcpy(end(), s.m_data, sz);
+    m_length += sz;
     return *this;
 }
 
@@ -235,21 +212,20 @@ inline void
 FixedLengthString::pop_back()
 {
     assert(size() > 0);
-    m_end--;
+    m_length--;
 }
 
+// Letters are all below 128, so memcmp's unsigned order is the
+// same as comparing them as chars.
 inline int
 FixedLengthString::compare(const FixedLengthString& s) const
 {
     int size1 = size();
     int size2 = s.size();
     int sz = (size1 < size2) ? size1 : size2;
-    for (int i = 0; i < sz; ++i) {
-	if (m_data[i] < s.m_data[i]) {
-	    return -1;
-	} else if (m_data[i] > s.m_data[i]) {
-	    return 1;
-	}
+    int ret = memcmp(m_data, s.m_data, sz);
+    if (ret != 0) {
+	return ret < 0 ? -1 : 1;
     }
     if (size1 > size2) {
 	return 1;
@@ -259,6 +235,25 @@ FixedLengthString::compare(const FixedLengthString& s) const
     return 0;
 }
 
+inline bool
+FixedLengthString::equals(const FixedLengthString& s) const
+{
+    return m_length == s.m_length && memcmp(m_data, s.m_data, m_length) == 0;
+}
+
+// FNV-1a over eight bytes at a time
+inline size_t
+FixedLengthString::hash() const
+{
+    uint64_t ret = 14695981039346656037ULL ^ m_length;
+    for (unsigned int i = 0; i < m_length; i += 8) {
+	uint64_t word = 0;
+	memcpy(&word, m_data + i, (m_length - i < 8) ? m_length - i : 8);
+	ret = (ret ^ word) * 1099511628211ULL;
+    }
+    return size_t(ret ^ (ret >> 32));
+}
+
 inline bool
 operator<(const Quackle::FixedLengthString &lhs, const Quackle::FixedLengthString& rhs)
 {
@@ -271,13 +266,27 @@ operator<(const Quackle::FixedLengthString &lhs, const Quackle::FixedLengthStrin
 inline bool
 operator==(const Quackle::FixedLengthString &lhs, const Quackle::FixedLengthString& rhs)
 {
-    return (lhs.compare(rhs) == 0);
+    return lhs.equals(rhs);
 }
 
 inline bool
 operator!=(const Quackle::FixedLengthString &lhs, const Quackle::FixedLengthString& rhs)
 {
-    return (lhs.compare(rhs) != 0);
+    return !lhs.equals(rhs);
+}
+
+namespace std
+{
+
+template <>
+struct hash<Quackle::FixedLengthString>
+{
+    size_t operator()(const Quackle::FixedLengthString &s) const
+    {
+	return s.hash();
+    }
+};
+
 }
 
 #endif
@@ -26,6 +26,9 @@
 namespace Quackle
 {
 
+// A node of a version 2 gaddag as held in memory: a 32-bit offset
+// from this node to its first child, then the letter and flags byte
+// of the file.
 class GaddagNode
 {
 public:
@@ -34,6 +37,34 @@ public:
 	const GaddagNode *firstChild() const;
 	const GaddagNode *nextSibling() const;
 	const GaddagNode *child(Letter l) const;
+
+	// the raw fields, for lexicon loaders
+	void set(uint32_t childOffset, unsigned char flags);
+	uint32_t childOffset() const { return m_childOffset; };
+	unsigned char flags() const { return m_flags; };
+
+private:
+	uint32_t m_childOffset;
+	unsigned char m_flags;
+	unsigned char m_reserved[3];
+};
+
+// A node of a version 0 or 1 gaddag, held in memory just as in the
+// file: a 24-bit big-endian offset to the first child, then the
+// letter and flags byte. Half the size of a GaddagNode, so these
+// older gaddags are walked in place rather than widened.
+class NarrowGaddagNode
+{
+public:
+	Letter letter() const;
+	bool isTerminal() const;
+	const NarrowGaddagNode *firstChild() const;
+	const NarrowGaddagNode *nextSibling() const;
+	const NarrowGaddagNode *child(Letter l) const;
+
+	uint32_t childOffset() const { return (data[0] << 16) + (data[1] << 8) + (data[2]); };
+	unsigned char flags() const { return data[3]; };
+
 private:
 	unsigned char data[4];
 };
@@ -41,46 +72,81 @@ private:
 inline Letter
 GaddagNode::letter() const
 {
-	return (data[3] & 0x3F /*0b00111111*/);
+	return (m_flags & 0x3F /*0b00111111*/);
 }
 
 inline bool
 GaddagNode::isTerminal() const
 {
-	return (data[3] & 0x40) != 0 /*0b01000000*/;
+	return (m_flags & 0x40) != 0 /*0b01000000*/;
 }
 
 inline const GaddagNode *
 GaddagNode::firstChild() const
 {
-	unsigned int p = (data[0] << 16) + (data[1] << 8) + (data[2]);
-	if (p == 0) {
+	if (m_childOffset == 0) {
 		return 0;
 	} else {
-		return this + p;
+		return this + m_childOffset;
 	}
 }
 
-/*
 inline const GaddagNode *
-GaddagNode::firstChild() const
+GaddagNode::nextSibling() const
+{
+	if (m_flags & 0x80 /*0b10000000*/) {
+		return 0;
+	} else {
+		return this + 1; // assumes packed array of siblings
+	}
+}
+ 
+inline const GaddagNode *
+GaddagNode::child(Letter l) const
+{
+	for (const GaddagNode *child = firstChild(); child; child = child->nextSibling()) {
+		if (child->letter() == l) {
+			return child;
+		} else if (l != QUACKLE_GADDAG_SEPARATOR && child->letter() > l) {
+			return 0;
+		}
+	}
+	return 0;
+}
+
+inline void
+GaddagNode::set(uint32_t childOffset, unsigned char flags)
+{
+	m_childOffset = childOffset;
+	m_flags = flags;
+	m_reserved[0] = m_reserved[1] = m_reserved[2] = 0;
+}
+
+inline Letter
+NarrowGaddagNode::letter() const
+{
+	return (data[3] & 0x3F /*0b00111111*/);
+}
+
+inline bool
+NarrowGaddagNode::isTerminal() const
+{
+	return (data[3] & 0x40) != 0 /*0b01000000*/;
+}
+
+inline const NarrowGaddagNode *
+NarrowGaddagNode::firstChild() const
 {
-	int p = (data[0] << 16) + (data[1] << 8) + (data[2]);
-	if (p == 0) 
-	{
+	const uint32_t p = childOffset();
+	if (p == 0) {
 		return 0;
-	} 
-	else 
-	{
-		if(p & 0x00800000)
-			p |= 0xff000000;
+	} else {
 		return this + p;
 	}
 }
-*/
 
-inline const GaddagNode *
-GaddagNode::nextSibling() const
+inline const NarrowGaddagNode *
+NarrowGaddagNode::nextSibling() const
 {
 	if (data[3] & 0x80 /*0b10000000*/) {
 		return 0;
@@ -88,11 +154,11 @@ GaddagNode::nextSibling() const
 		return this + 1; // assumes packed array of siblings
 	}
 }
- 
-inline const GaddagNode *
-GaddagNode::child(Letter l) const
+
+inline const NarrowGaddagNode *
+NarrowGaddagNode::child(Letter l) const
 {
-	for (const GaddagNode *child = firstChild(); child; child = child->nextSibling()) {
+	for (const NarrowGaddagNode *child = firstChild(); child; child = child->nextSibling()) {
 		if (child->letter() == l) {
 			return child;
 		} else if (l != QUACKLE_GADDAG_SEPARATOR && child->letter() > l) {
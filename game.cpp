@@ -16,11 +16,14 @@
  *  along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
 #include <iostream>
 #include <sstream>
 
+#include "binaryio.h"
 #include "computerplayer.h"
 #include "datamanager.h"
+#include "enginecontext.h"
 #include "enumerator.h"
 #include "evaluator.h"
 #include "gameparameters.h"
@@ -148,6 +151,14 @@ Move Game::haveComputerPlay(ComputerPlayer *computerPlayer)
 
 	computerPlayer->setPosition(currentPosition());
 
+	if (computerPlayer->parameters().inferring)
+	{
+		bool hasPreviousPosition;
+		const GamePosition &previous = history().previousPosition(&hasPreviousPosition);
+		if (hasPreviousPosition)
+			computerPlayer->setPreviousPosition(previous);
+	}
+
 	Move move(computerPlayer->move());
 	commitMove(move);
 	return move;
@@ -248,7 +259,12 @@ GamePosition::GamePosition()
 
 void GamePosition::kibitz(int nmoves)
 {
-	Generator generator(*this);
+	kibitz(nmoves, EngineContext());
+}
+
+void GamePosition::kibitz(int nmoves, const EngineContext &context)
+{
+	Generator generator(this, context);
 	generator.kibitz(nmoves, exchangeAllowed()? Generator::RegularKibitz : Generator::CannotExchange);
 
 	m_moves = generator.kibitzList();
@@ -263,6 +279,12 @@ const Move &GamePosition::staticBestMove()
 	return m_moves.back();
 }
 
+const Move &GamePosition::staticBestMove(const EngineContext &context)
+{
+	kibitz(1, context);
+	return m_moves.back();
+}
+
 void GamePosition::removeMove(const Quackle::Move &move)
 {
 	const MoveList::iterator end(m_moves.end());
@@ -382,15 +404,12 @@ bool GamePosition::isConnected(const Move &move) const
 
 bool GamePosition::formsAcceptableWords(const Move &move) const
 {
-	vector<Move> words = m_board.allWordsFormedBy(move);
+	WordList words;
+	for (const auto &it : m_board.allWordsFormedBy(move))
+		words.push_back(it.wordTiles());
 
-	for (const auto &it : words)
-	{
-		if (!isAcceptableWord(it.wordTiles()))
-			return false;
-	}
-
-	return true;
+	const vector<bool> acceptable = areAcceptableWords(words);
+	return find(acceptable.begin(), acceptable.end(), false) == acceptable.end();
 }
 
 MoveList GamePosition::allWordsFormedBy(const Move &move) const
@@ -404,6 +423,12 @@ bool GamePosition::isAcceptableWord(const LetterString &word) const
 	return generator.isAcceptableWord(word);
 }
 
+vector<bool> GamePosition::areAcceptableWords(const WordList &words) const
+{
+	Generator generator;
+	return generator.areAcceptableWords(words);
+}
+
 bool GamePosition::exchangeAllowed() const
 {
 	return m_bag.size() >= QUACKLE_PARAMETERS->minimumTilesForExchange();
@@ -443,9 +468,8 @@ void GamePosition::makeMove(const Move &move, bool maintainBoard)
 {
 	if (!move.isChallengedPhoney())
 	{
-		Generator generator(*this);
+		Generator generator(this);
 		generator.makeMove(move, maintainBoard);
-		m_board = generator.position().board();
 	}
 
 	if (move.action == Move::Exchange)
@@ -460,9 +484,143 @@ void GamePosition::scoreMove(Move &move)
 
 void GamePosition::ensureBoardIsPreparedForAnalysis()
 {
-	Generator generator(*this);
+	Generator generator(this);
 	generator.allCrosses();
-	m_board = generator.position().board();
+}
+
+void GamePosition::serialize(BinaryWriter &writer) const
+{
+	writer.writeI32(m_board.width());
+	writer.writeI32(m_board.height());
+	for (int row = 0; row < m_board.height(); ++row)
+	{
+		for (int col = 0; col < m_board.width(); ++col)
+		{
+			writer.writeU8(m_board.letter(row, col));
+			writer.writeU8(m_board.isBlank(row, col));
+		}
+	}
+
+	writer.writeU32(m_players.size());
+	for (const auto &it : m_players)
+	{
+		writer.writeI32(it.id());
+		writer.writeI32(it.type());
+		writer.writeI32(it.score());
+		writer.writeLetters(it.rack().tiles());
+		writer.writeU8(it.racksAreKnown());
+	}
+
+	const bool started = m_currentPlayer != m_players.end();
+	writer.writeU8(started);
+	writer.writeI32(started? currentPlayer().id() : 0);
+	writer.writeI32(m_playerOnTurn != m_players.end()? playerOnTurn().id() : 0);
+
+	writer.writeString(m_bag.tiles());
+	writer.writeLetters(m_drawingOrder);
+
+	writer.writeU32(m_moves.size());
+	for (const auto &it : m_moves)
+		writer.writeMove(it);
+
+	writer.writeI32(m_turnNumber);
+	writer.writeU32(m_nestedness);
+	writer.writeI32(m_scorelessTurnsInARow);
+	writer.writeU8(m_gameOver);
+	writer.writeI32(m_tilesInBag);
+	writer.writeI32(m_tilesOnRack);
+}
+
+bool GamePosition::deserialize(BinaryReader &reader)
+{
+	m_board.prepareEmptyBoard();
+	const int width = reader.readI32();
+	const int height = reader.readI32();
+	if (width != m_board.width() || height != m_board.height())
+		return false;
+
+	for (int row = 0; row < height && reader.ok(); ++row)
+	{
+		// place each run of tiles in the row as a move
+		LetterString run;
+		for (int col = 0; col <= width; ++col)
+		{
+			Letter letter = QUACKLE_NULL_MARK;
+			if (col < width)
+			{
+				letter = reader.readU8();
+				if (reader.readU8())
+					letter = QUACKLE_ALPHABET_PARAMETERS->setBlankness(letter);
+			}
+
+			if (letter != QUACKLE_NULL_MARK)
+			{
+				run.push_back(letter);
+				continue;
+			}
+
+			if (!run.empty())
+			{
+				m_board.makeMove(Move::createPlaceMove(row, col - run.length(), /* horizontal */ true, run));
+				run.clear();
+			}
+		}
+	}
+
+	PlayerList players;
+	const unsigned int playerCount = reader.readU32();
+	for (unsigned int i = 0; i < playerCount && reader.ok(); ++i)
+	{
+		const int id = reader.readI32();
+		const int type = reader.readI32();
+		Player player(MARK_UV("Player"), type, id);
+		player.setScore(reader.readI32());
+		player.setRack(reader.readLetters());
+		player.setRacksAreKnown(reader.readU8());
+		players.push_back(player);
+	}
+
+	m_players = players;
+	const bool started = reader.readU8();
+	const int currentPlayerId = reader.readI32();
+	const int playerOnTurnId = reader.readI32();
+	if (started)
+	{
+		setCurrentPlayer(currentPlayerId);
+		setPlayerOnTurn(playerOnTurnId);
+	}
+	else
+	{
+		m_currentPlayer = m_players.end();
+		m_playerOnTurn = m_players.end();
+	}
+
+	const LetterString noTiles;
+	Bag bag(noTiles);
+	bag.toss(reader.readString());
+	m_bag = bag;
+	m_drawingOrder = reader.readLetters();
+
+	m_moves.clear();
+	const unsigned int moveCount = reader.readU32();
+	for (unsigned int i = 0; i < moveCount && reader.ok(); ++i)
+		m_moves.push_back(reader.readMove());
+
+	m_turnNumber = reader.readI32();
+	m_nestedness = reader.readU32();
+	m_scorelessTurnsInARow = reader.readI32();
+	m_gameOver = reader.readU8();
+	m_tilesInBag = reader.readI32();
+	m_tilesOnRack = reader.readI32();
+
+	resetMoveMade();
+	m_explanatoryNote = UVString();
+
+	if (!reader.ok())
+		return false;
+
+	ensureBoardIsPreparedForAnalysis();
+	return true;
 }
 
 int GamePosition::calculateScore(const Move &move)
@@ -31,7 +31,10 @@
 namespace Quackle
 {
 
+class BinaryReader;
+class BinaryWriter;
 class ComputerPlayer;
+class EngineContext;
 class History;
 
 class HistoryLocation
@@ -93,6 +96,7 @@ public:
 
 	// kibitz up to nmoves best moves; stored in move list
 	void kibitz(int nmoves = 10);
+	void kibitz(int nmoves, const EngineContext &context);
 
 	// get what's in the move list
 	const MoveList &moves() const;
@@ -102,6 +106,7 @@ public:
 	// kibitz (destroying previous move list)
 	// and return the best move based on static evaluation
 	const Move &staticBestMove();
+	const Move &staticBestMove(const EngineContext &context);
 
 	// erase a move from move list that equals move
 	void removeMove(const Move &move);
@@ -161,6 +166,10 @@ public:
 	// returns whether the tiles of move are a word in our lexicon
 	bool isAcceptableWord(const LetterString &word) const;
 
+	// returns whether each of words is in our lexicon, checking them
+	// all at once
+	vector<bool> areAcceptableWords(const WordList &words) const;
+
 	// returns true if any exchange is allowed right now
 	bool exchangeAllowed() const;
 
@@ -182,6 +191,16 @@ public:
 	// or preparing a freshly-loaded-from-file board for analysis
 	void ensureBoardIsPreparedForAnalysis();
 
+	// Compact binary encoding of what analysis needs: the board,
+	// players' ids, scores and racks, the bag, the move list and
+	// turn state. Player names and the move made aren't kept.
+	void serialize(BinaryWriter &writer) const;
+
+	// Reads what serialize() wrote into this position and prepares
+	// the board. Returns false if the data is corrupt or for another
+	// board size, in which case the position is unusable.
+	bool deserialize(BinaryReader &reader);
+
 	// score specified move and return a move with score field
 	// filled in and equity field guessed at; score of
 	// non-place moves is zero
@@ -0,0 +1,425 @@
+/*
+ *  Quackle -- Crossword game artificial intelligence and analysis tool
+ *  Copyright (C) 2005-2019 Jason Katz-Brown, John O'Laughlin, and John Fultz.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <memory>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "gamearchive.h"
+
+using namespace Quackle;
+
+namespace
+{
+
+const uint8_t FileVersion = 1;
+
+// or'd with the action in a move's first byte
+enum MoveFlags { Horizontal = 0x10, Bingo = 0x20, ChallengedPhoney = 0x40, ActionMask = 0x0f };
+
+// about a dozen bytes a move instead of writeMove's fifty; pretty
+// tiles are left out as a board gives them back
+void writeArchivedMove(BinaryWriter &writer, const Move &move)
+{
+	writer.writeU8(move.action | (move.horizontal? Horizontal : 0) | (move.isBingo? Bingo : 0) | (move.isChallengedPhoney()? ChallengedPhoney : 0));
+	if (move.action == Move::Place || move.action == Move::PlaceError)
+	{
+		writer.writeU8(move.startrow);
+		writer.writeU8(move.startcol);
+	}
+	writer.writeLetters(move.tiles());
+	writer.writeI32(move.score);
+	writer.writeI32(move.scoreAddition());
+}
+
+Move readArchivedMove(BinaryReader &reader)
+{
+	const uint8_t flags = reader.readU8();
+
+	Move move;
+	move.action = (Move::Action)(flags & ActionMask);
+	move.horizontal = flags & Horizontal;
+	move.isBingo = flags & Bingo;
+	move.setIsChallengedPhoney(flags & ChallengedPhoney);
+	if (move.action == Move::Place || move.action == Move::PlaceError)
+	{
+		move.startrow = reader.readU8();
+		move.startcol = reader.readU8();
+	}
+	move.setTiles(reader.readLetters());
+	move.score = reader.readI32();
+	move.setScoreAddition(reader.readI32());
+	return move;
+}
+
+void skipTurnOffsets(BinaryReader &reader, int turnCount)
+{
+	for (int i = 0; i < turnCount; ++i)
+		reader.readU32();
+}
+
+PlayerList readPlayers(BinaryReader &reader, int playerCount)
+{
+	PlayerList ret;
+	for (int i = 0; i < playerCount; ++i)
+	{
+		const int type = reader.readU8();
+		Player player(reader.readString(), type, i);
+		player.setAbbreviatedName(reader.readString());
+		ret.push_back(player);
+	}
+
+	return ret;
+}
+
+}
+
+// A record is the player count, the turn count and the offset of each
+// turn from the start of the record, then each player's type, name
+// and abbreviation, the title and description, and the turns.
+bool GameArchiveWriter::addGame(const string &id, const Game &game)
+{
+	if (m_games.find(id) != m_games.end())
+		return false;
+
+	const PlayerList &players = game.players();
+	const History &history = game.history();
+
+	BinaryWriter body;
+	for (const auto &player : players)
+	{
+		body.writeU8(player.type());
+		body.writeString(player.name());
+		body.writeString(player.abbreviatedName());
+	}
+	body.writeString(game.title());
+	body.writeString(game.description());
+
+	vector<uint32_t> turnOffsets;
+	for (const auto &position : history)
+	{
+		turnOffsets.push_back((uint32_t)body.data().size());
+
+		body.writeU8(position.currentPlayer().id());
+		body.writeLetters(position.currentPlayer().rack().tiles());
+		writeArchivedMove(body, position.committedMove());
+		for (const auto &player : position.players())
+			body.writeI32(player.score());
+		body.writeString(position.explanatoryNote());
+	}
+
+	BinaryWriter header;
+	const uint32_t headerLength = 1 + 4 + 4 * (uint32_t)turnOffsets.size();
+	header.writeU8(players.size());
+	header.writeU32(turnOffsets.size());
+	for (const auto &offset : turnOffsets)
+		header.writeU32(headerLength + offset);
+
+	m_games[id] = make_pair(m_records.size(), header.data().size() + body.data().size());
+	m_records += header.data();
+	m_records += body.data();
+	return true;
+}
+
+// File layout, little-endian: version, game count, the length of all
+// records together, then each id and the offset of its record among
+// the records, and the records.
+bool GameArchiveWriter::save(const string &filename) const
+{
+	BinaryWriter index;
+	index.writeU8(FileVersion);
+	index.writeU32(m_games.size());
+	index.writeU64(m_records.size());
+
+	uint64_t offset = 0;
+	for (const auto &it : m_games)
+	{
+		index.writeString(it.first);
+		index.writeU64(offset);
+		offset += it.second.second;
+	}
+
+	ofstream file(filename.c_str(), ios::out | ios::binary | ios::trunc);
+	file.write(index.data().data(), index.data().size());
+	for (const auto &it : m_games)
+		file.write(m_records.data() + it.second.first, it.second.second);
+	return file.good();
+}
+
+GameArchive::GameArchive()
+	: m_data(0), m_size(0)
+{
+}
+
+GameArchive::~GameArchive()
+{
+	unmapFile();
+}
+
+void GameArchive::clear()
+{
+	unmapFile();
+	m_ids.clear();
+	m_offsets.clear();
+}
+
+bool GameArchive::mapFile(const string &filename)
+{
+#ifdef _WIN32
+	ifstream file(filename.c_str(), ios::in | ios::binary);
+	if (!file.is_open())
+		return false;
+
+	m_buffer.assign(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+	m_data = m_buffer.data();
+	m_size = m_buffer.size();
+	return true;
+#else
+	const int fd = ::open(filename.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	struct stat buf;
+	if (fstat(fd, &buf) != 0 || buf.st_size == 0)
+	{
+		::close(fd);
+		return false;
+	}
+
+	void *data = mmap(0, buf.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	::close(fd);
+
+	if (data == MAP_FAILED)
+		return false;
+
+	m_data = static_cast<const char *>(data);
+	m_size = buf.st_size;
+	return true;
+#endif
+}
+
+void GameArchive::unmapFile()
+{
+#ifdef _WIN32
+	m_buffer.clear();
+#else
+	if (m_data)
+		munmap(const_cast<char *>(m_data), m_size);
+#endif
+
+	m_data = 0;
+	m_size = 0;
+}
+
+bool GameArchive::load(const string &filename)
+{
+	clear();
+
+	if (!mapFile(filename))
+		return false;
+
+	BinaryReader reader(m_data, m_size);
+	const uint8_t version = reader.readU8();
+	const uint32_t gameCount = reader.readU32();
+	const uint64_t recordsLength = reader.readU64();
+	if (!reader.ok() || version != FileVersion || recordsLength > m_size)
+	{
+		clear();
+		return false;
+	}
+
+	const uint64_t recordsStart = m_size - recordsLength;
+	for (uint32_t game = 0; game < gameCount && reader.ok(); ++game)
+	{
+		const string id = reader.readString();
+		const uint64_t offset = reader.readU64();
+		if ((game == 0 && offset != 0) || (game > 0 && (id <= m_ids.back() || recordsStart + offset < m_offsets.back())) || offset > recordsLength)
+		{
+			clear();
+			return false;
+		}
+
+		m_ids.push_back(id);
+		m_offsets.push_back(recordsStart + offset);
+	}
+
+	if (!reader.ok())
+	{
+		clear();
+		return false;
+	}
+
+	m_offsets.push_back(m_size);
+	return true;
+}
+
+int GameArchive::findGame(const string &id) const
+{
+	const auto it = lower_bound(m_ids.begin(), m_ids.end(), id);
+	if (it == m_ids.end() || *it != id)
+		return -1;
+
+	return (int)(it - m_ids.begin());
+}
+
+BinaryReader GameArchive::recordReader(int index) const
+{
+	if (index < 0 || index >= gameCount())
+		return BinaryReader(m_data, 0);
+
+	return BinaryReader(m_data + m_offsets[index], m_offsets[index + 1] - m_offsets[index]);
+}
+
+PlayerList GameArchive::players(int index) const
+{
+	BinaryReader reader(recordReader(index));
+	const int playerCount = reader.readU8();
+	skipTurnOffsets(reader, reader.readU32());
+	return readPlayers(reader, playerCount);
+}
+
+UVString GameArchive::title(int index) const
+{
+	BinaryReader reader(recordReader(index));
+	const int playerCount = reader.readU8();
+	skipTurnOffsets(reader, reader.readU32());
+	readPlayers(reader, playerCount);
+	return reader.readString();
+}
+
+UVString GameArchive::description(int index) const
+{
+	BinaryReader reader(recordReader(index));
+	const int playerCount = reader.readU8();
+	skipTurnOffsets(reader, reader.readU32());
+	readPlayers(reader, playerCount);
+	reader.readString();
+	return reader.readString();
+}
+
+int GameArchive::turnCount(int index) const
+{
+	BinaryReader reader(recordReader(index));
+	reader.readU8();
+	return reader.readU32();
+}
+
+ArchivedTurn GameArchive::readTurn(BinaryReader &reader, int playerCount)
+{
+	ArchivedTurn ret;
+	ret.playerId = reader.readU8();
+	ret.rack = reader.readLetters();
+	ret.move = readArchivedMove(reader);
+	for (int i = 0; i < playerCount; ++i)
+		ret.scores.push_back(reader.readI32());
+	ret.note = reader.readString();
+	return ret;
+}
+
+ArchivedTurn GameArchive::turn(int index, int turnIndex) const
+{
+	BinaryReader reader(recordReader(index));
+	const int playerCount = reader.readU8();
+	const int turnCount = reader.readU32();
+	if (turnIndex < 0 || turnIndex >= turnCount)
+	{
+		ArchivedTurn ret;
+		ret.playerId = -1;
+		ret.move = Move::createNonmove();
+		return ret;
+	}
+
+	skipTurnOffsets(reader, turnIndex);
+	const uint32_t offset = reader.readU32();
+	const size_t length = m_offsets[index + 1] - m_offsets[index];
+
+	BinaryReader turnReader(m_data + m_offsets[index] + min<size_t>(offset, length), length - min<size_t>(offset, length));
+	return readTurn(turnReader, playerCount);
+}
+
+// replays turns as GCGIO reads a gcg, so the game is the same one
+// GCGIO would have made of the gcg the archived game was read from
+Game *GameArchive::game(int index, int turnIndex, bool maintainBoard) const
+{
+	Game *ret = new Game;
+
+	BinaryReader reader(recordReader(index));
+	const int playerCount = reader.readU8();
+	const int turnCount = reader.readU32();
+	skipTurnOffsets(reader, turnCount);
+
+	const PlayerList players = readPlayers(reader, playerCount);
+	ret->setTitle(reader.readString());
+	ret->setDescription(reader.readString());
+	if (!reader.ok() || turnCount == 0)
+		return ret;
+
+	ret->setPlayers(players);
+
+	const int lastTurn = (turnIndex < 0 || turnIndex >= turnCount)? turnCount - 1 : turnIndex;
+	for (int i = 0; i <= lastTurn && reader.ok(); ++i)
+	{
+		const ArchivedTurn turn = readTurn(reader, playerCount);
+
+		if (i == 0 || ret->currentPosition().gameOver())
+			ret->addPosition();
+		else
+			ret->commitCandidate(maintainBoard);
+
+		GamePosition &position = ret->currentPosition();
+		Move move = turn.move;
+		if (move.action == Move::UnusedTilesBonus || move.action == Move::UnusedTilesBonusError)
+		{
+			if (turn.playerId < playerCount)
+				position.setTileBonus(players[turn.playerId].abbreviatedName(), move.tiles(), move.effectiveScore());
+		}
+		else
+		{
+			position.setCurrentPlayerRack(Rack(turn.rack));
+			if (move.isAMove())
+			{
+				position.ensureMovePrettiness(move);
+				position.setMoveMade(move);
+			}
+		}
+
+		position.setExplanatoryNote(turn.note);
+	}
+
+	return ret;
+}
+
+GamePosition GameArchive::position(int index, int turnIndex) const
+{
+	unique_ptr<Game> replayed(game(index, turnIndex));
+	if (!replayed->hasPositions())
+		return GamePosition();
+
+	// as it is in the whole game's history, with its move committed
+	GamePosition ret(replayed->currentPosition());
+	ret.prepareForCommit();
+	ret.ensureBoardIsPreparedForAnalysis();
+	return ret;
+}
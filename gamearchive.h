@@ -0,0 +1,154 @@
+/*
+ *  Quackle -- Crossword game artificial intelligence and analysis tool
+ *  Copyright (C) 2005-2019 Jason Katz-Brown, John O'Laughlin, and John Fultz.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef QUACKLE_GAMEARCHIVE_H
+#define QUACKLE_GAMEARCHIVE_H
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "binaryio.h"
+#include "game.h"
+
+namespace Quackle
+{
+
+// One position of an archived game as it was left: the player on
+// turn, their rack, the move they committed from it and everyone's
+// score before that move.
+struct ArchivedTurn
+{
+	int playerId;
+	LetterString rack;
+
+	// without pretty tiles; a nonmove if none was committed
+	Move move;
+
+	// in the order of the game's players
+	vector<int> scores;
+
+	UVString note;
+};
+
+// Builds a game archive: many games in one binary file, each filed
+// under an id, with every move and rack already encoded as letters.
+class GameArchiveWriter
+{
+public:
+	// Encodes the history of game under id. Returns false, adding
+	// nothing, if id is already taken.
+	bool addGame(const string &id, const Game &game);
+
+	int gameCount() const;
+
+	// Games are saved in order of id. Returns false if the file
+	// can't be written.
+	bool save(const string &filename) const;
+
+private:
+	string m_records;
+
+	// id to the offset and length of its record in m_records
+	map<string, pair<size_t, size_t> > m_games;
+};
+
+// Reads a game archive. The file is mapped rather than read, so
+// loading parses just the list of ids and a game's record is only
+// paged in and decoded when it's asked for; any turn of it can be read
+// without the ones before it. Games are numbered in order of id.
+class GameArchive
+{
+public:
+	GameArchive();
+	~GameArchive();
+
+	GameArchive(const GameArchive &) = delete;
+	GameArchive &operator=(const GameArchive &) = delete;
+
+	// Returns false and leaves the archive empty if the file can't be
+	// read or isn't an archive.
+	bool load(const string &filename);
+	void clear();
+
+	int gameCount() const;
+	const string &gameId(int index) const;
+
+	// binary search of the ids; -1 if there is no such game
+	int findGame(const string &id) const;
+
+	PlayerList players(int index) const;
+	UVString title(int index) const;
+	UVString description(int index) const;
+
+	// the number of positions in the game's history
+	int turnCount(int index) const;
+
+	ArchivedTurn turn(int index, int turnIndex) const;
+
+	// Replays the game's encoded moves, with no text to parse, into a
+	// new game whose history stops at turnIndex, or is the whole game
+	// if turnIndex is -1. The caller owns the game.
+	Game *game(int index, int turnIndex = -1, bool maintainBoard = false) const;
+
+	// position turnIndex of the game as it is in the game's history,
+	// with its board ready for analysis
+	GamePosition position(int index, int turnIndex) const;
+
+private:
+	// A reader over the whole of game's record, which starts with
+	// its player count, turn count and the offset of each turn in
+	// the record.
+	BinaryReader recordReader(int index) const;
+
+	// reads the turn reader is at, of a game of playerCount players
+	static ArchivedTurn readTurn(BinaryReader &reader, int playerCount);
+
+	bool mapFile(const string &filename);
+	void unmapFile();
+
+	// the mapped file, or on Windows m_buffer's copy of it
+	const char *m_data;
+	size_t m_size;
+	string m_buffer;
+
+	vector<string> m_ids;
+
+	// where each game's record starts in m_data, and then where the
+	// last one ends
+	vector<uint64_t> m_offsets;
+};
+
+inline int GameArchiveWriter::gameCount() const
+{
+	return (int)m_games.size();
+}
+
+inline int GameArchive::gameCount() const
+{
+	return (int)m_ids.size();
+}
+
+inline const string &GameArchive::gameId(int index) const
+{
+	return m_ids[index];
+}
+
+}
+
+#endif
@@ -17,9 +17,12 @@
  */
 
 #include <fstream>
+#include <algorithm>
 #include <iostream>
 #include <math.h>
+#include <numeric>
 
+#include "alphagramindex.h"
 #include "datamanager.h"
 #include "evaluator.h"
 #include "generator.h"
@@ -35,11 +38,23 @@ using namespace std;
 using namespace Quackle;
 
 Generator::Generator()
+	: m_packing(false), m_position(0), m_context(0), m_lexicon(QUACKLE_LEXICON_PARAMETERS), m_lastLetter(QUACKLE_ALPHABET_PARAMETERS->lastLetter())
 {
 }
 
 Generator::Generator(const GamePosition &position)
-	: m_position(position)
+	: m_packing(false), m_position(0), m_context(0), m_lexicon(QUACKLE_LEXICON_PARAMETERS), m_lastLetter(QUACKLE_ALPHABET_PARAMETERS->lastLetter())
+{
+	setPosition(position);
+}
+
+Generator::Generator(GamePosition *position)
+	: m_packing(false), m_position(position), m_context(0), m_lexicon(QUACKLE_LEXICON_PARAMETERS), m_lastLetter(QUACKLE_ALPHABET_PARAMETERS->lastLetter())
+{
+}
+
+Generator::Generator(GamePosition *position, const EngineContext &context)
+	: m_packing(false), m_position(position), m_context(&context), m_lexicon(context.lexicon()), m_lastLetter(context.lastLetter())
 {
 }
 
@@ -47,6 +62,23 @@ Generator::~Generator()
 {
 }
 
+const EngineContext &Generator::context() const
+{
+	if (!m_context)
+	{
+		m_ownedContext.reset(new EngineContext);
+		m_context = m_ownedContext.get();
+	}
+
+	return *m_context;
+}
+
+void Generator::setPosition(const GamePosition &position)
+{
+	m_ownedPosition.reset(new GamePosition(position));
+	m_position = m_ownedPosition.get();
+}
+
 void Generator::kibitz(int kibitzLength, int flags)
 {
 	// don't just record best move, unless kibitz length is one
@@ -63,6 +95,20 @@ void Generator::kibitz(int kibitzLength, int flags)
 		return;
 	}
 
+	if (m_packing)
+	{
+		filterOutDuplicatePackedPlays();
+
+		// the same order MoveList::sort gives by equity
+		stable_sort(m_packedMoveList.begin(), m_packedMoveList.end(), RecordedMove::equityComparator);
+		reverse(m_packedMoveList.begin(), m_packedMoveList.end());
+
+		const int count = min(kibitzLength, static_cast<int>(m_packedMoveList.size()));
+		for (int i = 0; i < count; ++i)
+			m_kibitzList.push_back(m_packedMoveList[i].unpack());
+		return;
+	}
+
 	filterOutDuplicatePlays();
 
 	MoveList::sort(m_moveList, MoveList::Equity);
@@ -78,6 +124,95 @@ void Generator::kibitz(int kibitzLength, int flags)
 	}
 }
 
+const MoveList &Generator::allPossiblePlays()
+{
+	if (m_packing)
+		unpackMoveList();
+
+	return m_moveList;
+}
+
+void Generator::record(const Move &move)
+{
+	if (m_packing)
+	{
+		if (PackedMove::canPack(move))
+		{
+			m_packedMoveList.push_back(RecordedMove(move));
+			return;
+		}
+
+		unpackMoveList();
+	}
+
+	m_moveList.push_back(move);
+}
+
+void Generator::unpackMoveList()
+{
+	for (const auto &it : m_packedMoveList)
+		m_moveList.push_back(it.unpack());
+
+	m_packedMoveList.clear();
+	m_packing = false;
+}
+
+Generator::RecordedMove::RecordedMove(const Move &fullMove)
+	: move(fullMove), equity(fullMove.equity)
+{
+}
+
+Move Generator::RecordedMove::unpack() const
+{
+	Move ret(move.unpack());
+	ret.equity = equity;
+	return ret;
+}
+
+bool Generator::RecordedMove::equityComparator(const RecordedMove &move1, const RecordedMove &move2)
+{
+	if (move1.equity != move2.equity)
+		return move1.equity < move2.equity;
+
+	// as MoveList::wordPosComparator
+	if (move1.move.startrow() != move2.move.startrow())
+		return move1.move.startrow() < move2.move.startrow();
+	if (move1.move.startcol() != move2.move.startcol())
+		return move1.move.startcol() < move2.move.startcol();
+	if (move1.move.horizontal() != move2.move.horizontal())
+		return move1.move.horizontal() < move2.move.horizontal();
+	if (move1.move.score() != move2.move.score())
+		return move1.move.score() < move2.move.score();
+	return move1.move.tiles() < move2.move.tiles();
+}
+
+void Generator::filterOutDuplicatePackedPlays()
+{
+	map<int, bool> oneTilePlayMap;
+	vector<RecordedMove>::iterator kept = m_packedMoveList.begin();
+	for (const auto &it : m_packedMoveList)
+	{
+		if (it.move.usedTileCount() == 1 && it.move.action() != Move::BlindExchange)
+		{
+			const int actualTileIndex = it.move.firstUsedTileIndex();
+			const int row = it.move.startrow() + (it.move.horizontal()? 0 : actualTileIndex);
+			const int column = it.move.startcol() + (it.move.horizontal()? actualTileIndex : 0);
+			// blanks are alike whatever they're designated, as in Move::usedTiles()
+			const Letter tile = isBlankLetter(it.move.usedTile(0))? QUACKLE_BLANK_MARK : it.move.usedTile(0);
+			int key = row + QUACKLE_MAXIMUM_BOARD_SIZE * column + (QUACKLE_MAXIMUM_BOARD_SIZE * QUACKLE_MAXIMUM_BOARD_SIZE) * tile;
+
+			if (oneTilePlayMap.find(key) != oneTilePlayMap.end())
+				continue;
+
+			oneTilePlayMap[key] = true;
+		}
+
+		*kept++ = it;
+	}
+
+	m_packedMoveList.erase(kept, m_packedMoveList.end());
+}
+
 void Generator::filterOutDuplicatePlays()
 {
 	map<int, bool> oneTilePlayMap;
@@ -131,19 +266,19 @@ void Generator::allCrosses()
 		int row = vrows[i];
 		int col = vcols[i];
 
-		if (QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(row, col))) {
-			board().setVCross(row, col, LetterBitset());
+		if (isSomeLetter(board().letter(row, col))) {
+			board().setVCross(row, col, 0);
 		}
 		else { 
 			LetterString pre; 
 			if (row > 0) {
 				for (int i = row - 1; i >= 0; i--) {
-					if (!QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(i, col))) {
+					if (!isSomeLetter(board().letter(i, col))) {
 						i = -1;
 					}
 					else {
 						LetterString newpre;
-						newpre += QUACKLE_ALPHABET_PARAMETERS->clearBlankness(board().letter(i, col));
+						newpre += clearBlankness(board().letter(i, col));
 						newpre += pre;
 						pre = newpre;
 					}
@@ -153,11 +288,11 @@ void Generator::allCrosses()
 			LetterString suf;
 			if (row < board().height() - 1) {
 				for (int i = row + 1; i < board().height(); i++) {
-					if (!QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(i, col))) {
+					if (!isSomeLetter(board().letter(i, col))) {
 						i = board().height();
 					}
 					else {
-						suf += QUACKLE_ALPHABET_PARAMETERS->clearBlankness(board().letter(i, col));
+						suf += clearBlankness(board().letter(i, col));
 					}
 				}
 			}
@@ -167,7 +302,7 @@ void Generator::allCrosses()
 #endif
 
 			if (pre.empty() && suf.empty()) {
-				board().setVCross(row, col, LetterBitset().set());
+				board().setVCross(row, col, LetterMasks::full());
 			}
 			else {
 				board().setVCross(row, col, fitbetween(pre, suf));
@@ -183,19 +318,19 @@ void Generator::allCrosses()
 		int row = hrows[i];
 		int col = hcols[i];
 
-		if (QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(row, col))) {
-			board().setHCross(row, col, LetterBitset());
+		if (isSomeLetter(board().letter(row, col))) {
+			board().setHCross(row, col, 0);
 		}
 		else { 
 			LetterString pre;
 			if (col > 0) {
 				for (int i = col - 1; i >= 0; i--) {
-					if (!QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(row, i))) {
+					if (!isSomeLetter(board().letter(row, i))) {
 						i = -1;
 					}
 					else {
 						LetterString newpre;
-						newpre += QUACKLE_ALPHABET_PARAMETERS->clearBlankness(board().letter(row, i));
+						newpre += clearBlankness(board().letter(row, i));
 						newpre += pre;
 						pre = newpre;
 					}
@@ -205,16 +340,16 @@ void Generator::allCrosses()
 			LetterString suf;
 			if (col < board().width() - 1) {
 				for (int i = col + 1; i < board().width(); i++) {
-					if (!QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(row, i))) {
+					if (!isSomeLetter(board().letter(row, i))) {
 						i = board().width();
 					}
 					else {
-						suf += QUACKLE_ALPHABET_PARAMETERS->clearBlankness(board().letter(row, i));
+						suf += clearBlankness(board().letter(row, i));
 					}
 				}
 			}
 			if (pre.empty() && suf.empty()) {
-				board().setHCross(row, col, LetterBitset().set());
+				board().setHCross(row, col, LetterMasks::full());
 			}
 			else {
 				board().setHCross(row, col, fitbetween(pre, suf));
@@ -263,10 +398,10 @@ void Generator::makeMove(const Move &move, bool regenerateCrosses)
 		}
 
 		for (int col = move.startcol; col <= endcol; col++) {
-			if (!QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(row, col))) {
+			if (!isSomeLetter(board().letter(row, col))) {
 				int upempty = -1;
 				for (int hookrow = row - 1; hookrow >= 0; hookrow--) {
-					if (!QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(hookrow, col))) {
+					if (!isSomeLetter(board().letter(hookrow, col))) {
 						upempty = hookrow;
 						hookrow = -1;
 					}
@@ -278,7 +413,7 @@ void Generator::makeMove(const Move &move, bool regenerateCrosses)
 
 				int downempty = board().height();
 				for (int hookrow = row + 1; hookrow < board().height(); hookrow++) {
-					if (!QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(hookrow, col))) {
+					if (!isSomeLetter(board().letter(hookrow, col))) {
 						downempty = hookrow;
 						hookrow = board().height();
 					}
@@ -305,10 +440,10 @@ void Generator::makeMove(const Move &move, bool regenerateCrosses)
 		}
 
 		for (int row = move.startrow; row <= endrow; row++) {
-			if (!QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(row, col))) {
+			if (!isSomeLetter(board().letter(row, col))) {
 				int upempty = -1;
 				for (int hookcol = col - 1; hookcol >= 0; hookcol--) {
-					if (!QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(row, hookcol))) {
+					if (!isSomeLetter(board().letter(row, hookcol))) {
 						upempty = hookcol;
 						hookcol = -1;
 					}
@@ -320,7 +455,7 @@ void Generator::makeMove(const Move &move, bool regenerateCrosses)
 
 				int downempty = board().width();
 				for (int hookcol = col + 1; hookcol < board().width(); hookcol++) {
-					if (!QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(row, hookcol))) {
+					if (!isSomeLetter(board().letter(row, hookcol))) {
 						downempty = hookcol;
 						hookcol = board().width();
 					}
@@ -339,19 +474,19 @@ void Generator::makeMove(const Move &move, bool regenerateCrosses)
 	for (unsigned int i = 0; i < vrows.size(); i++) {
 		int row = vrows[i];
 		int col = vcols[i];
-		if (QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(row, col))) {
-			board().setVCross(row, col, LetterBitset());
+		if (isSomeLetter(board().letter(row, col))) {
+			board().setVCross(row, col, 0);
 		}
 		else { 
 			LetterString pre;
 			if (row > 0) {
 				for (int i = row - 1; i >= 0; i--) {
-					if (!QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(i, col))) {
+					if (!isSomeLetter(board().letter(i, col))) {
 						i = -1;
 					}
 					else {
 						LetterString newpre;
-						newpre += QUACKLE_ALPHABET_PARAMETERS->clearBlankness(board().letter(i, col));
+						newpre += clearBlankness(board().letter(i, col));
 						newpre += pre;
 						pre = newpre;
 					}
@@ -360,11 +495,11 @@ void Generator::makeMove(const Move &move, bool regenerateCrosses)
 			LetterString suf;
 			if (row < board().height() - 1) {
 				for (int i = row + 1; i < board().height(); i++) {
-					if (!QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(i, col))) {
+					if (!isSomeLetter(board().letter(i, col))) {
 						i = board().height();
 					}
 					else {
-						suf += QUACKLE_ALPHABET_PARAMETERS->clearBlankness(board().letter(i, col));
+						suf += clearBlankness(board().letter(i, col));
 					}
 				}
 			}
@@ -374,7 +509,7 @@ void Generator::makeMove(const Move &move, bool regenerateCrosses)
 #endif
 
 			if ((pre.empty()) && (suf.empty())) {
-				board().setVCross(row, col, LetterBitset().set());
+				board().setVCross(row, col, LetterMasks::full());
 			}
 			else {
 				board().setVCross(row, col, fitbetween(pre, suf));
@@ -390,19 +525,19 @@ void Generator::makeMove(const Move &move, bool regenerateCrosses)
 		int row = hrows[i];
 		int col = hcols[i];
 
-		if (QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(row, col))) {
-			board().setHCross(row, col, LetterBitset());
+		if (isSomeLetter(board().letter(row, col))) {
+			board().setHCross(row, col, 0);
 		}
 		else { 
 			LetterString pre; 
 			if (col > 0) {
 				for (int i = col - 1; i >= 0; i--) {
-					if (!QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(row, i))) {
+					if (!isSomeLetter(board().letter(row, i))) {
 						i = -1;
 					}
 					else {
 						LetterString newpre;
-						newpre += QUACKLE_ALPHABET_PARAMETERS->clearBlankness(board().letter(row, i));
+						newpre += clearBlankness(board().letter(row, i));
 						newpre += pre;
 						pre = newpre;
 					}
@@ -411,11 +546,11 @@ void Generator::makeMove(const Move &move, bool regenerateCrosses)
 			LetterString suf;
 			if (col < board().width() - 1) {
 				for (int i = col + 1; i < board().width(); i++) {
-					if (!QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(row, i))) {
+					if (!isSomeLetter(board().letter(row, i))) {
 						i = board().width();
 					}
 					else {
-						suf += QUACKLE_ALPHABET_PARAMETERS->clearBlankness(board().letter(row, i));
+						suf += clearBlankness(board().letter(row, i));
 					}
 				}
 			}
@@ -425,7 +560,7 @@ void Generator::makeMove(const Move &move, bool regenerateCrosses)
 #endif
 
 			if ((pre.empty()) && (suf.empty())) {
-				board().setHCross(row, col, LetterBitset().set());
+				board().setHCross(row, col, LetterMasks::full());
 			}
 			else {
 				board().setHCross(row, col, fitbetween(pre, suf));
@@ -440,7 +575,7 @@ void Generator::makeMove(const Move &move, bool regenerateCrosses)
 
 void Generator::readFromDawg(int index, unsigned int &p, Letter &letter, bool &t, bool &lastchild, bool &british, int &playability) const
 {
-	QUACKLE_LEXICON_PARAMETERS->dawgAt(index, p, letter, t, lastchild, british, playability);
+	m_lexicon->dawgAt(index, p, letter, t, lastchild, british, playability);
 }
 
 bool Generator::checksuffix(int i, const LetterString &suffix) {
@@ -486,15 +621,16 @@ bool Generator::checksuffix(int i, const LetterString &suffix) {
 	}
 }
 
-LetterBitset Generator::gaddagFitbetween(const LetterString &pre, const LetterString &suf)
+template <class Node>
+LetterMask Generator::gaddagFitbetween(Node root, const LetterString &pre, const LetterString &suf)
 {
 // 	UVcout << "fit " 
 // 		 << QUACKLE_ALPHABET_PARAMETERS->userVisible(pre)
 // 		 << "_" 
 // 		 << QUACKLE_ALPHABET_PARAMETERS->userVisible(suf) << endl;
-	LetterBitset crosses;
+	LetterMask crosses = 0;
 	/* process the suffix once */
-	const GaddagNode *sufNode = QUACKLE_LEXICON_PARAMETERS->gaddagRoot();
+	Node sufNode = root;
 	int sufLen = suf.length();
 	for (int i = sufLen - 1; i >= 0; --i) {
 		sufNode = sufNode->child(suf[i]);
@@ -504,12 +640,12 @@ LetterBitset Generator::gaddagFitbetween(const LetterString &pre, const LetterSt
 	}
 
 	int preLen = pre.length();
-	for (const GaddagNode* node = sufNode->firstChild(); node; node = node->nextSibling()) {
+	for (Node node = sufNode->firstChild(); node; node = node->nextSibling()) {
 	    Letter childLetter = node->letter();
 	    if (childLetter == QUACKLE_GADDAG_SEPARATOR) {
 			break;
 	    }
-		const GaddagNode *n = node;
+		Node n = node;
 		for (int i = preLen - 1; i >= 0; --i) {
 			n = n->child(pre[i]);
 			if (!n) {
@@ -518,24 +654,37 @@ LetterBitset Generator::gaddagFitbetween(const LetterString &pre, const LetterSt
 		}
 		
 		if (n && n->isTerminal()) {
-			crosses.set(childLetter - QUACKLE_FIRST_LETTER);
+			crosses |= LetterMasks::bit(childLetter);
 		}
 	}	
 	return crosses;
 }
 
-LetterBitset Generator::fitbetween(const LetterString &pre, const LetterString &suf)
+template <class Walk>
+void Generator::walkGaddag(Walk walk) const
+{
+	if (m_lexicon->hasCompactGaddag())
+		walk(m_lexicon->compactGaddagRoot());
+	else if (m_lexicon->hasNarrowGaddag())
+		walk(m_lexicon->narrowGaddagRoot());
+	else
+		walk(m_lexicon->gaddagRoot());
+}
+
+LetterMask Generator::fitbetween(const LetterString &pre, const LetterString &suf)
 {
- 	if (QUACKLE_LEXICON_PARAMETERS->hasGaddag()) {
- 		return gaddagFitbetween(pre, suf);
+ 	if (m_lexicon->hasGaddag()) {
+		LetterMask crosses = 0;
+		walkGaddag([&](auto root) { crosses = gaddagFitbetween(root, pre, suf); });
+		return crosses;
 	}
 
 	//UVcout << QUACKLE_ALPHABET_PARAMETERS->userVisible(pre) << "_" <<
 	//          QUACKLE_ALPHABET_PARAMETERS->userVisible(suf) << endl;
 
-	LetterBitset crosses;
+	LetterMask crosses = 0;
 
-	for (Letter c = QUACKLE_FIRST_LETTER; c <= QUACKLE_ALPHABET_PARAMETERS->lastLetter(); c++) {
+	for (Letter c = QUACKLE_FIRST_LETTER; c <= m_lastLetter; c++) {
 /*
 		UVcout << "Let's check " <<
 		          QUACKLE_ALPHABET_PARAMETERS->userVisible(pre) <<
@@ -543,8 +692,7 @@ LetterBitset Generator::fitbetween(const LetterString &pre, const LetterString &
 							QUACKLE_ALPHABET_PARAMETERS->userVisible(suf) << endl;
 */
 		if (checksuffix(1, pre + c + suf)) {
-			// subtract first letter because crosses hold values starting from zero
-			crosses.set(c - QUACKLE_FIRST_LETTER);
+			crosses |= LetterMasks::bit(c);
 			//UVcout << "  that's a word" << endl;
 			// UVcout << c;
 		}
@@ -558,19 +706,19 @@ UVString Generator::counts2string()
 {
 	UVString ret;
 
-	for (Letter i = 0; i < QUACKLE_ALPHABET_PARAMETERS->lastLetter(); i++)
+	for (Letter i = 0; i < m_lastLetter; i++)
 		for (int j = 0; j < m_counts[i]; j++)
 			ret += QUACKLE_ALPHABET_PARAMETERS->userVisible(i);
 
 	return ret;
 }
 
-UVString Generator::cross2string(const LetterBitset &cross)
+UVString Generator::cross2string(LetterMask cross)
 {
 	UVString ret;
 
 	for (int i = 0; i < QUACKLE_ALPHABET_PARAMETERS->length(); i++)
-		if (cross.test(i))
+		if (cross & (LetterMask(1) << i))
 			ret += QUACKLE_ALPHABET_PARAMETERS->userVisible(QUACKLE_FIRST_LETTER + i);
 
 	return ret;
@@ -603,7 +751,8 @@ UVString Generator::cross2string(const LetterBitset &cross)
    Gen(pos + 1, word, rack, NewArc)
  */
 
-void Generator::gordongoon(int pos, char L, LetterString word, const GaddagNode *node)
+template <class Node>
+void Generator::gordongoon(int pos, char L, const LetterString &word, Node node)
 {
 	//UVcout << "gordongoon(" << pos << ", " << L << ", " << word << ", " << newarc << ", " << oldarc << ")" << 
 	//        " horiz: " << m_gordonhoriz << endl;
@@ -625,7 +774,7 @@ void Generator::gordongoon(int pos, char L, LetterString word, const GaddagNode
 			leftrow += pos - 1;
 		}
 
-		if (QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(currow, curcol))) {
+		if (isSomeLetter(board().letter(currow, curcol))) {
 			L = QUACKLE_PLAYED_THRU_MARK;
 		}
 
@@ -638,7 +787,7 @@ void Generator::gordongoon(int pos, char L, LetterString word, const GaddagNode
 		bool atboardedge = false;
 
 		if ((leftcol >= 0) && (leftrow >= 0)) {
-			if (!QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(currow, curcol)) && QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(leftrow, leftcol))) {
+			if (!isSomeLetter(board().letter(currow, curcol)) && isSomeLetter(board().letter(leftrow, leftcol))) {
 				roomtoleft = false;
 			}
 
@@ -646,7 +795,7 @@ void Generator::gordongoon(int pos, char L, LetterString word, const GaddagNode
 				roomtoleft = false;
 			}
 
-			if (QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(leftrow, leftcol))) {
+			if (isSomeLetter(board().letter(leftrow, leftcol))) {
 				emptyleft = false;
 			}
 		}
@@ -669,11 +818,11 @@ void Generator::gordongoon(int pos, char L, LetterString word, const GaddagNode
 			}
 
 			move.horizontal = m_gordonhoriz;
-			move.score = board().score(move, &move.isBingo);
+			move.score = board().score(move, context(), &move.isBingo);
 			move.equity = equity(move);
 
 			if (m_recordall) {
-				m_moveList.push_back(move);
+				record(move);
 			}
 
 			if (MoveList::equityComparator(best, move)) {
@@ -708,7 +857,7 @@ void Generator::gordongoon(int pos, char L, LetterString word, const GaddagNode
             atrightedge = true;
         }
 
-        if ((node != 0) && emptyleft && !atrightedge) {
+        if (node && emptyleft && !atrightedge) {
             gordongen(1, newWord, node);
         }
 	} 
@@ -729,11 +878,12 @@ void Generator::gordongoon(int pos, char L, LetterString word, const GaddagNode
 			rightrow += pos + 1;
 		}
 
-		if (QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(currow, curcol))) {
-			word += QUACKLE_PLAYED_THRU_MARK;
+		LetterString newWord(word);
+		if (isSomeLetter(board().letter(currow, curcol))) {
+			newWord += QUACKLE_PLAYED_THRU_MARK;
 		}
 		else {
-			word += L;
+			newWord += L;
 		}
 
 		bool roomtoright = true;
@@ -742,9 +892,9 @@ void Generator::gordongoon(int pos, char L, LetterString word, const GaddagNode
 		// UVcout << "rightsquare: " << (char)(rightcol + 'A') << rightrow + 1 << endl;
 
 		if ((rightcol <= board().width() - 1) && (rightrow <= board().height() - 1)) {
-			if (QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(rightrow, rightcol))) {
+			if (isSomeLetter(board().letter(rightrow, rightcol))) {
 				roomtoright = false;
-				// UVcout << "can't record " << word << " here because of the " << board().letter(rightrow, rightcol) << endl;
+				// UVcout << "can't record " << newWord << " here because of the " << board().letter(rightrow, rightcol) << endl;
 			}
 			else {
 				// UVcout << "yay! " << (char)(rightcol + 'A') << rightrow + 1 << " is empty!" << endl; 
@@ -752,32 +902,32 @@ void Generator::gordongoon(int pos, char L, LetterString word, const GaddagNode
 			}
 		}
 		else {
-			// UVcout << "at board edge so i can maybe record " << word << endl;
+			// UVcout << "at board edge so i can maybe record " << newWord << endl;
 			atboardedge = true;
 		}
 
 		if (node->isTerminal() && (roomtoright) && (m_laid > 0)) {
-			// UVcout << "found a word or something " << word << " at " << pos << endl;
+			// UVcout << "found a word or something " << newWord << " at " << pos << endl;
 
 			Move move;
 			move.action = Move::Place;
-			move.setTiles(word);
+			move.setTiles(newWord);
 
 			if (m_gordonhoriz) {
 				move.startrow = m_anchorrow;
-				move.startcol = m_anchorcol - word.length() + pos + 1;
+				move.startcol = m_anchorcol - newWord.length() + pos + 1;
 			}
 			else {
-				move.startrow = m_anchorrow - word.length() + pos + 1;
+				move.startrow = m_anchorrow - newWord.length() + pos + 1;
 				move.startcol = m_anchorcol;
 			}
 
 			move.horizontal = m_gordonhoriz;
-			move.score = board().score(move, &move.isBingo);
+			move.score = board().score(move, context(), &move.isBingo);
 			move.equity = equity(move);
 
 			if (m_recordall) {
-				m_moveList.push_back(move);
+				record(move);
 			}
 
 			if (MoveList::equityComparator(best, move)) {
@@ -789,7 +939,7 @@ void Generator::gordongoon(int pos, char L, LetterString word, const GaddagNode
 
 		// UVcout << "newarc is " << newarc << endl;
         if (!atboardedge) {
-            gordongen(pos + 1, word, node);
+            gordongen(pos + 1, newWord, node);
         }
         else {
             // UVcout << "didn't go ahead because we were at board edge" << endl;
@@ -797,7 +947,8 @@ void Generator::gordongoon(int pos, char L, LetterString word, const GaddagNode
 	}
 }
 
-void Generator::gordongen(int pos, const LetterString &word, const GaddagNode *node) 
+template <class Node>
+void Generator::gordongen(int pos, const LetterString &word, Node node)
 {
 	// UVcout << "gordongen(" << pos << ", " << word << ", " << i << ")" << " horiz: " << m_gordonhoriz << endl;
 
@@ -811,7 +962,7 @@ void Generator::gordongen(int pos, const LetterString &word, const GaddagNode *n
 		currow += pos;
 	}
 
-	LetterBitset cross;
+	LetterMask cross;
 	if (m_gordonhoriz) {
 		cross = board().vcross(currow, curcol);
 	}
@@ -819,23 +970,23 @@ void Generator::gordongen(int pos, const LetterString &word, const GaddagNode *n
 		cross = board().hcross(currow, curcol);
 	}
 
-	if (QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(currow, curcol))) {
+	if (isSomeLetter(board().letter(currow, curcol))) {
 		// UVcout << "gordongen sez a letter (" << board().letter(currow, curcol) << ") already on this square" << endl;
 
-		Letter boardc = QUACKLE_ALPHABET_PARAMETERS->clearBlankness(board().letter(currow, curcol));
+		Letter boardc = clearBlankness(board().letter(currow, curcol));
 
-		const GaddagNode *child = node->child(boardc);
+		Node child = node->child(boardc);
 		if (child) {
 			gordongoon(pos, board().letter(currow, curcol), word, child);
 		}
 	}
 
 	else {
-		for (const GaddagNode* child = node->firstChild(); child; child = child->nextSibling()) {
+		for (Node child = node->firstChild(); child; child = child->nextSibling()) {
 			Letter childLetter = child->letter();
 
 			if ((m_counts[childLetter] <= 0) 
-					|| !cross.test(childLetter - QUACKLE_FIRST_LETTER)) {
+					|| !LetterMasks::contains(cross, childLetter)) {
 				continue;
 			}
 
@@ -853,7 +1004,7 @@ void Generator::gordongen(int pos, const LetterString &word, const GaddagNode *n
 
 		}
 		if (m_counts[QUACKLE_BLANK_MARK] >= 1) {
-			for (const GaddagNode* child = node->firstChild(); child; child = child->nextSibling()) {
+			for (Node child = node->firstChild(); child; child = child->nextSibling()) {
 				Letter childLetter = child->letter();
 				// UVcout << "childLetter is " << (char)(arcc + 'A') << endl;
 
@@ -862,11 +1013,11 @@ void Generator::gordongen(int pos, const LetterString &word, const GaddagNode *n
 					break;
 				}
 
-				if (cross.test(childLetter - QUACKLE_FIRST_LETTER)) {
+				if (LetterMasks::contains(cross, childLetter)) {
 					m_counts[QUACKLE_BLANK_MARK]--;
 					m_laid++;
 					// UVcout << "    yeah that'll work" << endl;
-					gordongoon(pos, QUACKLE_ALPHABET_PARAMETERS->setBlankness(childLetter), word, child);
+					gordongoon(pos, setBlankness(childLetter), word, child);
 					m_counts[QUACKLE_BLANK_MARK]++;
 					m_laid--;
 				}
@@ -915,20 +1066,20 @@ void Generator::extendright(const LetterString &partial, int i,
 	UVcout << "extendright(" << QUACKLE_ALPHABET_PARAMETERS->userVisible(partial) << ", " << i << ", " << counts2string() << ", " << rowpos << ", " << colpos << ", " << horizontal <<  ")" << endl;
 #endif
 
-	if (!QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(rowpos, colpos))) {
+	if (!isSomeLetter(board().letter(rowpos, colpos))) {
 		if (m_counts[c] >= 1) {
-			LetterBitset cross;
+			LetterMask cross;
 			if (horizontal) {
 				cross = board().vcross(rowpos, colpos);
 			}
 			else {
 				cross = board().hcross(rowpos, colpos);
 			}
-			if (cross.test(c - QUACKLE_FIRST_LETTER))  {
+			if (LetterMasks::contains(cross, c))  {
 				if (t) {
 					bool couldend = true;
 					if (dirpos < edgeDirpos) {
-						if (QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(rownext, colnext))) {
+						if (isSomeLetter(board().letter(rownext, colnext))) {
 							couldend = false;
 						}
 					}
@@ -945,7 +1096,7 @@ void Generator::extendright(const LetterString &partial, int i,
 							move.startcol = col;
 						}
 						move.horizontal = horizontal;
-						move.score = board().score(move, &move.isBingo);
+						move.score = board().score(move, context(), &move.isBingo);
 						move.equity = equity(move);
 
 						// i added this because m_laid is wrong and i don't want to break anything by fixing it :)
@@ -953,12 +1104,12 @@ void Generator::extendright(const LetterString &partial, int i,
 
 						int laid = move.wordTilesWithNoPlayThru().length();
 						bool onetilevert = (!move.horizontal) && (laid == 1);
-						bool ignore = onetilevert && !board().hcross(row, col).all();
+						bool ignore = onetilevert && !LetterMasks::isFull(board().hcross(row, col));
 						
 						if (1 || !ignore)
 						{
 							if (m_recordall) {
-								m_moveList.push_back(move);
+								record(move);
 							}
 
 							if (MoveList::equityComparator(best, move)) {
@@ -982,25 +1133,25 @@ void Generator::extendright(const LetterString &partial, int i,
 			}
 		}       
 		if ((m_counts[QUACKLE_BLANK_MARK] >= 1)) {
-			LetterBitset cross;
+			LetterMask cross;
 			if (horizontal) {
 				cross = board().vcross(rowpos, colpos);
 			}
 			else {
 				cross = board().hcross(rowpos, colpos);
 			}
-			if (cross.test(c - QUACKLE_FIRST_LETTER)) {
+			if (LetterMasks::contains(cross, c)) {
 				if (t) {
 					bool couldend = true;
 					if (dirpos < edgeDirpos) {
-						if (QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(rownext, colnext))) {
+						if (isSomeLetter(board().letter(rownext, colnext))) {
 							couldend = false;
 						}
 					}
 					if (couldend) { 
 						Move move;
 						move.action = Move::Place;
-						move.setTiles(partial + QUACKLE_ALPHABET_PARAMETERS->setBlankness(c));
+						move.setTiles(partial + setBlankness(c));
 						if (horizontal) {
 							move.startrow = row;
 							move.startcol = col - (partial.length() - righttiles);
@@ -1010,17 +1161,17 @@ void Generator::extendright(const LetterString &partial, int i,
 							move.startcol = col;
 						}
 						move.horizontal = horizontal;
-						move.score = board().score(move, &move.isBingo);
+						move.score = board().score(move, context(), &move.isBingo);
 						move.equity = equity(move);
 
 						int laid = move.wordTilesWithNoPlayThru().length();
 						bool onetilevert = (!move.horizontal) && (laid == 1);
-						bool ignore = onetilevert && !board().hcross(row, col).all();
+						bool ignore = onetilevert && !LetterMasks::isFull(board().hcross(row, col));
 																								
 						if (1 || !ignore)
 						{
 							if (m_recordall) { 
-								m_moveList.push_back(move);
+								record(move);
 							}
 
 							if (MoveList::equityComparator(best, move)) {
@@ -1036,7 +1187,7 @@ void Generator::extendright(const LetterString &partial, int i,
 				if (dirpos < edgeDirpos) {
 					m_counts[QUACKLE_BLANK_MARK]--;
 					m_laid++;
-					extendright(partial + QUACKLE_ALPHABET_PARAMETERS->setBlankness(c), p, row, col, 
+					extendright(partial + setBlankness(c), p, row, col, 
 							0, righttiles + 1, horizontal);
 					m_counts[QUACKLE_BLANK_MARK]++;
 					m_laid--;
@@ -1049,7 +1200,7 @@ void Generator::extendright(const LetterString &partial, int i,
 		}
 	}
 	else {
-		Letter boardc = QUACKLE_ALPHABET_PARAMETERS->clearBlankness(board().letter(rowpos, colpos));
+		Letter boardc = clearBlankness(board().letter(rowpos, colpos));
 
 		if (c == boardc)
 		{
@@ -1067,7 +1218,7 @@ void Generator::extendright(const LetterString &partial, int i,
 				UVcout << "  next square is " << board().letter(rownext, colnext) << endl;
 #endif
 
-				if (!QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(rownext, colnext))) {
+				if (!isSomeLetter(board().letter(rownext, colnext))) {
 					endofthrough = true;
 #ifdef DEBUG_GENERATOR
 					UVcout << "   woohoo!  next square is empty" << endl;
@@ -1101,18 +1252,18 @@ void Generator::extendright(const LetterString &partial, int i,
 						move.startcol = col;
 					}
 					move.horizontal = horizontal;
-					move.score = board().score(move, &move.isBingo);
+					move.score = board().score(move, context(), &move.isBingo);
 					move.equity = equity(move);
 						
 					int laid = move.wordTilesWithNoPlayThru().length();
 					bool onetilevert = (!move.horizontal) && (laid == 1);
-					bool ignore = onetilevert && !board().hcross(row, col).all();
+					bool ignore = onetilevert && !LetterMasks::isFull(board().hcross(row, col));
 					
 					if (1 || !ignore)
 					{
 						
 						if (m_recordall) {
-							m_moveList.push_back(move);
+							record(move);
 						}
 
 						if (MoveList::equityComparator(best, move)) {
@@ -1171,7 +1322,7 @@ void Generator::leftpart(const LetterString &partial, int i, int limit,
 		if (m_counts[QUACKLE_BLANK_MARK] >= 1) {
 			m_counts[QUACKLE_BLANK_MARK]--;
 			m_laid++;
-			leftpart(partial + QUACKLE_ALPHABET_PARAMETERS->setBlankness(c), p, limit - 1, row, col, 0, horizontal);
+			leftpart(partial + setBlankness(c), p, limit - 1, row, col, 0, horizontal);
 			m_counts[QUACKLE_BLANK_MARK]++;
 			m_laid--;
 		}
@@ -1185,11 +1336,12 @@ void Generator::leftpart(const LetterString &partial, int i, int limit,
 void Generator::setupCounts(const LetterString &letters)
 {
 	String::counts(letters, m_counts);
+	m_placeable = m_counts[QUACKLE_BLANK_MARK] > 0? LetterMasks::full() : LetterMasks::fromLetters(letters);
 }
 
 double Generator::equity(const Move &move) const
 {
-	return QUACKLE_EVALUATOR->equity(m_position, move);
+	return context().evaluator()->equity(*m_position, move);
 }
 
 Move Generator::generate()
@@ -1206,19 +1358,19 @@ Move Generator::generate()
 			// what defines an anchor square?
 
 			bool anchor = false;
-			if (!QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(row, col)) && !board().vcross(row, col).all()) {
+			if (!isSomeLetter(board().letter(row, col)) && !LetterMasks::isFull(board().vcross(row, col)) && (board().vcross(row, col) & m_placeable)) {
 				if (col == 0) {
 					anchor = true;
 				}
-				else if (!QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(row, col - 1))) {
+				else if (!isSomeLetter(board().letter(row, col - 1))) {
 					anchor = true;
 				}
 			}
-			else if (QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(row, col))) {
+			else if (isSomeLetter(board().letter(row, col))) {
 				if (col == 0) {
 					anchor = true;
 				}
-				else if (!QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(row, col - 1))) {
+				else if (!isSomeLetter(board().letter(row, col - 1))) {
 					anchor = true;
 				}
 			}
@@ -1229,11 +1381,11 @@ Move Generator::generate()
 				{
 					// UVcout << "board().vcross[" << row << "][" << i << "] = " << board().vcross(row, i) << endl;
 					
-					if (!QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(row, i)) && board().vcross(row, i).all()) {
+					if (!isSomeLetter(board().letter(row, i)) && LetterMasks::isFull(board().vcross(row, i))) {
 						if (i == 0) {
 							k++;
 						}
-						else if (!QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(row, i - 1))) {
+						else if (!isSomeLetter(board().letter(row, i - 1))) {
 							k++;
 						}
 					}
@@ -1256,19 +1408,19 @@ Move Generator::generate()
 			// what defines an anchor square?
 
 			anchor = false;
-			if (!QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(row, col)) && !board().hcross(row, col).all()) {
+			if (!isSomeLetter(board().letter(row, col)) && !LetterMasks::isFull(board().hcross(row, col)) && (board().hcross(row, col) & m_placeable)) {
 				if (row == 0) {
 					anchor = true;
 				}
-				else if (!QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(row - 1, col))) {
+				else if (!isSomeLetter(board().letter(row - 1, col))) {
 					anchor = true;
 				}
 			}
-			else if (QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(row, col))) {
+			else if (isSomeLetter(board().letter(row, col))) {
 				if (row == 0) {
 					anchor = true;
 				}
-				else if (!QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(row - 1, col))) {
+				else if (!isSomeLetter(board().letter(row - 1, col))) {
 					anchor = true;
 				}
 			}
@@ -1277,11 +1429,11 @@ Move Generator::generate()
 				int k = 0;
 				for (int i = row - 1; i >= 0; i--) {
 					// UVcout << "board().vcross[" << row << "][" << i << "] = " << board().vcross(row, i) << endl;
-					if (!QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(i, col)) && board().hcross(i, col).all()) {
+					if (!isSomeLetter(board().letter(i, col)) && LetterMasks::isFull(board().hcross(i, col))) {
 						if (i == 0) {
 							k++;
 						}
-						else if (!QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(i - 1, col))) {
+						else if (!isSomeLetter(board().letter(i - 1, col))) {
 							k++;
 						}
 					}
@@ -1307,64 +1459,24 @@ Move Generator::generate()
 // TODO GET RID OF CODE DUPLICATION
 Move Generator::gordongenerate()
 {
+	board().updateAnchors();
+
 	for (int row = 0; row < board().height(); row++) {
-		for (int col = 0; col < board().width(); col++) {
+		const uint64_t horizontalAnchors = board().horizontalAnchors(row);
+		const uint64_t verticalAnchors = board().verticalAnchors(row);
+		const uint64_t anchors = horizontalAnchors | verticalAnchors;
 
-			// generate horizontal plays
-			// what defines an anchor square?
-			bool anchor = false;
-			if (!QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(row, col)) && !board().vcross(row, col).all()) {
-				if (col == 0) {
-					if (!QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(row, col + 1))) {
-						anchor = true;
-					}
-				}
-				else if (!QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(row, col - 1))) {
-					if (col == board().width() - 1) {
-						anchor = true;
-					}
-					else {
-						if (!QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(row, col + 1))) {
-							anchor = true;
-						}
-					}
-				}
-			}
-			else if (QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(row, col))) {
-				if (col == board().width() - 1) {
-					anchor = true;
-				}
-				else if (!QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(row, col + 1))) {
-					anchor = true;
-				}
+		for (int col = 0; (anchors >> col) != 0; col++) {
+			const uint64_t bit = uint64_t(1) << col;
+			if (!(anchors & bit)) {
+				continue;
 			}
 
-			if (anchor) {
-				int k = 0;
-				for (int i = col; i >= 0; i--) { // skip over filled sqs
-					if (QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(row, i))) {
-						k++;
-					} else {
-						i = -1;
-					}
-				}
-				for (int i = col - k - 1; i >= 0; i--) {
-					// UVcout << "board().vcross[" << row << "][" << i << "] = " << board().vcross(row, i) << endl;
-					if (!QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(row, i)) && board().vcross(row, i).all()) {
-						if (i == 0) {
-							k++;
-						}
-						else if (!QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(row, i - 1))) {
-							k++;
-						}
-					}
-					else {
-						i = -1;
-					}
-				}
-				// UVcout << "Apparently there are " << k << " empty spots to our left" << endl;
-				// leftpart("", 1, k, row, col, 0, true);
+			// an empty anchor needs one of our tiles to fit its cross
+			const bool empty = !isSomeLetter(board().letter(row, col));
 
+			// generate horizontal plays
+			if ((horizontalAnchors & bit) && (!empty || (board().vcross(row, col) & m_placeable))) {
 				// UVcout << "looking horizontally with the " << board().letter(row, col) <<
 				//         " at " << row + 1 << (char)(col + 'A') << endl;
 
@@ -1372,67 +1484,12 @@ Move Generator::gordongenerate()
 				m_anchorcol = col;
 				m_gordonhoriz = true;
 				m_laid = 0;
-				m_leftlimit = k;
-				gordongen(0, LetterString(), QUACKLE_LEXICON_PARAMETERS->gaddagRoot());
+				m_leftlimit = board().horizontalLeftLimit(row, col);
+				walkGaddag([&](auto root) { gordongen(0, LetterString(), root); });
 			}
 
 			// generate vertical plays
-			// what defines an anchor square?
-
-			anchor = false;
-			if (!QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(row, col)) && !board().hcross(row, col).all()) {
-				if (row == 0) {
-					if (!QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(row + 1, col))) {
-						anchor = true;
-					}
-				}
-				else if (!QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(row - 1, col))) {
-					if (row == board().height() - 1) {
-						anchor = true;
-					}
-					else {
-						if (!QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(row + 1, col))) {
-							anchor = true;
-						}
-					}
-				}
-			}
-			else if (QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(row, col))) {
-				if (row == board().height() - 1) {
-					anchor = true;
-				}
-				else if (!QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(row + 1, col))) {
-					anchor = true;
-				}
-			}
-
-			if (anchor) {
-				int k = 0;
-				for (int i = row; i >= 0; i--) {
-					if (QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(i, col))) {
-						k++;
-					} else {
-						i = -1;
-					}
-				}
-				for (int i = row - k - 1; i >= 0; i--) {
-					// UVcout << "board().vcross[" << row << "][" << i << "] = " << board().vcross(row, i) << endl;
-					if (!QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(i, col)) && board().hcross(i, col).all()) {
-						if (i == 0) {
-							k++;
-						}
-						else if (!QUACKLE_ALPHABET_PARAMETERS->isSomeLetter(board().letter(i - 1, col))) {
-							k++;
-						}
-					}
-					else {
-						i = -1;
-					}
-				}
-
-				// UVcout << "Apparently there are " << k << " empty spots to our left" << endl;
-				// leftpart("", 1, k, row, col, 0, false);
-
+			if ((verticalAnchors & bit) && (!empty || (board().hcross(row, col) & m_placeable))) {
 				// UVcout << "looking vertically with the " << board().letter(row, col) <<
 				//         " at " << row + 1 << (char)(col + 'A') << endl;
 
@@ -1440,9 +1497,8 @@ Move Generator::gordongenerate()
 				m_anchorcol = col;
 				m_gordonhoriz = false;
 				m_laid = 0;
-				m_leftlimit = k;
-				gordongen(0, LetterString(), QUACKLE_LEXICON_PARAMETERS->gaddagRoot());
-
+				m_leftlimit = board().verticalLeftLimit(row, col);
+				walkGaddag([&](auto root) { gordongen(0, LetterString(), root); });
 			}
 		}
 	}
@@ -1516,7 +1572,7 @@ void Generator::spit(int i, const LetterString &prefix, int flags)
 							usedAll = false;
 
 				if (usedAll) {
-					m_spat.push_back(prefix + (flags & ClearBlanknesses? c : QUACKLE_ALPHABET_PARAMETERS->setBlankness(c)));
+					m_spat.push_back(prefix + (flags & ClearBlanknesses? c : setBlankness(c)));
 					if (flags & SingleMatch) {
 					    return;
 					}
@@ -1524,7 +1580,7 @@ void Generator::spit(int i, const LetterString &prefix, int flags)
 			}
 
 			if (p != 0) {
-				spit(p, prefix + (flags & ClearBlanknesses? c : QUACKLE_ALPHABET_PARAMETERS->setBlankness(c)), flags);
+				spit(p, prefix + (flags & ClearBlanknesses? c : setBlankness(c)), flags);
 			}
 
 			m_counts[QUACKLE_BLANK_MARK]++;
@@ -1621,7 +1677,7 @@ Move Generator::exchange()
 		if (throwmap.find(move.tiles()) == throwmap.end())
 		{
 			if (m_recordall)
-				m_moveList.push_back(move);
+				record(move);
 
 			if (MoveList::equityComparator(best, move)) 
 				best = move;
@@ -1637,10 +1693,12 @@ Move Generator::findstaticbest(bool canExchange)
 {
 	best = Move::createPassMove();
 	m_moveList.clear();
+	m_packedMoveList.clear();
+	m_packing = true;
 
 	setupCounts(rack().tiles());
 
-	if (QUACKLE_LEXICON_PARAMETERS->hasSomething())
+	if (m_lexicon->hasSomething())
 	{
 		if (board().isEmpty())
 		{
@@ -1651,7 +1709,7 @@ Move Generator::findstaticbest(bool canExchange)
 			// UVcout << rack() << endl;
 			// UVcout << board() << endl;
 
-			if (QUACKLE_LEXICON_PARAMETERS->hasGaddag())
+			if (m_lexicon->hasGaddag())
 				gordongenerate();
 			else 
 				generate();
@@ -1665,15 +1723,16 @@ Move Generator::findstaticbest(bool canExchange)
 	if (canExchange)
 		exchange();
 
-	if (m_moveList.empty())
-		m_moveList.push_back(best);
+	if (m_moveList.empty() && m_packedMoveList.empty())
+		record(best);
 
 	return best;
 }
 
-void Generator::gaddagAnagram(const GaddagNode *node, const LetterString &prefix, int flags)
+template <class Node>
+void Generator::gaddagAnagram(Node node, const LetterString &prefix, int flags)
 {
-	for (const GaddagNode* child = node->firstChild(); child; child = child->nextSibling()) {
+	for (Node child = node->firstChild(); child; child = child->nextSibling()) {
 	    Letter childLetter = child->letter();
 
 	    if (childLetter == QUACKLE_GADDAG_SEPARATOR) {
@@ -1721,7 +1780,7 @@ void Generator::gaddagAnagram(const GaddagNode *node, const LetterString &prefix
 	}
 
 	if (m_counts[QUACKLE_BLANK_MARK] >= 1 || flags & AddAnyLetters) {
-		for (const GaddagNode* child = node->firstChild(); child; child = child->nextSibling()) {
+		for (Node child = node->firstChild(); child; child = child->nextSibling()) {
 			Letter childLetter = child->letter();
 
 			if (childLetter == QUACKLE_GADDAG_SEPARATOR) {
@@ -1736,7 +1795,7 @@ void Generator::gaddagAnagram(const GaddagNode *node, const LetterString &prefix
 
 			LetterString newPrefix;
 			newPrefix += flags & ClearBlanknesses ?
-				childLetter : QUACKLE_ALPHABET_PARAMETERS->setBlankness(childLetter);
+				childLetter : setBlankness(childLetter);
 			newPrefix += prefix;
 
 			if (child->isTerminal()) {
@@ -1774,9 +1833,10 @@ Move Generator::anagram()
 	// UVcout << "about to call spit" << endl;
 
 	m_spat.clear();
- 	if (QUACKLE_LEXICON_PARAMETERS->hasGaddag()) {
- 		gaddagAnagram(QUACKLE_LEXICON_PARAMETERS->gaddagRoot(),
- 					  LetterString(), NoRequireAllLetters);
+	if (indexCanAnagram(rack().tiles(), NoRequireAllLetters)) {
+		m_spat = m_lexicon->alphagramIndex().words(rack().tiles(), false);
+	} else if (m_lexicon->hasGaddag()) {
+		walkGaddag([&](auto root) { gaddagAnagram(root, LetterString(), NoRequireAllLetters); });
  	} else {
 		spit(1, LetterString(), NoRequireAllLetters);
  	}
@@ -1792,19 +1852,19 @@ Move Generator::anagram()
 			move.action = Move::Place;
 			move.setTiles(*it);
 			move.horizontal = true;
-			move.startrow = QUACKLE_BOARD_PARAMETERS->startRow();
-			move.startcol = (QUACKLE_BOARD_PARAMETERS->startColumn() - (*it).length() + 1) + k;
+			move.startrow = context().startRow();
+			move.startcol = (context().startColumn() - (*it).length() + 1) + k;
 
 			if (move.startcol < 0)
 				continue;
 
-			move.score = board().score(move, &move.isBingo);
+			move.score = board().score(move, context(), &move.isBingo);
 
 			move.equity = equity(move);
 			// UVcout << move << " has equity " << move.equity << endl;
 
 			if (m_recordall)
-				m_moveList.push_back(move);
+				record(move);
 
 			if (MoveList::equityComparator(best, move)) 
 				best = move;
@@ -1814,8 +1874,26 @@ Move Generator::anagram()
 	return best;
 }
 
+bool Generator::indexCanAnagram(const LetterString &letters, int flags) const
+{
+	if (!m_lexicon->hasAlphagramIndex() || (flags & AddAnyLetters))
+		return false;
+
+	for (const auto &letter : letters)
+		if (letter < QUACKLE_FIRST_LETTER)
+			return false;
+
+	if ((flags & NoRequireAllLetters) && !AlphagramIndex::canListSubanagrams(letters))
+		return false;
+
+	return true;
+}
+
 bool Generator::isAcceptableWord(const LetterString &word)
 {
+	if (m_lexicon->hasAlphagramIndex())
+		return m_lexicon->alphagramIndex().contains(word);
+
 	WordList results = anagramLetters(word);
 	
 	WordList::const_iterator end = results.end();
@@ -1826,15 +1904,87 @@ bool Generator::isAcceptableWord(const LetterString &word)
 	return false;
 }
 
+vector<bool> Generator::areAcceptableWords(const WordList &words)
+{
+	vector<bool> ret(words.size(), false);
+	if (!m_lexicon->hasDawg())
+	{
+		for (size_t i = 0; i < words.size(); ++i)
+			ret[i] = isAcceptableWord(words[i]);
+		return ret;
+	}
+
+	vector<size_t> order(words.size());
+	iota(order.begin(), order.end(), 0);
+	sort(order.begin(), order.end(), [&words](size_t i, size_t j) { return words[i] < words[j]; });
+
+	// the path matched for the last word: children[d] is the first
+	// child of the node for its first d letters, and terminal[d]
+	// whether those letters are a word
+	unsigned int children[LETTER_STRING_MAXIMUM_LENGTH + 1];
+	bool terminal[LETTER_STRING_MAXIMUM_LENGTH + 1];
+	children[0] = 1;
+	terminal[0] = false;
+	unsigned int matched = 0;
+	const LetterString *last = 0;
+
+	unsigned int p;
+	Letter letter;
+	bool t;
+	bool lastchild;
+	bool british;
+	int playability;
+
+	for (const auto &i : order)
+	{
+		const LetterString &word = words[i];
+
+		// the letters shared with the last word needn't be walked again
+		unsigned int depth = 0;
+		if (last)
+			while (depth < matched && depth < word.length() && (*last)[depth] == word[depth])
+				++depth;
+
+		for (; depth < word.length() && children[depth] != 0; ++depth)
+		{
+			int index = children[depth];
+			do
+			{
+				readFromDawg(index++, p, letter, t, lastchild, british, playability);
+			} while (letter != word[depth] && !lastchild);
+
+			if (letter != word[depth])
+				break;
+
+			children[depth + 1] = p;
+			terminal[depth + 1] = t;
+		}
+
+		matched = depth;
+		last = &word;
+		ret[i] = depth == word.length() && terminal[depth];
+	}
+
+	return ret;
+}
+
 WordList Generator::anagramLetters(const LetterString &letters, int flags)
 {
-	setupCounts(String::clearBlankness(letters));
+	const LetterString cleared = String::clearBlankness(letters);
+	if (indexCanAnagram(cleared, flags))
+	{
+		WordList ret = m_lexicon->alphagramIndex().words(cleared, !(flags & NoRequireAllLetters));
+		if ((flags & SingleMatch) && ret.size() > 1)
+			ret.resize(1);
+		return ret;
+	}
+
+	setupCounts(cleared);
 	m_spat.clear();
 
- 	if (QUACKLE_LEXICON_PARAMETERS->hasGaddag()) {
- 		gaddagAnagram(QUACKLE_LEXICON_PARAMETERS->gaddagRoot(),
- 					  LetterString(), flags);
- 	} else if (QUACKLE_LEXICON_PARAMETERS->hasSomething()) {
+	if (m_lexicon->hasGaddag()) {
+		walkGaddag([&](auto root) { gaddagAnagram(root, LetterString(), flags); });
+ 	} else if (m_lexicon->hasSomething()) {
 		spit(1, LetterString(), flags);
 	}
 
@@ -1843,13 +1993,19 @@ WordList Generator::anagramLetters(const LetterString &letters, int flags)
 
 void Generator::storeWordInfo(WordWithInfo *wordWithInfo)
 {
-	if (!QUACKLE_LEXICON_PARAMETERS->hasSomething())
+	if (!m_lexicon->hasSomething())
 		return;
 
 	setupCounts(String::clearBlankness(wordWithInfo->wordLetterString));
 
 	wordWithInfo->probability = Bag::probabilityOfDrawingFromFullBag(wordWithInfo->wordLetterString);
 
+	if (m_lexicon->hasAlphagramIndex())
+	{
+		m_lexicon->alphagramIndex().contains(wordWithInfo->wordLetterString, wordWithInfo);
+		return;
+	}
+
 	m_wordspat.clear();
 	wordspit(1, LetterString(), 0);	
 	
@@ -19,11 +19,14 @@
 #ifndef QUACKLE_GENERATOR_H
 #define QUACKLE_GENERATOR_H
 
+#include <memory>
 #include <vector>
 
 #include "alphabetparameters.h"
+#include "enginecontext.h"
 #include "game.h"
 #include "move.h"
+#include "packedmove.h"
 
 using namespace std;
 
@@ -62,8 +65,24 @@ public:
 class Generator
 {
 public:
+	// A generator made without a position can only check and
+	// anagram words until it's given one.
 	Generator();
+
+	// generates on a copy of position
 	Generator(const Quackle::GamePosition &position);
+
+	// Generates on position itself without copying it, so makeMove
+	// and allCrosses change its board. The position must outlive
+	// the generator.
+	Generator(Quackle::GamePosition *position);
+
+	// As above, but reading parameters from context. Without one, a
+	// generator takes a snapshot of its own the first time it scores
+	// a move, so checking words and updating crosses don't pay for
+	// one. The context must outlive the generator too.
+	Generator(Quackle::GamePosition *position, const EngineContext &context);
+
 	~Generator();
 
 	enum KibitzFlags { RegularKibitz = 0x0000, CannotExchange = 0x0001 /*, OtherOption = 0x0002, OtherOption2 = 0x0004 */ };
@@ -74,9 +93,11 @@ public:
 	void kibitz(int kibitzLength = 10, int flags = AnagramRearrange);
 
 	const MoveList &kibitzList();
+
+	// unpacks the moves found if they're packed
 	const MoveList &allPossiblePlays();
 
-	// set generator to generate on this position
+	// set generator to generate on a copy of this position
 	// (using current player's rack)
 	void setPosition(const GamePosition &position);
 	const GamePosition &position() const;
@@ -92,6 +113,11 @@ public:
 			    ClearBlanknesses	= 0x0004,
 			    SingleMatch		= 0x0008 };
 	bool isAcceptableWord(const LetterString &word);
+
+	// Whether each of words is acceptable, like isAcceptableWord but
+	// checking them all in one walk of the dawg, in sorted order so
+	// words sharing a prefix share its walk.
+	vector<bool> areAcceptableWords(const WordList &words);
         WordList anagramLetters(const LetterString &letters, 
 				int flags = AnagramRearrange);
 	void storeWordInfo(WordWithInfo *wordWithInfo);
@@ -105,9 +131,17 @@ private:
 	Board &board();
 	const Rack &rack() const;
 
-	// passes on to the global evaluator
+	// passes on to the context's evaluator
 	double equity(const Move &move) const;
 
+	// the context given, or else our own snapshot, taken on first use
+	const EngineContext &context() const;
+
+	bool isSomeLetter(Letter letter) const;
+	bool isBlankLetter(Letter letter) const;
+	Letter clearBlankness(Letter letter) const;
+	Letter setBlankness(Letter letter) const;
+
 	// i'll make these private very soon
 	// no you won't, olaugh :)
 	Move generate();
@@ -125,38 +159,82 @@ private:
 	void readFromDawg(int index, unsigned int &p, Letter &letter, bool &t, bool &lastchild, bool &british, int &playability) const;
 
 	bool checksuffix(int i, const LetterString &suffix); 
-	LetterBitset fitbetween(const LetterString &pre, const LetterString &suf);
+	LetterMask fitbetween(const LetterString &pre, const LetterString &suf);
 	void extendright(const LetterString &partial, int i,  
 			int row, int col, int edge, int righttiles, 
 			bool horizontal);
 	void leftpart(const LetterString &partial, int i, int limit, 
 			int row, int col, int edge, bool horizontal);
+	// whether the lexicon's alphagram index can answer an anagram
+	// of letters with flags, which it can't for blanks, nor quickly
+	// for sub-anagrams of long strings
+	bool indexCanAnagram(const LetterString &letters, int flags) const;
 	void spit(int i, const LetterString &prefix, int flags);
 	void wordspit(int i, const LetterString &prefix, int flags);
 
-	LetterBitset gaddagFitbetween(const LetterString &pre, const LetterString &suf);
-	void gaddagAnagram(const GaddagNode *node, const LetterString &prefix, int flags);
-	void gordongen(int pos, const LetterString &word, const GaddagNode *node);
-	void gordongoon(int pos, char L, LetterString word, const GaddagNode *node);
+	// calls walk with the root of the gaddag in whichever form the
+	// lexicon holds it
+	template <class Walk> void walkGaddag(Walk walk) const;
+
+	// Node is const GaddagNode *, const NarrowGaddagNode * or
+	// CompactGaddagNode, whichever form the lexicon holds its gaddag in
+	template <class Node> LetterMask gaddagFitbetween(Node root, const LetterString &pre, const LetterString &suf);
+	template <class Node> void gaddagAnagram(Node node, const LetterString &prefix, int flags);
+	template <class Node> void gordongen(int pos, const LetterString &word, Node node);
+	template <class Node> void gordongoon(int pos, char L, const LetterString &word, Node node);
 
 	void filterOutDuplicatePlays();
+	void filterOutDuplicatePackedPlays();
+
+	// Adds move to the list of all moves found, packed unless a
+	// move that doesn't pack has turned up.
+	void record(const Move &move);
+	void unpackMoveList();
 
 	// debug stuff
 	UVString counts2string();
-	UVString cross2string(const LetterBitset &cross);
+	UVString cross2string(LetterMask cross);
 
 	Move best;
 
-	// keeps *all* moves
+	struct RecordedMove
+	{
+		RecordedMove(const Move &move);
+		Move unpack() const;
+
+		// same order as MoveList::equityComparator
+		static bool equityComparator(const RecordedMove &move1, const RecordedMove &move2);
+
+		PackedMove move;
+		double equity;
+	};
+
+	// keeps *all* moves, in m_packedMoveList while m_packing
 	MoveList m_moveList;
+	vector<RecordedMove> m_packedMoveList;
+	bool m_packing;
 
 	// sorts and prunes into kibitzed list
 	MoveList m_kibitzList;
 
-	GamePosition m_position;
+	// either borrowed or m_ownedPosition
+	GamePosition *m_position;
+	unique_ptr<GamePosition> m_ownedPosition;
+
+	// either borrowed or m_ownedContext, made by context()
+	mutable const EngineContext *m_context;
+	mutable unique_ptr<EngineContext> m_ownedContext;
+
+	// the context's, or the data manager's if we weren't given one
+	const LexiconParameters *m_lexicon;
+	Letter m_lastLetter;
 
 	char m_counts[QUACKLE_FIRST_LETTER + QUACKLE_MAXIMUM_ALPHABET_SIZE];
 	int m_laid;
+
+	// letters setupCounts' letters could put on a square; an empty
+	// anchor whose cross set misses all of them can be skipped
+	LetterMask m_placeable;
 	int m_leftlimit;
 
 	WordList m_spat;
@@ -168,24 +246,39 @@ private:
 };
 
 
-inline void Generator::setPosition(const GamePosition &position)
-{
-	m_position = position;
-}
-
 inline const GamePosition &Generator::position() const
 {
-	return m_position;
+	return *m_position;
 }
 
 inline Board &Generator::board()
 {
-	return m_position.underlyingBoardReference();
+	return m_position->underlyingBoardReference();
 }
 
 inline const Rack &Generator::rack() const
 {
-	return m_position.currentPlayer().rack();
+	return m_position->currentPlayer().rack();
+}
+
+inline bool Generator::isSomeLetter(Letter letter) const
+{
+	return letter >= QUACKLE_FIRST_LETTER;
+}
+
+inline bool Generator::isBlankLetter(Letter letter) const
+{
+	return letter > m_lastLetter;
+}
+
+inline Letter Generator::clearBlankness(Letter letter) const
+{
+	return isBlankLetter(letter)? letter - QUACKLE_BLANK_OFFSET : letter;
+}
+
+inline Letter Generator::setBlankness(Letter letter) const
+{
+	return isBlankLetter(letter)? letter : letter + QUACKLE_BLANK_OFFSET;
 }
 
 inline void Generator::setrecordall(bool b)
@@ -198,10 +291,6 @@ inline const MoveList &Generator::kibitzList()
 	return m_kibitzList;
 }
 
-inline const MoveList &Generator::allPossiblePlays()
-{
-	return m_moveList;
-}
 
 }
 
@@ -0,0 +1,154 @@
+/*
+ *  Quackle -- Crossword game artificial intelligence and analysis tool
+ *  Copyright (C) 2005-2019 Jason Katz-Brown, John O'Laughlin, and John Fultz.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <thread>
+
+#include "inferrer.h"
+#include "datamanager.h"
+#include "enginecontext.h"
+#include "gameparameters.h"
+
+using namespace Quackle;
+
+Inferrer::Inferrer()
+	: m_taper(7), m_sampleCount(500), m_threadCount(thread::hardware_concurrency())
+{
+	if (m_threadCount == 0)
+		m_threadCount = 1;
+}
+
+bool Inferrer::infer()
+{
+	m_leaves.clear();
+
+	Move play(m_previousPosition.moveMade());
+	if (play.action != Move::Place)
+		return false;
+
+	const int playedLength = play.usedTiles().length();
+	if (playedLength >= QUACKLE_PARAMETERS->rackSize())
+		return false;
+
+	candidateLeaves(QUACKLE_PARAMETERS->rackSize() - playedLength);
+	if (m_leaves.empty())
+		return false;
+
+	// the score doesn't depend on the rack, so only do it once
+	play.score = m_previousPosition.calculateScore(play);
+
+	vector<double> mistakes(m_leaves.size());
+
+	const size_t threadCount = min((size_t)m_threadCount, m_leaves.size());
+	DataManager *dataManager = QUACKLE_DATAMANAGER;
+	const unsigned int seed = dataManager->randomInteger(0, numeric_limits<int>::max());
+	vector<thread> threads;
+	for (size_t i = 1; i < threadCount; ++i)
+	{
+		threads.emplace_back([=, &play, &mistakes] {
+			DataManagerScope scope(dataManager);
+			evaluateLeaves(i, threadCount, seed, play, &mistakes);
+		});
+	}
+	evaluateLeaves(0, threadCount, seed, play, &mistakes);
+	for (auto &it : threads)
+		it.join();
+
+	const double closest = *min_element(mistakes.begin(), mistakes.end());
+
+	ProbableRackList weighted;
+	for (size_t i = 0; i < m_leaves.size(); ++i)
+	{
+		double weight;
+		if (m_taper > 0)
+			weight = 1 - (mistakes[i] - closest) / m_taper;
+		else
+			weight = mistakes[i] == closest? 1 : 0;
+
+		if (weight <= 0)
+			continue;
+
+		ProbableRack leave = m_leaves[i];
+		leave.probability *= weight;
+		leave.possibility = leave.probability;
+		weighted.push_back(leave);
+	}
+
+	m_leaves.swap(weighted);
+	Enumerator::normalizeProbabilities(&m_leaves);
+
+	return true;
+}
+
+void Inferrer::candidateLeaves(unsigned int leaveLength)
+{
+	if (leaveLength <= maximumEnumeratedLeaveLength)
+	{
+		Enumerator enumerator(m_unseenBag);
+		enumerator.enumerate(&m_leaves, leaveLength);
+		return;
+	}
+
+	if (m_unseenBag.size() < (int)leaveLength)
+		return;
+
+	// Too many leaves to try them all, so draw some the way the
+	// opponent would have and let the repeats add up.
+	map<LetterString, int> drawn;
+	for (int i = 0; i < m_sampleCount; ++i)
+	{
+		Bag bag(m_unseenBag);
+		LetterString leave;
+		for (unsigned int j = 0; j < leaveLength; ++j)
+			leave.push_back(bag.pluck());
+
+		++drawn[String::alphabetize(leave)];
+	}
+
+	for (const auto &it : drawn)
+	{
+		ProbableRack leave;
+		leave.rack = Rack(it.first);
+		leave.probability = it.second;
+		leave.possibility = it.second;
+		m_leaves.push_back(leave);
+	}
+}
+
+void Inferrer::evaluateLeaves(size_t first, size_t stride, unsigned int seed, const Move &play, vector<double> *mistakes) const
+{
+	// each thread kibitzes on its own copy
+	GamePosition position(m_previousPosition);
+	const EngineContext context;
+	const LetterString played = play.usedTiles();
+
+	for (size_t i = first; i < m_leaves.size(); i += stride)
+	{
+		// each leaf draws from a generator seeded with seed and its
+		// index, whatever thread it's on
+		seed_seq leaveSeed = {seed, (unsigned int)i};
+		RandomNumberScope random(leaveSeed);
+
+		position.setCurrentPlayerRack(Rack(played + m_leaves[i].rack.tiles()), /* adjust bag */ false);
+
+		const double best = position.staticBestMove(context).equity;
+		(*mistakes)[i] = max(0.0, best - position.calculateEquity(play));
+	}
+}
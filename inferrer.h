@@ -0,0 +1,111 @@
+/*
+ *  Quackle -- Crossword game artificial intelligence and analysis tool
+ *  Copyright (C) 2005-2019 Jason Katz-Brown, John O'Laughlin, and John Fultz.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QUACKLE_INFERRER_H
+#define QUACKLE_INFERRER_H
+
+#include "enumerator.h"
+#include "game.h"
+
+namespace Quackle
+{
+
+// Guesses what the opponent kept after their last play.
+// Every leave the opponent could have kept from the tiles we can't
+// see is tried: we generate the opponent's best play from the rack
+// that leave implies and see how far the observed play falls short
+// of it. Leaves that make the observed play close to best get most
+// of the weight, which tapers off to nothing as the mistake grows.
+class Inferrer
+{
+public:
+	Inferrer();
+
+	// the position the opponent made their play from; its
+	// moveMade() is the play we infer from
+	void setPreviousPosition(const GamePosition &position);
+
+	// tiles the inferring player can't see now
+	void setUnseenBag(const Bag &bag);
+
+	// how many points worse than the closest-to-best leave a play
+	// can be before its leave gets no weight
+	void setTaper(double taper);
+
+	// when there are too many leaves to try them all, this many are
+	// drawn at random from the unseen tiles instead
+	void setSampleCount(int sampleCount);
+
+	// how many threads evaluate leaves; defaults to the number of cores
+	void setThreadCount(unsigned int threadCount);
+
+	// Returns false if the previous play tells us nothing, eg
+	// it wasn't a place move or used up the whole rack.
+	bool infer();
+
+	// weighted leaves whose probabilities sum to 1; filled by infer()
+	const ProbableRackList &leaves() const;
+
+	static const unsigned int maximumEnumeratedLeaveLength = 2;
+
+private:
+	void candidateLeaves(unsigned int leaveLength);
+	void evaluateLeaves(size_t first, size_t stride, unsigned int seed, const Move &play, vector<double> *mistakes) const;
+
+	GamePosition m_previousPosition;
+	Bag m_unseenBag;
+	double m_taper;
+	int m_sampleCount;
+	unsigned int m_threadCount;
+
+	ProbableRackList m_leaves;
+};
+
+inline void Inferrer::setPreviousPosition(const GamePosition &position)
+{
+	m_previousPosition = position;
+}
+
+inline void Inferrer::setUnseenBag(const Bag &bag)
+{
+	m_unseenBag = bag;
+}
+
+inline void Inferrer::setTaper(double taper)
+{
+	m_taper = taper;
+}
+
+inline void Inferrer::setSampleCount(int sampleCount)
+{
+	m_sampleCount = sampleCount;
+}
+
+inline void Inferrer::setThreadCount(unsigned int threadCount)
+{
+	m_threadCount = threadCount;
+}
+
+inline const ProbableRackList &Inferrer::leaves() const
+{
+	return m_leaves;
+}
+
+}
+
+#endif
@@ -21,6 +21,7 @@
 #include <fstream>
 
 
+#include "alphagramindex.h"
 #include "datamanager.h"
 #include "lexiconparameters.h"
 #include "uv.h"
@@ -30,7 +31,7 @@ using namespace Quackle;
 class Quackle::V0LexiconInterpreter : public LexiconInterpreter
 {
 
-	virtual void loadDawg(ifstream &file, LexiconParameters &lexparams)
+	virtual bool loadDawg(ifstream &file, LexiconParameters &lexparams)
 	{
 		int i = 0;
 		while (!file.eof())
@@ -38,16 +39,12 @@ class Quackle::V0LexiconInterpreter : public LexiconInterpreter
 			file.read((char*)(lexparams.m_dawg) + i, 7);
 			i += 7;
 		}
+		return true;
 	}
 
 	virtual void loadGaddag(ifstream &file, LexiconParameters &lexparams)
 	{
-		int i = 0;
-		while (!file.eof())
-		{
-			file.read((char*)(lexparams.m_gaddag) + i, 4);
-			i += 4;
-		}
+		loadNarrowGaddag(file, lexparams);
 	}
 
 	virtual void dawgAt(const unsigned char *dawg, int index, unsigned int &p, Letter &letter, bool &t, bool &lastchild, bool &british, int &playability) const
@@ -69,7 +66,7 @@ class Quackle::V0LexiconInterpreter : public LexiconInterpreter
 class Quackle::V1LexiconInterpreter : public LexiconInterpreter
 {
 
-	virtual void loadDawg(ifstream &file, LexiconParameters &lexparams)
+	virtual bool loadDawg(ifstream &file, LexiconParameters &lexparams)
 	{
 		int i = 0;
 		unsigned char bytes[3];
@@ -88,6 +85,7 @@ class Quackle::V1LexiconInterpreter : public LexiconInterpreter
 			file.read((char*)(lexparams.m_dawg) + i, 7);
 			i += 7;
 		}
+		return true;
 	}
 
 	virtual void loadGaddag(ifstream &file, LexiconParameters &lexparams)
@@ -108,12 +106,7 @@ class Quackle::V1LexiconInterpreter : public LexiconInterpreter
 			}
 		}
 
-		size_t i = 0;
-		while (!file.eof())
-		{
-			file.read((char*)(lexparams.m_gaddag) + i, 4);
-			i += 4;
-		}
+		loadNarrowGaddag(file, lexparams);
 	}
 
 	virtual void dawgAt(const unsigned char *dawg, int index, unsigned int &p, Letter &letter, bool &t, bool &lastchild, bool &british, int &playability) const
@@ -132,8 +125,117 @@ class Quackle::V1LexiconInterpreter : public LexiconInterpreter
 	virtual int versionNumber() const { return 1; }
 };
 
+class Quackle::V2LexiconInterpreter : public LexiconInterpreter
+{
+
+	static uint32_t readUint32(ifstream &file)
+	{
+		unsigned char bytes[4];
+		file.read((char*)bytes, 4);
+		return ((uint32_t)bytes[0] << 24) | (bytes[1] << 16) | (bytes[2] << 8) | bytes[3];
+	}
+
+	static size_t remainingBytes(ifstream &file)
+	{
+		const streampos position = file.tellg();
+		file.seekg(0, ios_base::end);
+		const size_t remaining = (size_t)(file.tellg() - position);
+		file.seekg(position);
+		return remaining;
+	}
+
+	static void readAlphabet(ifstream &file, vector<string> &alphabet)
+	{
+		alphabet.resize(file.get());
+		for (size_t i = 0; i < alphabet.size(); i++)
+		{
+			file >> alphabet[i];
+			file.get(); // separator space
+		}
+	}
+
+	virtual bool loadDawg(ifstream &file, LexiconParameters &lexparams)
+	{
+		file.get(); // skip past version byte
+		file.read(lexparams.m_hash, sizeof(lexparams.m_hash));
+		readUint32(file); // word count
+		const uint32_t nodeCount = readUint32(file);
+		readAlphabet(file, lexparams.m_utf8Alphabet);
+		if (remainingBytes(file) < (size_t)nodeCount * 8)
+			return false; // truncated
+
+		file.read((char*)(lexparams.m_dawg), (streamsize)nodeCount * 8);
+		return true;
+	}
+
+	virtual void loadGaddag(ifstream &file, LexiconParameters &lexparams)
+	{
+		char hash[16];
+		file.get(); // skip past version byte
+		file.read(hash, sizeof(hash));
+		const char noHash[16] = { 0 };
+		if (memcmp(hash, lexparams.m_hash, sizeof(hash)) && memcmp(noHash, lexparams.m_hash, sizeof(hash)))
+		{
+			lexparams.unloadGaddag(); // don't use a mismatched gaddag
+			return;
+		}
+
+		const uint32_t nodeCount = readUint32(file);
+		vector<string> alphabet;
+		readAlphabet(file, alphabet);
+		if (remainingBytes(file) < (size_t)nodeCount * 8)
+		{
+			lexparams.unloadGaddag(); // truncated
+			return;
+		}
+
+		// nodes are the same size in the file and in memory, so each
+		// is decoded where it lands
+		lexparams.m_gaddag = new unsigned char[(size_t)nodeCount * sizeof(GaddagNode)];
+		lexparams.m_gaddagNodeCount = nodeCount;
+		lexparams.m_gaddagIsNarrow = false;
+		file.read((char*)(lexparams.m_gaddag), (streamsize)nodeCount * 8);
+
+		GaddagNode *nodes = (GaddagNode *) lexparams.m_gaddag;
+		for (uint32_t i = 0; i < nodeCount; i++)
+		{
+			const unsigned char *bytes = lexparams.m_gaddag + (size_t)i * 8;
+			const uint32_t p = ((uint32_t)bytes[0] << 24) | (bytes[1] << 16) | (bytes[2] << 8) | bytes[3];
+			nodes[i].set(p, bytes[4]);
+		}
+	}
+
+	virtual void dawgAt(const unsigned char *dawg, int index, unsigned int &p, Letter &letter, bool &t, bool &lastchild, bool &british, int &playability) const
+	{
+		const unsigned char *node = dawg + (size_t)index * 8;
+		p = ((uint32_t)node[0] << 24) | (node[1] << 16) | (node[2] << 8) | node[3];
+		letter = node[4];
+
+		lastchild = ((letter & 64) != 0);
+		british = !(letter & 128);
+		letter = (letter & 63) + QUACKLE_FIRST_LETTER;
+
+		playability = (node[5] << 16) + (node[6] << 8) + (node[7]);
+		t = (playability != 0);
+	}
+	virtual int versionNumber() const { return 2; }
+};
+
+void LexiconInterpreter::loadNarrowGaddag(ifstream &file, LexiconParameters &lexparams)
+{
+	const streampos start = file.tellg();
+	file.seekg(0, ios_base::end);
+	const size_t nodeCount = (size_t)(file.tellg() - start) / 4;
+	file.seekg(start);
+
+	lexparams.m_gaddag = new unsigned char[nodeCount * sizeof(NarrowGaddagNode)];
+	lexparams.m_gaddagNodeCount = nodeCount;
+	lexparams.m_gaddagIsNarrow = true;
+	file.read((char*)(lexparams.m_gaddag), nodeCount * sizeof(NarrowGaddagNode));
+}
+
 LexiconParameters::LexiconParameters()
-	: m_dawg(NULL), m_gaddag(NULL), m_interpreter(NULL)
+	: m_dawg(NULL), m_gaddag(NULL), m_gaddagNodeCount(0), m_gaddagIsNarrow(false), m_compactGaddag(NULL), m_alphagramIndex(NULL), m_interpreter(NULL)
 {
 	memset(m_hash, 0, sizeof(m_hash));
 }
@@ -151,6 +253,7 @@ void LexiconParameters::unloadAll()
 
 void LexiconParameters::unloadDawg()
 {
+	unloadAlphagramIndex();
 	delete[] m_dawg;
 	m_dawg = NULL;
 	delete m_interpreter;
@@ -161,6 +264,31 @@ void LexiconParameters::unloadGaddag()
 {
 	delete[] m_gaddag;
 	m_gaddag = NULL;
+	m_gaddagNodeCount = 0;
+	m_gaddagIsNarrow = false;
+	delete m_compactGaddag;
+	m_compactGaddag = NULL;
+}
+
+void LexiconParameters::compactGaddag()
+{
+	if (m_gaddag == NULL)
+		return;
+
+	if (m_gaddagIsNarrow)
+		m_compactGaddag = new CompactGaddag(narrowGaddagRoot(), m_gaddagNodeCount);
+	else
+		m_compactGaddag = new CompactGaddag(gaddagRoot(), m_gaddagNodeCount);
+	delete[] m_gaddag;
+	m_gaddag = NULL;
+	m_gaddagIsNarrow = false;
+}
+
+size_t LexiconParameters::gaddagBytes() const
+{
+	if (m_compactGaddag)
+		return m_compactGaddag->bytes();
+	return m_gaddagNodeCount * (m_gaddagIsNarrow? sizeof(NarrowGaddagNode) : sizeof(GaddagNode));
 }
 
 void LexiconParameters::loadDawg(const string &filename)
@@ -186,7 +314,43 @@ void LexiconParameters::loadDawg(const string &filename)
 	m_dawg = new unsigned char[file.tellg()];
 	file.seekg(0, ios_base::beg);
 
-	m_interpreter->loadDawg(file, *this);
+	// unloaded here rather than by the interpreter, which unloading
+	// deletes
+	if (!m_interpreter->loadDawg(file, *this))
+	{
+		UVcout << "couldn't load dawg " << filename.c_str() << endl;
+		unloadDawg();
+	}
+}
+
+void LexiconParameters::loadAlphagramIndex(const string &filename)
+{
+	unloadAlphagramIndex();
+	if (!hasDawg())
+		return;
+
+	m_alphagramIndex = new AlphagramIndex;
+	if (!m_alphagramIndex->load(filename, *this))
+	{
+		UVcout << "couldn't load alphagram index " << filename.c_str() << endl;
+		unloadAlphagramIndex();
+	}
+}
+
+void LexiconParameters::buildAlphagramIndex()
+{
+	unloadAlphagramIndex();
+	if (!hasDawg())
+		return;
+
+	m_alphagramIndex = new AlphagramIndex;
+	m_alphagramIndex->build(*this);
+}
+
+void LexiconParameters::unloadAlphagramIndex()
+{
+	delete m_alphagramIndex;
+	m_alphagramIndex = NULL;
 }
 
 void LexiconParameters::loadGaddag(const string &filename)
@@ -201,11 +365,11 @@ void LexiconParameters::loadGaddag(const string &filename)
 		return;
 	}
 
+	// a gaddag from before hashes can't be checked against a dawg
+	// that has one; otherwise the versions needn't match
 	char versionByte = file.get();
-	if (versionByte < m_interpreter->versionNumber())
+	if (versionByte == 0 && m_interpreter && m_interpreter->versionNumber() > 0)
 		return;
-	file.seekg(0, ios_base::end);
-	m_gaddag = new unsigned char[file.tellg()];
 	file.seekg(0, ios_base::beg);
 
 	// must create a local interpreter because dawg/gaddag versions might not match
@@ -283,6 +447,8 @@ LexiconInterpreter* LexiconParameters::createInterpreter(char version) const
 			return new V0LexiconInterpreter();
 		case 1:
 			return new V1LexiconInterpreter();
+		case 2:
+			return new V2LexiconInterpreter();
 		default:
 			return NULL;
 	}
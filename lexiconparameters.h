@@ -21,30 +21,40 @@
 
 #include <vector>
 
-#include "gaddag.h"
+#include "compactgaddag.h"
 
 namespace Quackle
 {
 
+class AlphagramIndex;
 class LexiconParameters;
 
 class LexiconInterpreter
 {
 public:
-	virtual void loadDawg(ifstream &file, LexiconParameters &lexparams) = 0;
+	// false if the dawg can't be loaded, leaving lexparams to unload it
+	virtual bool loadDawg(ifstream &file, LexiconParameters &lexparams) = 0;
 	virtual void loadGaddag(ifstream &file, LexiconParameters &lexparams) = 0;
 	virtual void dawgAt(const unsigned char *dawg, int index, unsigned int &p, Letter &letter, bool &t, bool &lastchild, bool &british, int &playability) const = 0;
 	virtual int versionNumber() const = 0;
 	virtual ~LexiconInterpreter() {};
+
+protected:
+	// reads the 4-byte gaddag nodes of versions 0 and 1 up to the
+	// end of the file
+	static void loadNarrowGaddag(ifstream &file, LexiconParameters &lexparams);
 };
 
 class V0LexiconInterpreter;
 class V1LexiconInterpreter;
+class V2LexiconInterpreter;
 
 class LexiconParameters
 {
+	friend class Quackle::LexiconInterpreter;
 	friend class Quackle::V0LexiconInterpreter;
 	friend class Quackle::V1LexiconInterpreter;
+	friend class Quackle::V2LexiconInterpreter;
 
 public:
 	LexiconParameters();
@@ -55,7 +65,8 @@ public:
 	// true if we have a dawg or a gaddag
 	bool hasSomething() const { return hasDawg() || hasGaddag(); };
 
-	// loadDawg unloads the dawg if filename can't be opened
+	// loadDawg unloads the dawg if filename can't be opened;
+	// unloading the dawg unloads the alphagram index too
 	void loadDawg(const string &filename);
 	void unloadDawg();
 	bool hasDawg() const { return m_dawg != NULL; };
@@ -64,7 +75,30 @@ public:
 	// loadGaddag unloads the gaddag if filename can't be opened
 	void loadGaddag(const string &filename);
 	void unloadGaddag();
-	bool hasGaddag() const { return m_gaddag != NULL; };
+	bool hasGaddag() const { return m_gaddag != NULL || m_compactGaddag != NULL; };
+
+	// Replaces the loaded gaddag with a CompactGaddag, which holds
+	// it in less than half the memory but is a little slower to walk.
+	void compactGaddag();
+	bool hasCompactGaddag() const { return m_compactGaddag != NULL; };
+
+	// A gaddag not compacted is held in its file's node layout,
+	// NarrowGaddagNode for versions 0 and 1 and GaddagNode for 2.
+	bool hasNarrowGaddag() const { return m_gaddag != NULL && m_gaddagIsNarrow; };
+
+	// memory held by the gaddag in whichever form it's in
+	size_t gaddagBytes() const;
+
+	// Loads an index of the dawg's words by alphagram, used for exact
+	// anagrams. Unloads the index if filename can't be opened or was
+	// built from a different dawg.
+	void loadAlphagramIndex(const string &filename);
+
+	// builds the index from the loaded dawg instead
+	void buildAlphagramIndex();
+	void unloadAlphagramIndex();
+	bool hasAlphagramIndex() const { return m_alphagramIndex != NULL; };
+	const AlphagramIndex &alphagramIndex() const { return *m_alphagramIndex; };
 
 	// finds a file in the lexica data directory
 	static string findDictionaryFile(const string &lexicon);
@@ -79,6 +113,8 @@ public:
 		m_interpreter->dawgAt(m_dawg, index, p, letter, t, lastchild, british, playability);
 	}
 	const GaddagNode *gaddagRoot() const { return (GaddagNode *) &m_gaddag[0]; };
+	const NarrowGaddagNode *narrowGaddagRoot() const { return (NarrowGaddagNode *) &m_gaddag[0]; };
+	CompactGaddagNode compactGaddagRoot() const { return m_compactGaddag->root(); };
 
 	string hashString(bool shortened) const;
 	string copyrightString() const;
@@ -88,6 +124,10 @@ public:
 protected:
 	unsigned char *m_dawg;
 	unsigned char *m_gaddag;
+	size_t m_gaddagNodeCount;
+	bool m_gaddagIsNarrow;
+	CompactGaddag *m_compactGaddag;
+	AlphagramIndex *m_alphagramIndex;
 	string m_lexiconName;
 	LexiconInterpreter *m_interpreter;
 	char m_hash[16];
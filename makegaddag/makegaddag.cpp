@@ -92,14 +92,19 @@ int main(int argc, char **argv)
 			UVcout << "not encodable without leftover: " << QuackleIO::Util::qstringToString(originalQString) << endl;
 	}
 	
-	UVcout << "Sorting " << factory.wordCount() << " words..." << endl;
-	factory.sortWords();
-
-	UVcout << "Generating nodes...";
+	UVcout << "Generating nodes for " << factory.wordCount() << " words...";
 	factory.generate();
 
 	UVcout << "Writing index...";
-	factory.writeIndex(outputFilename.toUtf8().constData());
+	if (!factory.writeIndex(outputFilename.toUtf8().constData()))
+	{
+		UVcout << " too large for format 1, using format 2...";
+		if (!factory.writeIndex(outputFilename.toUtf8().constData(), 2))
+		{
+			UVcout << endl << "Could not write " << QuackleIO::Util::qstringToString(outputFilename) << "." << endl;
+			return 1;
+		}
+	}
 
 	UVcout << endl;
 
@@ -19,6 +19,8 @@
 #include <map>
 #include <QtCore>
 
+#include "alphagramindex.h"
+#include "lexiconparameters.h"
 #include "quackleio/dawgfactory.h"
 #include "quackleio/froggetopt.h"
 #include "quackleio/util.h"
@@ -140,7 +142,23 @@ int main(int argc, char **argv)
 
 	UVcout << "Hash: " << QString(QByteArray(factory.hashBytes(), 16).toHex()).toStdString() << endl;
 
-	factory.writeIndex("output.dawg");
+	if (!factory.writeIndex("output.dawg"))
+	{
+		UVcout << "Too large for format 1, using format 2." << endl;
+		if (!factory.writeIndex("output.dawg", 2))
+		{
+			UVcout << "Could not write output.dawg." << endl;
+			return 1;
+		}
+	}
+
+	// index the dawg as written, so the index carries its hash
+	Quackle::LexiconParameters lexicon;
+	lexicon.loadDawg("output.dawg");
+	Quackle::AlphagramIndex alphagramIndex;
+	alphagramIndex.build(lexicon);
+	if (!alphagramIndex.save("output.alphagrams"))
+		UVcout << "Could not write output.alphagrams." << endl;
 
 	return 0;
 }
@@ -0,0 +1,116 @@
+/*
+ *  Quackle -- Crossword game artificial intelligence and analysis tool
+ *  Copyright (C) 2005-2019 Jason Katz-Brown, John O'Laughlin, and John Fultz.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <bitset>
+#include <limits>
+
+#include "packedmove.h"
+
+using namespace Quackle;
+
+PackedMove::PackedMove()
+	: m_tiles(static_cast<uint64_t>(Move::Pass) << actionShift), m_playedThru(0), m_score(0), m_row(0), m_column(0)
+{
+}
+
+PackedMove::PackedMove(const Move &move)
+	: m_tiles(0), m_playedThru(0), m_score(move.score), m_row(move.startrow), m_column(move.startcol)
+{
+	int used = 0;
+	int index = 0;
+	for (const auto &it : move.tiles())
+	{
+		if (Move::isAlreadyOnBoard(it))
+			m_playedThru |= 1u << index;
+		else
+			m_tiles |= static_cast<uint64_t>(it) << (letterBits * used++);
+		++index;
+	}
+
+	m_tiles |= static_cast<uint64_t>(used) << countShift;
+	m_tiles |= static_cast<uint64_t>(move.action) << actionShift;
+
+	if (move.horizontal)
+		m_row |= horizontalFlag;
+	if (move.isBingo)
+		m_row |= bingoFlag;
+}
+
+bool PackedMove::canPack(const Move &move)
+{
+	if (move.isChallengedPhoney() || move.scoreAddition() != 0)
+		return false;
+
+	if (move.score < numeric_limits<int16_t>::min() || move.score > numeric_limits<int16_t>::max())
+		return false;
+
+	if (move.startrow < 0 || move.startrow > rowMask || move.startcol < 0 || move.startcol > numeric_limits<uint8_t>::max())
+		return false;
+
+	if (move.tiles().length() > maximumLength)
+		return false;
+
+	int used = 0;
+	for (const auto &it : move.tiles())
+	{
+		if (Move::isAlreadyOnBoard(it))
+			continue;
+		if (++used > maximumUsedTiles || it >= (1 << letterBits))
+			return false;
+	}
+
+	return true;
+}
+
+LetterString PackedMove::tiles() const
+{
+	LetterString ret;
+	const int length = usedTileCount() + bitset<maximumLength>(m_playedThru).count();
+
+	int used = 0;
+	for (int i = 0; i < length; ++i)
+	{
+		if (m_playedThru & (1u << i))
+			ret.push_back(QUACKLE_PLAYED_THRU_MARK);
+		else
+			ret.push_back(usedTile(used++));
+	}
+
+	return ret;
+}
+
+int PackedMove::firstUsedTileIndex() const
+{
+	int index = 0;
+	while (index < maximumLength && (m_playedThru & (1u << index)))
+		++index;
+	return index;
+}
+
+Move PackedMove::unpack() const
+{
+	Move move;
+	move.action = action();
+	move.setTiles(tiles());
+	move.horizontal = horizontal();
+	move.startrow = startrow();
+	move.startcol = startcol();
+	move.score = score();
+	move.isBingo = isBingo();
+	return move;
+}
@@ -0,0 +1,138 @@
+/*
+ *  Quackle -- Crossword game artificial intelligence and analysis tool
+ *  Copyright (C) 2005-2019 Jason Katz-Brown, John O'Laughlin, and John Fultz.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QUACKLE_PACKEDMOVE_H
+#define QUACKLE_PACKEDMOVE_H
+
+#include <cstdint>
+
+#include "move.h"
+
+namespace Quackle
+{
+
+// A move squeezed into 16 bytes, for code that keeps many moves
+// around, like the generator's list of every legal play. Holds the
+// action, position, direction, score, bingo flag and tiles; equity,
+// win and pretty tiles aren't kept, so unpack() leaves them unset.
+class PackedMove
+{
+public:
+	// the most tiles from the rack a packed move can hold, and the
+	// longest its tiles can be counting played-thru letters
+	enum { maximumUsedTiles = 8, maximumLength = 32 };
+
+	// a pass
+	PackedMove();
+
+	// move must be packable
+	explicit PackedMove(const Move &move);
+
+	// false for challenged phoneys, moves with a score addition, and
+	// moves too long or too high scoring to fit
+	static bool canPack(const Move &move);
+
+	Move unpack() const;
+
+	Move::Action action() const;
+	bool horizontal() const;
+	int startrow() const;
+	int startcol() const;
+	int score() const;
+	bool isBingo() const;
+
+	// tiles like .ANELINg, as Move::tiles()
+	LetterString tiles() const;
+
+	// number of tiles not played thru
+	int usedTileCount() const;
+
+	// index into tiles() of the first tile not played thru
+	int firstUsedTileIndex() const;
+
+	// the index'th tile not played thru
+	Letter usedTile(int index) const;
+
+	bool operator==(const PackedMove &other) const;
+
+private:
+	enum { letterBits = 7, countShift = 56, actionShift = 60 };
+	enum { rowMask = 0x3f, bingoFlag = 0x40, horizontalFlag = 0x80 };
+
+	// used tiles 7 bits each from the low end, then their count and
+	// the action in the top two nibbles
+	uint64_t m_tiles;
+
+	// bit i is set if tile i is played thru
+	uint32_t m_playedThru;
+
+	int16_t m_score;
+
+	// low six bits are the row; also bingo and horizontal flags
+	uint8_t m_row;
+	uint8_t m_column;
+};
+
+inline Move::Action PackedMove::action() const
+{
+	return static_cast<Move::Action>(m_tiles >> actionShift);
+}
+
+inline bool PackedMove::horizontal() const
+{
+	return m_row & horizontalFlag;
+}
+
+inline int PackedMove::startrow() const
+{
+	return m_row & rowMask;
+}
+
+inline int PackedMove::startcol() const
+{
+	return m_column;
+}
+
+inline int PackedMove::score() const
+{
+	return m_score;
+}
+
+inline bool PackedMove::isBingo() const
+{
+	return m_row & bingoFlag;
+}
+
+inline int PackedMove::usedTileCount() const
+{
+	return (m_tiles >> countShift) & 0xf;
+}
+
+inline Letter PackedMove::usedTile(int index) const
+{
+	return (m_tiles >> (index * letterBits)) & ((1 << letterBits) - 1);
+}
+
+inline bool PackedMove::operator==(const PackedMove &other) const
+{
+	return m_tiles == other.m_tiles && m_playedThru == other.m_playedThru && m_score == other.m_score && m_row == other.m_row && m_column == other.m_column;
+}
+
+}
+
+#endif
@@ -270,7 +270,8 @@ void LexiconDialog::accept()
 	m_wordFactory->generate();
 	m_lexiconInformation->setText(tr("Writing dictionary file..."));
 	qApp->processEvents();
-	m_wordFactory->writeIndex(filename);
+	if (!m_wordFactory->writeIndex(filename))
+		m_wordFactory->writeIndex(filename, 2); // too many nodes for 24-bit pointers
 	m_finalLexiconName = m_lexiconName->text();
 	QDialog::accept();
 }
@@ -26,6 +26,7 @@
 #endif // Q_OS_MAC
 
 #include "alphabetparameters.h"
+#include "alphagramindex.h"
 #include "board.h"
 #include "boardparameters.h"
 #include "computerplayercollection.h"
@@ -259,17 +260,24 @@ void Settings::buildGaddag()
 
 	setGaddagLabel(tr("Words processed: 0"));
 	pushIndex(factory, word, 1, wordCount);
-	if (wordCount < QUACKLE_MAX_GADDAG_WORDCOUNT)
+	setGaddagLabel(QString(tr("Lexicon total: %1 words.  Compressing...")).arg(wordCount));
+	factory.generate();
+	setGaddagLabel(QString(tr("Lexicon total: %1 words.  Writing to disk...")).arg(wordCount));
+	if (factory.writeIndex(gaddagFile) || factory.writeIndex(gaddagFile, 2))
 	{
-		setGaddagLabel(QString(tr("Lexicon total: %1 words.  Compressing...")).arg(wordCount));
-		factory.generate();
-		setGaddagLabel(QString(tr("Lexicon total: %1 words.  Writing to disk...")).arg(wordCount));
-		factory.writeIndex(gaddagFile);
 		QUACKLE_LEXICON_PARAMETERS->loadGaddag(gaddagFile);
+
+		// the alphagram index is optional, so failing to save it isn't fatal
+		QUACKLE_LEXICON_PARAMETERS->buildAlphagramIndex();
+		if (QUACKLE_LEXICON_PARAMETERS->hasAlphagramIndex())
+		{
+			const string alphagramFile(QUACKLE_DATAMANAGER->makeDataFilename("lexica", QUACKLE_LEXICON_PARAMETERS->lexiconName() + ".alphagrams", true));
+			QUACKLE_LEXICON_PARAMETERS->alphagramIndex().save(alphagramFile);
+		}
 		setGaddagLabel();
 	}
 	else
-		setGaddagLabel(tr("Your lexicon is too large to be represented using the internal database format.  Operation aborted."));
+		setGaddagLabel(tr("The lexicon database could not be written.  Operation aborted."));
 }
 
 void Settings::pushIndex(GaddagFactory &factory, Quackle::LetterString &word, int index, int &wordCount)
@@ -291,15 +299,9 @@ void Settings::pushIndex(GaddagFactory &factory, Quackle::LetterString &word, in
 			wordCount++;
 			if (wordCount % 1000 == 0)
 				setGaddagLabel(QString(tr("Words processed: %1")).arg(wordCount));
-			if (wordCount > QUACKLE_MAX_GADDAG_WORDCOUNT)
-				return;
 		}
 		if (p)
-		{
 			pushIndex(factory, word, p, wordCount);
-			if (wordCount > QUACKLE_MAX_GADDAG_WORDCOUNT)
-				return;
-		}
 		index++;
 		word.pop_back();
 	} while (!lastchild);
@@ -330,6 +332,10 @@ void Settings::setQuackleToUseLexiconName(const QString &lexiconName)
 			return;
 		}
 
+		string alphagramFile = Quackle::LexiconParameters::findDictionaryFile(lexiconNameStr + ".alphagrams");
+		if (!alphagramFile.empty())
+			QUACKLE_LEXICON_PARAMETERS->loadAlphagramIndex(alphagramFile);
+
 		string gaddagFile = Quackle::LexiconParameters::findDictionaryFile(lexiconNameStr + ".gaddag");
 		if (gaddagFile.empty())
 		{
@@ -17,6 +17,7 @@
  */
 
 
+#include <algorithm>
 #include <iomanip>
 #include <ios>
 #include <iostream>
@@ -29,17 +30,15 @@
 
 DawgFactory::DawgFactory(const QString &alphabetFile)
 	: m_encodableWords(0), m_unencodableWords(0), m_duplicateWords(0),
-	m_countsByLength(Quackle::FixedLengthString::maxSize, 0)
+	m_countsByLength(Quackle::FixedLengthString::maxSize, 0), m_registered(0), m_rootBlock(0)
 {
 	QuackleIO::FlexibleAlphabetParameters *flexure = new QuackleIO::FlexibleAlphabetParameters;
 	flexure->load(alphabetFile);
 	m_alphas = flexure;
 
-	m_root.insmallerdict = false;
-	m_root.playability = 0;
-	m_root.c = QUACKLE_BLANK_MARK;
-	m_root.pointer = 0;
-	m_root.lastchild = true;
+	TrieNode root = { QUACKLE_BLANK_MARK, false, 0, 0, 0 };
+	m_trie.push_back(root);
+	m_blockStarts.push_back(0);
 
 	m_hash.int32ptr[0] = m_hash.int32ptr[1] = m_hash.int32ptr[2] = m_hash.int32ptr[3] = 0;
 }
@@ -62,7 +61,38 @@ bool DawgFactory::pushWord(const UVString &word, bool inSmaller, int playability
 
 bool DawgFactory::pushWord(const Quackle::LetterString &word, bool inSmaller, int playability)
 {
-	if (m_root.pushWord(word, inSmaller, playability))
+	uint32_t node = 0;
+	for (unsigned int i = 0; i < word.length(); i++)
+	{
+		const Quackle::Letter letter = word[i];
+		uint32_t child = m_trie[node].firstChild;
+		uint32_t lastChild = 0;
+		while (child != 0 && m_trie[child].c != letter)
+		{
+			lastChild = child;
+			child = m_trie[child].nextSibling;
+		}
+
+		if (child == 0)
+		{
+			TrieNode n = { letter, false, 0, 0, 0 };
+			child = (uint32_t)m_trie.size();
+			m_trie.push_back(n);
+			if (lastChild == 0)
+				m_trie[node].firstChild = child;
+			else
+				m_trie[lastChild].nextSibling = child;
+		}
+
+		node = child;
+	}
+
+	TrieNode &terminal = m_trie[node];
+	const bool added = (terminal.playability == 0);
+	terminal.playability = (playability == 0) ? 1 : playability; // word terminators nodes are marked by nonzero playability in the v1 DAWG format
+	terminal.insmallerdict = inSmaller;
+
+	if (added)
 	{
 		++m_encodableWords;
 		++m_countsByLength[word.length()];
@@ -86,67 +116,130 @@ void DawgFactory::hashWord(const Quackle::LetterString &word)
 
 void DawgFactory::generate()
 {
-	const int bucketcount = 2000;
-	vector< int > bucket[bucketcount];
+	m_arcs.clear();
+	m_blockStarts.assign(1, 0);
+	m_register.clear();
+	m_registered = 0;
+
+	// A child is always pushed after its parent, so going backwards
+	// registers every child list before the lists that point to it.
+	vector<uint32_t> blocks(m_trie.size(), 0);
+	vector<Arc> arcs;
+	for (size_t node = m_trie.size(); node-- > 0; )
+	{
+		if (m_trie[node].firstChild == 0)
+			continue;
 
-	m_nodelist.clear();
-	m_nodelist.push_back(&m_root);
-	m_root.print(m_nodelist);
+		arcs.clear();
+		for (uint32_t child = m_trie[node].firstChild; child != 0; child = m_trie[child].nextSibling)
+		{
+			const TrieNode &n = m_trie[child];
+			Arc arc = { n.c, n.insmallerdict, n.playability, blocks[child] };
+			arcs.push_back(arc);
+		}
+		blocks[node] = registerBlock(arcs);
+	}
 
-	m_nodelist[0]->letterSum();
+	m_rootBlock = blocks[0];
+	vector<uint32_t>().swap(m_register);
+}
 
-	for (unsigned int i = 0; i < m_nodelist.size(); i++)
-	{
-		bucket[m_nodelist[i]->sum % bucketcount].push_back(i);
-		m_nodelist[i]->pointer = 0;
-		m_nodelist[i]->written = false;
-		m_nodelist[i]->deleted = false;
-		m_nodelist[i]->cloneof = NULL;
-	}
+size_t DawgFactory::hashBlock(const Arc *arcs, size_t count) const
+{
+	size_t hash = count;
+	for (size_t i = 0; i < count; ++i)
+		hash = (hash * 1000003 ^ ((size_t)arcs[i].block << 8 | arcs[i].c << 1 | arcs[i].insmallerdict)) * 31 + arcs[i].playability;
+	return hash;
+}
+
+uint32_t DawgFactory::registerBlock(const vector<Arc> &arcs)
+{
+	if ((m_registered + 1) * 2 > m_register.size())
+		growRegister();
 
-	for (int b = 0; b < bucketcount; b++)
+	const size_t mask = m_register.size() - 1;
+	for (size_t slot = hashBlock(arcs.data(), arcs.size()) & mask; ; slot = (slot + 1) & mask)
 	{
-		if (bucket[b].size() == 0)
-			continue;
-		for (vector<int>::iterator it = bucket[b].begin(); it != bucket[b].end() - 1; it++)
+		const uint32_t block = m_register[slot];
+		if (block == 0)
 		{
-			if (!m_nodelist[(*it)]->deleted)
-			{	
-				for (vector<int>::iterator jt = it + 1; jt != bucket[b].end(); jt++)
-				{
-					if (!m_nodelist[(*jt)]->deleted)
-					{
-						// cout << "Comparing " << (*it) << " and " << (*jt) << endl;
-						if (m_nodelist[(*it)]->equals(m_nodelist[(*jt)][0]))
-						{
-							//cout << "Hey! " << (*it) << " == " << (*jt) << endl;
-							// ones[l].erase(jt);
-							m_nodelist[(*jt)]->deleted = true;
-							m_nodelist[(*jt)]->cloneof = m_nodelist[(*it)];
-						}
-					}
-				}
-			}
+			m_arcs.insert(m_arcs.end(), arcs.begin(), arcs.end());
+			m_blockStarts.push_back((uint32_t)m_arcs.size());
+			m_register[slot] = (uint32_t)m_blockStarts.size() - 1;
+			++m_registered;
+			return m_register[slot];
 		}
+
+		const uint32_t start = m_blockStarts[block - 1];
+		if (m_blockStarts[block] - start == arcs.size() && equal(arcs.begin(), arcs.end(), m_arcs.begin() + start))
+			return block;
 	}
-	
-	m_nodelist.clear();
-	m_nodelist.push_back(&m_root);
-	m_root.print(m_nodelist);
 }
 
-void DawgFactory::writeIndex(const string &filename)
+void DawgFactory::growRegister()
 {
+	vector<uint32_t> grown(max((size_t)1024, m_register.size() * 2), 0);
+	const size_t mask = grown.size() - 1;
+
+	for (uint32_t block = 1; block < m_blockStarts.size(); ++block)
+	{
+		const uint32_t start = m_blockStarts[block - 1];
+		size_t slot = hashBlock(&m_arcs[start], m_blockStarts[block] - start) & mask;
+		while (grown[slot] != 0)
+			slot = (slot + 1) & mask;
+		grown[slot] = block;
+	}
+
+	m_register.swap(grown);
+}
+
+bool DawgFactory::writeIndex(const string &filename, int version)
+{
+	if (version != 1 && version != 2)
+		return false;
+
+	// Blocks go out newest first, which puts the root's children
+	// right after the root at node 0. Pointers are absolute.
+	const uint32_t blockCount = (uint32_t)m_blockStarts.size() - 1;
+	vector<uint32_t> location(blockCount + 1, 0);
+	uint32_t next = 1;
+	for (uint32_t block = blockCount; block >= 1; --block)
+	{
+		location[block] = next;
+		next += m_blockStarts[block] - m_blockStarts[block - 1];
+	}
+
+	if (version == 1 && next - 1 > 0xFFFFFF)
+		return false;
+
 	ofstream out(filename.c_str(), ios::out | ios::binary);
-	unsigned char bytes[7];
+	if (!out)
+		return false;
 
-	bytes[0] = (m_encodableWords & 0x00FF0000) >> 16;
-	bytes[1] = (m_encodableWords & 0x0000FF00) >>  8;
-	bytes[2] = (m_encodableWords & 0x000000FF);
+	unsigned char bytes[8];
 
-	out.put(1); // DAWG format version 1
+	out.put(version); // DAWG format version
 	out.write(m_hash.charptr, sizeof(m_hash.charptr));
-	out.write((char*)bytes, 3);
+	if (version == 1)
+	{
+		bytes[0] = (m_encodableWords & 0x00FF0000) >> 16;
+		bytes[1] = (m_encodableWords & 0x0000FF00) >>  8;
+		bytes[2] = (m_encodableWords & 0x000000FF);
+		out.write((char*)bytes, 3);
+	}
+	else
+	{
+		const uint32_t nodes = nodeCount();
+		bytes[0] = (m_encodableWords & 0xFF000000) >> 24;
+		bytes[1] = (m_encodableWords & 0x00FF0000) >> 16;
+		bytes[2] = (m_encodableWords & 0x0000FF00) >>  8;
+		bytes[3] = (m_encodableWords & 0x000000FF);
+		bytes[4] = (nodes & 0xFF000000) >> 24;
+		bytes[5] = (nodes & 0x00FF0000) >> 16;
+		bytes[6] = (nodes & 0x0000FF00) >>  8;
+		bytes[7] = (nodes & 0x000000FF);
+		out.write((char*)bytes, 8);
+	}
 	out.put((char)m_alphas->length());
 	for (Quackle::Letter i = m_alphas->firstLetter(); i <= m_alphas->lastLetter(); i++)
 	{
@@ -156,37 +249,38 @@ void DawgFactory::writeIndex(const string &filename)
 		out << utf8LetterText << ' ';
 	}
 
-	for (unsigned int i = 0; i < m_nodelist.size(); i++) {
-		//cout << m_nodelist[i]->c << " " << m_nodelist[i]->pointer << " " << m_nodelist[i]->t << " " << m_nodelist[i]->lastchild << endl;
-		Node* n = m_nodelist[i];
-		unsigned int p;
-		if (m_nodelist[i]->deleted)
-		{
-			p = (unsigned int)(m_nodelist[i]->cloneof->pointer);
-			// n = m_nodelist[i]->cloneof;
-		}
-		else
-			p = (unsigned int)(m_nodelist[i]->pointer);
-
-		bytes[0] = (p & 0x00FF0000) >> 16;
-		bytes[1] = (p & 0x0000FF00) >>  8;
-		bytes[2] = (p & 0x000000FF);
-		bytes[3] = n->c - QUACKLE_FIRST_LETTER;
-				
-		unsigned int pb = n->playability;
-		bytes[4] = (pb & 0x00FF0000) >> 16;
-		bytes[5] = (pb & 0x0000FF00) >>  8;
-		bytes[6] = (pb & 0x000000FF);
-
-		if (n->lastchild) {
-			bytes[3] |= 64;
+	// version 2 widens the pointer to 32 bits, making nodes 8 bytes
+	const int pointerBytes = (version == 1) ? 3 : 4;
+	auto writeNode = [&](const Arc &n, bool lastchild) {
+		unsigned int p = location[n.block];
+		for (int i = 0; i < pointerBytes; i++)
+			bytes[i] = (p >> (8 * (pointerBytes - 1 - i))) & 0xFF;
+
+		unsigned char *rest = bytes + pointerBytes;
+		rest[0] = n.c - QUACKLE_FIRST_LETTER;
+
+		unsigned int pb = n.playability;
+		rest[1] = (pb & 0x00FF0000) >> 16;
+		rest[2] = (pb & 0x0000FF00) >>  8;
+		rest[3] = (pb & 0x000000FF);
+
+		if (lastchild) {
+			rest[0] |= 64;
 		}
-		if (n->insmallerdict) {
-			bytes[3] |= 128;
+		if (n.insmallerdict) {
+			rest[0] |= 128;
 		}
 
-		out.write((char*)bytes, 7);
-	}
+		out.write((char*)bytes, pointerBytes + 4);
+	};
+
+	const Arc root = { m_trie[0].c, m_trie[0].insmallerdict, m_trie[0].playability, m_rootBlock };
+	writeNode(root, true);
+	for (uint32_t block = blockCount; block >= 1; --block)
+		for (uint32_t i = m_blockStarts[block - 1]; i < m_blockStarts[block]; ++i)
+			writeNode(m_arcs[i], i == m_blockStarts[block] - 1);
+
+	return out.good();
 }
 
 string DawgFactory::letterCountString() const
@@ -206,121 +300,3 @@ string DawgFactory::letterCountString() const
 	}
 	return str.str();
 }
-
-
-void DawgFactory::Node::print(vector< Node* > &nodelist)
-{
-	written = true;
-	
-	if (children.size() == 0)
-		return;
-
-	if (!deleted)
-	{
-		//cout << "  Setting pointer to " << nodelist.size() << " before I push_back the children." << endl;
-		pointer = (int)nodelist.size();
-	}
-	else
-	{
-		pointer = cloneof->pointer;
-		//cout << "  Setting pointer to clone's (" << pointer << ") and not pushing anything." << endl;
-	}
-
-	if (!deleted)
-	{
-		for (unsigned int i = 0; i < children.size(); i++) {
-			nodelist.push_back(&children[i]);
-		}
-
-		for (unsigned int i = 0; i < children.size(); i++) {
-			if (!children[i].deleted)
-				children[i].print(nodelist);
-			else if (!children[i].cloneof->written)
-				children[i].cloneof->print(nodelist);
-		}
-	}
-
-	if (children.size() > 0)	
-		children[children.size() - 1].lastchild = true;
-}
-
-
-// returns true if the word was actually added...false if it's a duplicate.
-bool DawgFactory::Node::pushWord(const Quackle::LetterString &word, bool inSmaller, int pb)
-{
-	bool added;
-	if (word.length() == 0) {
-		added = (playability == 0);
-		playability = (pb == 0) ? 1 : pb; // word terminators nodes are marked by nonzero playability in the v1 DAWG format
-		insmallerdict = inSmaller;
-	}
-	else {
-		char first = word[0];
-		Quackle::LetterString rest = word.substr(1, word.length() - 1);
-		int index = -1;
- 
-		// cout << "first: " << first << ", rest: " << rest << endl;
-
-		for (unsigned int i = 0; i < children.size(); i++) {
-			if (children[i].c == first) {
-				index = i;
-				break;
-			}
-		}
-		
-		if (index == -1) {
-			Node n;
-			n.c = first;
-			n.playability = 0;
-			n.insmallerdict = false;
-			n.pointer = 0;
-			n.lastchild = false;
-			children.push_back(n);
-			index = (int)children.size() - 1;
-		}
-
-		added = children[index].pushWord(rest, inSmaller, pb);
-	}
-
-	sumexplored = false;
-	deleted = false;
-	written = false;
-	return added;
-}
-
-
-bool DawgFactory::Node::equals(const Node &n) const
-{
-	if (playability != n.playability)
-		return false;
-	if (c != n.c)
-		return false;
-	if (children.size() != n.children.size())
-		return false;
-	if (insmallerdict != n.insmallerdict)
-		return false;
-	if (sum != n.sum)
-		return false;
-
-	for (unsigned int i = 0; i < children.size(); i++)
-		if (!children[i].equals(n.children[i]))
-			return false;
-	
-	return true;
-}
-
-int DawgFactory::Node::letterSum() const
-{
-	if (sumexplored)
-		return sum;
-	
-	sumexplored = true;
-
-	// djb2 checksum
-	sum = 5381 * 33 + (int) c;
-
-	for (unsigned int i = 0; i < children.size(); i++)
-		sum = (sum << 5) + sum + children[i].letterSum();
-
-	return sum;
-}
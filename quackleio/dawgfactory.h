@@ -33,7 +33,8 @@ public:
 
 	int wordCount() const { return m_encodableWords; };
 	string letterCountString() const;
-	int nodeCount() const { return (int)m_nodelist.size(); };
+	// trie nodes before generate(), nodes to be written after
+	int nodeCount() const { return m_arcs.empty()? (int)m_trie.size() : 1 + (int)m_arcs.size(); };
 	int encodableWords() const { return m_encodableWords; };
 	int unencodableWords() const { return m_unencodableWords; };
 	int duplicateWords() const { return m_duplicateWords; };
@@ -42,51 +43,60 @@ public:
 	bool pushWord(const Quackle::LetterString &word, bool inSmaller, int playability);
 	void hashWord(const Quackle::LetterString &word);
 	void generate();
-	void writeIndex(const string &filename);
+	// Writes format version 1, with 24-bit pointers, or version 2,
+	// with 32-bit ones and 8-byte nodes. false if the file couldn't
+	// be written or there are too many nodes for the version.
+	bool writeIndex(const string &filename, int version = 1);
 
 	const char* hashBytes() { return m_hash.charptr; };
 
 private:
-	class Node {
-	public:
-		bool pushWord(const Quackle::LetterString& word, bool inSmaller, int pb);
-		void print(vector< Node* > &m_nodelist);
-
-		int letterSum() const;
-		bool equals(const Node &n) const;
-
+	// Words are pushed into a trie whose children are linked in the
+	// order they were added. generate() then registers each node's
+	// children bottom-up, so identical child lists are stored once.
+	struct TrieNode {
 		Quackle::Letter c;
 		bool insmallerdict;
 		int playability; // if nonzero, then terminates word
+		uint32_t firstChild; // 0 means none, as the root is never a child
+		uint32_t nextSibling;
+	};
 
-		vector<Node> children;
-		int pointer;
-		int location;
-
-		bool lastchild;
+	// A node of the file. Blocks are numbered from 1 in the order
+	// they're registered, so children come before parents; 0 means
+	// no children.
+	struct Arc {
+		Quackle::Letter c;
+		bool insmallerdict;
+		int playability;
+		uint32_t block;
 
-		mutable bool sumexplored;
-		mutable unsigned int sum;
-		mutable vector<int> counts;
-			
-		bool deleted;
-		Node* cloneof;
-		bool written;
+		bool operator==(const Arc &other) const { return c == other.c && insmallerdict == other.insmallerdict && playability == other.playability && block == other.block; };
 	};
 
+	// returns the number of an identical block if there is one, or
+	// stores arcs as a new block
+	uint32_t registerBlock(const vector<Arc> &arcs);
+	size_t hashBlock(const Arc *arcs, size_t count) const;
+	void growRegister();
+
 	int m_encodableWords;
 	int m_unencodableWords;
 	int m_duplicateWords;
-	vector< Node* > m_nodelist;
 	vector<unsigned int> m_countsByLength;
 	Quackle::AlphabetParameters *m_alphas;
-	Node m_root;
+	vector<TrieNode> m_trie;
+
+	// block n is m_arcs[m_blockStarts[n - 1]] up to m_blockStarts[n]
+	vector<Arc> m_arcs;
+	vector<uint32_t> m_blockStarts;
+	vector<uint32_t> m_register;
+	size_t m_registered;
+	uint32_t m_rootBlock;
 	union {
 		char charptr[16];
 		std::int32_t int32ptr[4];
 	} m_hash;
-
-	static const char m_versionNumber = 1;
 };
 
 #endif
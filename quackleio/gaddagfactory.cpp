@@ -17,7 +17,12 @@
  */
 
 
+#include <algorithm>
+#include <condition_variable>
+#include <fstream>
 #include <iostream>
+#include <mutex>
+#include <thread>
 #include <QtCore>
 #include <QCryptographicHash>
 
@@ -25,7 +30,7 @@
 #include "util.h"
 
 GaddagFactory::GaddagFactory(const UVString &alphabetFile)
-	: m_encodableWords(0), m_unencodableWords(0), m_alphas(NULL)
+	: m_encodableWords(0), m_unencodableWords(0), m_alphas(NULL), m_registered(0), m_rootBlock(0)
 {
 	if (!alphabetFile.empty())
 	{
@@ -34,11 +39,7 @@ GaddagFactory::GaddagFactory(const UVString &alphabetFile)
 		m_alphas = flexure;
 	}
 
-	// So the separator is sorted to last.
-	m_root.t = false;
-	m_root.c = QUACKLE_NULL_MARK;  // "_"
-	m_root.pointer = 0;
-	m_root.lastchild = true;
+	m_blockStarts.push_back(0);
 
 	m_hash.int32ptr[0] = m_hash.int32ptr[1] = m_hash.int32ptr[2] = m_hash.int32ptr[3] = 0;
 }
@@ -70,21 +71,7 @@ bool GaddagFactory::pushWord(const Quackle::LetterString &word)
 	// But testing for duplicate words isn't so easy without keeping
 	// an entirely separate list.
 
-	for (unsigned i = 1; i <= word.length(); i++)
-	{
-		Quackle::LetterString newword;
-
-		for (int j = i - 1; j >= 0; j--)
-			newword.push_back(word[j]);
-
-		if (i < word.length())
-		{
-			newword.push_back(internalSeparatorRepresentation);  // "^"
-			for (unsigned j = i; j < word.length(); j++)
-				newword.push_back(word[j]);
-		}
-		m_gaddagizedWords.push_back(newword);
-	}
+	m_words.push_back(word);
 	return true;
 }
 
@@ -99,102 +86,304 @@ void GaddagFactory::hashWord(const Quackle::LetterString &word)
 	m_hash.int32ptr[3] ^= ((const int32_t*)wordhashbytes.constData())[3];
 }
 
-void GaddagFactory::generate()
+Quackle::WordList GaddagFactory::gaddagize(Quackle::Letter letter, const vector<uint32_t> &wordIndexes) const
 {
-	sort(m_gaddagizedWords.begin(), m_gaddagizedWords.end());
-	Quackle::WordList::const_iterator wordsEnd = m_gaddagizedWords.end();
-	for (Quackle::WordList::const_iterator wordsIt = m_gaddagizedWords.begin(); wordsIt != wordsEnd; ++wordsIt)
-		m_root.pushWord(*wordsIt);
-	//	for (const auto& words : gaddaggizedWords)
-	//		m_root.pushWord(words);
+	Quackle::WordList ret;
+
+	for (const auto &index : wordIndexes)
+	{
+		const Quackle::LetterString &word = m_words[index];
+		for (unsigned i = 1; i <= word.length(); i++)
+		{
+			if (word[i - 1] != letter)
+				continue;
+
+			Quackle::LetterString newword;
+
+			for (int j = i - 1; j >= 0; j--)
+				newword.push_back(word[j]);
+
+			if (i < word.length())
+			{
+				newword.push_back(internalSeparatorRepresentation);  // "^"
+				for (unsigned j = i; j < word.length(); j++)
+					newword.push_back(word[j]);
+			}
+			ret.push_back(newword);
+		}
+	}
+
+	// the separator sorts after every letter, as the generator expects
+	sort(ret.begin(), ret.end());
+	return ret;
 }
 
-void GaddagFactory::writeIndex(const string &fname)
+void GaddagFactory::generate()
 {
-	m_nodelist.push_back(&m_root);
+	// which words each letter is in, so a batch reads only its own
+	vector< vector<uint32_t> > wordsWith(256);
+	for (uint32_t index = 0; index < m_words.size(); ++index)
+	{
+		const Quackle::LetterString &word = m_words[index];
+		for (unsigned i = 0; i < word.length(); i++)
+		{
+			vector<uint32_t> &words = wordsWith[(Quackle::Letter)word[i]];
+			if (words.empty() || words.back() != index)
+				words.push_back(index);
+		}
+	}
 
-	m_root.print(m_nodelist);    
+	vector<Quackle::Letter> letters;
+	for (int letter = 0; letter < 256; ++letter)
+		if (!wordsWith[letter].empty())
+			letters.push_back(letter);
+
+	// Workers gaddagize batches in letter order, staying at most
+	// maximumBatchesAhead batches ahead of the one being added to the
+	// graph however many threads there are, as each batch holds every
+	// gaddagized word for its letter.
+	const size_t maximumBatchesAhead = 3;
+	const size_t batchCount = letters.size();
+	const size_t threadCount = min((size_t)max(1u, thread::hardware_concurrency()), maximumBatchesAhead);
+	vector<Quackle::WordList> batches(batchCount);
+	vector<bool> ready(batchCount, false);
+	size_t nextBatch = 0;
+	size_t addedBatches = 0;
+	mutex batchMutex;
+	condition_variable batchCondition;
+
+	auto worker = [&]() {
+		unique_lock<mutex> lock(batchMutex);
+		while (true)
+		{
+			batchCondition.wait(lock, [&]() { return nextBatch >= batchCount || nextBatch < addedBatches + maximumBatchesAhead; });
+			if (nextBatch >= batchCount)
+				return;
+
+			const size_t batch = nextBatch++;
+			lock.unlock();
+			Quackle::WordList words = gaddagize(letters[batch], wordsWith[letters[batch]]);
+			vector<uint32_t>().swap(wordsWith[letters[batch]]);
+			lock.lock();
+
+			batches[batch].swap(words);
+			ready[batch] = true;
+			batchCondition.notify_all();
+		}
+	};
 
-	ofstream out(fname.c_str(), ios::out | ios::binary);
+	vector<thread> threads;
+	for (size_t i = 0; i < threadCount; ++i)
+		threads.emplace_back(worker);
 
-	out.put(1); // GADDAG format version 1
-	out.write(m_hash.charptr, sizeof(m_hash.charptr));
+	vector<Arc> rootArcs;
+	for (size_t batch = 0; batch < batchCount; ++batch)
+	{
+		Quackle::WordList words;
+		{
+			unique_lock<mutex> lock(batchMutex);
+			batchCondition.wait(lock, [&]() { return ready[batch]; });
+			words.swap(batches[batch]);
+			addedBatches = batch + 1;
+			batchCondition.notify_all();
+		}
+
+		if (!words.empty())
+			rootArcs.push_back(addBatch(words));
+	}
+
+	for (auto &it : threads)
+		it.join();
 
-	for (unsigned int i = 0; i < m_nodelist.size(); i++)
+	m_rootBlock = rootArcs.empty()? 0 : registerBlock(rootArcs);
+	m_open.clear();
+	vector<uint32_t>().swap(m_register);
+}
+
+GaddagFactory::Arc GaddagFactory::addBatch(const Quackle::WordList &words)
+{
+	m_open.assign(1, vector<Arc>());
+
+	const Quackle::LetterString *previous = 0;
+	Quackle::WordList::const_iterator wordsEnd = words.end();
+	for (Quackle::WordList::const_iterator wordsIt = words.begin(); wordsIt != wordsEnd; ++wordsIt)
 	{
-		unsigned int p = (unsigned int)(m_nodelist[i]->pointer);
-		if (p != 0)
-			p -= i; // offset indexing
+		const Quackle::LetterString &word = *wordsIt;
 
-		char bytes[4];
-		unsigned char n1 = (p & 0x00FF0000) >> 16;
-		unsigned char n2 = (p & 0x0000FF00) >> 8;
-		unsigned char n3 = (p & 0x000000FF) >> 0;
-		unsigned char n4; 
+		size_t common = 0;
+		if (previous)
+		{
+			if (word == *previous)
+				continue;
+			while (common < previous->length() && common < word.length() && word[common] == (*previous)[common])
+				++common;
+		}
 
-		n4 = m_nodelist[i]->c;
-		if (n4 == internalSeparatorRepresentation)
-			n4 = QUACKLE_NULL_MARK;
+		// nothing deeper than the shared prefix can change any more
+		closeDeeperThan(common + 1);
 
-		if (m_nodelist[i]->t)
-			n4 |= 64;
+		for (size_t depth = common; depth < word.length(); ++depth)
+		{
+			if (depth == m_open.size())
+				m_open.push_back(vector<Arc>());
+			Arc arc = { (Quackle::Letter)word[depth], false, 0 };
+			m_open[depth].push_back(arc);
+		}
+		m_open[word.length() - 1].back().t = true;
 
-		if (m_nodelist[i]->lastchild)
-			n4 |= 128;
+		previous = &word;
+	}
 
-		bytes[0] = n1; bytes[1] = n2; bytes[2] = n3; bytes[3] = n4;
-		out.write(bytes, 4);
+	closeDeeperThan(1);
+	return m_open.front().front();
+}
+
+void GaddagFactory::closeDeeperThan(size_t depth)
+{
+	while (m_open.size() > depth)
+	{
+		const uint32_t block = registerBlock(m_open.back());
+		m_open.pop_back();
+		m_open.back().back().block = block;
 	}
 }
 
+size_t GaddagFactory::hashBlock(const Arc *arcs, size_t count) const
+{
+	size_t hash = count;
+	for (size_t i = 0; i < count; ++i)
+		hash = hash * 1000003 ^ ((size_t)arcs[i].block << 8 | arcs[i].c << 1 | arcs[i].t);
+	return hash;
+}
 
-void GaddagFactory::Node::print(vector< Node* >& nodelist)
+uint32_t GaddagFactory::registerBlock(const vector<Arc> &arcs)
 {
-	if (children.size() > 0)
+	if ((m_registered + 1) * 2 > m_register.size())
+		growRegister();
+
+	const size_t mask = m_register.size() - 1;
+	for (size_t slot = hashBlock(arcs.data(), arcs.size()) & mask; ; slot = (slot + 1) & mask)
 	{
-		pointer = (int)nodelist.size();
-		children[children.size() - 1].lastchild = true;
+		const uint32_t block = m_register[slot];
+		if (block == 0)
+		{
+			m_arcs.insert(m_arcs.end(), arcs.begin(), arcs.end());
+			m_blockStarts.push_back((uint32_t)m_arcs.size());
+			m_register[slot] = (uint32_t)m_blockStarts.size() - 1;
+			++m_registered;
+			return m_register[slot];
+		}
+
+		const uint32_t start = m_blockStarts[block - 1];
+		if (m_blockStarts[block] - start == arcs.size() && equal(arcs.begin(), arcs.end(), m_arcs.begin() + start))
+			return block;
 	}
+}
 
-	for (size_t i = 0; i < children.size(); i++)
-		nodelist.push_back(&children[i]);
+void GaddagFactory::growRegister()
+{
+	vector<uint32_t> grown(max((size_t)1024, m_register.size() * 2), 0);
+	const size_t mask = grown.size() - 1;
 
-	for (size_t i = 0; i < children.size(); i++)
-		children[i].print(nodelist);
-}
+	for (uint32_t block = 1; block < m_blockStarts.size(); ++block)
+	{
+		const uint32_t start = m_blockStarts[block - 1];
+		size_t slot = hashBlock(&m_arcs[start], m_blockStarts[block] - start) & mask;
+		while (grown[slot] != 0)
+			slot = (slot + 1) & mask;
+		grown[slot] = block;
+	}
 
+	m_register.swap(grown);
+}
 
-void GaddagFactory::Node::pushWord(const Quackle::LetterString& word)
+bool GaddagFactory::writeIndex(const string &fname, int version)
 {
-	if (word.length() == 0)
+	if (version != 1 && version != 2)
+		return false;
+
+	// Blocks go out newest first, so every pointer is to a later
+	// node, as GaddagNode wants. Node 0 is the root.
+	const uint32_t blockCount = (uint32_t)m_blockStarts.size() - 1;
+	vector<uint32_t> location(blockCount + 1, 0);
+	uint32_t next = 1;
+	for (uint32_t block = blockCount; block >= 1; --block)
 	{
-		t = true;
-		return;
+		location[block] = next;
+		next += m_blockStarts[block] - m_blockStarts[block - 1];
 	}
 
-	Quackle::Letter first = Quackle::String::front(word);
-	Quackle::LetterString rest = Quackle::String::allButFront(word);
-	int index = -1;
+	// offset indexing; 0 means no children
+	auto pointer = [&](const Arc &arc, uint32_t index) -> uint32_t {
+		return arc.block == 0? 0 : location[arc.block] - index;
+	};
 
-	for (size_t i = 0; i < children.size(); i++)
+	const Arc root = { QUACKLE_NULL_MARK, false, m_rootBlock };
+	if (version == 1)
 	{
-		if (children[i].c == first)
-		{
-			index = (int)i;
-			i = children.size();
-		}
+		if (pointer(root, 0) > 0xFFFFFF)
+			return false;
+		for (uint32_t block = blockCount; block >= 1; --block)
+			for (uint32_t i = m_blockStarts[block - 1]; i < m_blockStarts[block]; ++i)
+				if (pointer(m_arcs[i], location[block] + i - m_blockStarts[block - 1]) > 0xFFFFFF)
+					return false;
 	}
 
-	if (index == -1)
+	ofstream out(fname.c_str(), ios::out | ios::binary);
+	if (!out)
+		return false;
+
+	out.put(version);
+	out.write(m_hash.charptr, sizeof(m_hash.charptr));
+
+	if (version == 2)
 	{
-		Node n;
-		n.c = first;
-		n.t = false;
-		n.pointer = 0;
-		n.lastchild = false;
-		children.push_back(n);
-		index = (int)children.size() - 1;
+		// node count, then the alphabet as the dawg has it
+		const uint32_t nodes = nodeCount();
+		unsigned char bytes[4] = { (unsigned char)(nodes >> 24), (unsigned char)(nodes >> 16), (unsigned char)(nodes >> 8), (unsigned char)nodes };
+		out.write((char*)bytes, 4);
+		if (m_alphas)
+		{
+			out.put((char)m_alphas->length());
+			for (Quackle::Letter i = m_alphas->firstLetter(); i <= m_alphas->lastLetter(); i++)
+				out << QuackleIO::Util::uvStringToQString(m_alphas->letterParameter(i).text()).toUtf8().constData() << ' ';
+		}
+		else
+			out.put(0);
 	}
 
-	children[index].pushWord(rest);
+	uint32_t index = 0;
+	auto writeNode = [&](const Arc &arc, bool lastchild) {
+		const uint32_t p = pointer(arc, index++);
+
+		unsigned char n4;
+
+		n4 = arc.c;
+		if (n4 == internalSeparatorRepresentation)
+			n4 = QUACKLE_NULL_MARK;
+
+		if (arc.t)
+			n4 |= 64;
+
+		if (lastchild)
+			n4 |= 128;
+
+		if (version == 1)
+		{
+			char bytes[4] = { (char)(p >> 16), (char)(p >> 8), (char)p, (char)n4 };
+			out.write(bytes, 4);
+		}
+		else
+		{
+			char bytes[8] = { (char)(p >> 24), (char)(p >> 16), (char)(p >> 8), (char)p, (char)n4, 0, 0, 0 };
+			out.write(bytes, 8);
+		}
+	};
+
+	writeNode(root, true);
+	for (uint32_t block = blockCount; block >= 1; --block)
+		for (uint32_t i = m_blockStarts[block - 1]; i < m_blockStarts[block]; ++i)
+			writeNode(m_arcs[i], i == m_blockStarts[block] - 1);
+
+	return out.good();
 }
@@ -22,11 +22,12 @@
 #include <cstdint>
 #include "flexiblealphabet.h"
 
-// This isn't a strict maximum...you can go higher...but too much higher, and you risk overflowing
-// node pointers, which will get you garbage words.  The OSPS dictionary is known to trigger
-// such overflows.
-const int QUACKLE_MAX_GADDAG_WORDCOUNT = 500000;
-
+// Builds a minimized GADDAG. Words are kept as pushed; generate()
+// indexes them by the letters they hold, gaddagizes them one first
+// letter at a time, on a few threads, and folds each sorted batch
+// into the graph, sharing equivalent subtrees as it goes. So memory
+// is the word list and its index, the minimized graph, and at most
+// four batches at once, rather than every gaddagized word.
 class GaddagFactory {
 public:
 
@@ -35,39 +36,68 @@ public:
 	GaddagFactory(const UVString &alphabetFile);
 	~GaddagFactory();
 
-	int wordCount() const { return (int)m_gaddagizedWords.size(); };
-	int nodeCount() const { return (int)m_nodelist.size(); };
+	int wordCount() const { return (int)m_words.size(); };
+	int nodeCount() const { return 1 + (int)m_arcs.size(); };
 	int encodableWords() const { return m_encodableWords; };
 	int unencodableWords() const { return m_unencodableWords; };
 
 	bool pushWord(const UVString &word);
 	bool pushWord(const Quackle::LetterString &word);
 	void hashWord(const Quackle::LetterString &word);
-	void sortWords() { sort(m_gaddagizedWords.begin(), m_gaddagizedWords.end()); };
 	void generate();
-	void writeIndex(const string &fname);
+
+	// Writes format version 1, with 24-bit pointers, or version 2,
+	// with 32-bit ones. false if the file couldn't be written or the
+	// graph is too big for the version's pointers.
+	bool writeIndex(const string &fname, int version = 1);
 
 	const char* hashBytes() { return m_hash.charptr; };
 
 
 private:
-	class Node {
-		public:
-			Quackle::Letter c;
-			bool t;
-			vector<Node> children;
-			int pointer;
-			bool lastchild;
-			void pushWord(const Quackle::LetterString& word);
-			void print(vector< Node* >& m_nodelist);
+	// A node of the file: a letter, whether a word ends there, and
+	// the block of its children. Blocks are numbered from 1 in the
+	// order they're made, so children come before parents; 0 means
+	// no children.
+	struct Arc {
+		Quackle::Letter c;
+		bool t;
+		uint32_t block;
+
+		bool operator==(const Arc &other) const { return c == other.c && t == other.t && block == other.block; };
 	};
 
+	// every gaddagized word starting with letter, from the words of
+	// wordIndexes, sorted
+	Quackle::WordList gaddagize(Quackle::Letter letter, const vector<uint32_t> &wordIndexes) const;
+
+	// folds a sorted batch of gaddagized words sharing a first
+	// letter into the graph, returning the root's arc for them
+	Arc addBatch(const Quackle::WordList &words);
+
+	// the arcs at each depth along the last word added that might
+	// still get siblings
+	vector< vector<Arc> > m_open;
+	void closeDeeperThan(size_t depth);
+
+	// returns the number of an identical block if there is one, or
+	// stores arcs as a new block
+	uint32_t registerBlock(const vector<Arc> &arcs);
+	size_t hashBlock(const Arc *arcs, size_t count) const;
+	void growRegister();
+
 	int m_encodableWords;
 	int m_unencodableWords;
-	Quackle::WordList m_gaddagizedWords;
-	vector< Node* > m_nodelist;
+	Quackle::WordList m_words;
 	Quackle::AlphabetParameters *m_alphas;
-	Node m_root;
+
+	// block n is m_arcs[m_blockStarts[n - 1]] up to m_blockStarts[n]
+	vector<Arc> m_arcs;
+	vector<uint32_t> m_blockStarts;
+	vector<uint32_t> m_register;
+	size_t m_registered;
+	uint32_t m_rootBlock;
+
 	union {
 		char charptr[16];
 		std::int32_t int32ptr[4];
@@ -75,4 +105,3 @@ private:
 };
 
 #endif
-
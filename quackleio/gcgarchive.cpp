@@ -0,0 +1,82 @@
+/*
+ *  Quackle -- Crossword game artificial intelligence and analysis tool
+ *  Copyright (C) 2005-2019 Jason Katz-Brown, John O'Laughlin, and John Fultz.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <memory>
+
+#include <QtCore>
+
+#include "gcgarchive.h"
+#include "gcgbulkreader.h"
+#include "gcgio.h"
+#include "util.h"
+
+using namespace QuackleIO;
+
+int GCGArchive::archiveGCGs(const QStringList &filenames, const QString &archiveFilename)
+{
+	Quackle::GameArchiveWriter writer;
+	GCGBulkReader reader;
+	reader.read(filenames, GCGBulkReader::BuildGames, [&](GCGRecord &record) {
+		if (!record.error.empty() || !record.game)
+		{
+			UVcerr << "Could not read " << Util::qstringToString(record.filename) << ": " << record.error << endl;
+			return;
+		}
+
+		const QString id = QFileInfo(record.filename).completeBaseName();
+		if (!writer.addGame(Util::qstringToStdString(id), *record.game))
+			UVcerr << "Not archiving " << Util::qstringToString(record.filename) << ": a game named " << Util::qstringToString(id) << " is already archived" << endl;
+	});
+
+	if (!writer.save(Util::qstringToStdString(archiveFilename)))
+	{
+		UVcerr << "Could not write " << Util::qstringToString(archiveFilename) << endl;
+		return -1;
+	}
+
+	return writer.gameCount();
+}
+
+bool GCGArchive::writeGCG(const Quackle::GameArchive &archive, int index, const QString &filename)
+{
+	QFile file(filename);
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+	{
+		UVcerr << "Could not open gcg " << Util::qstringToString(filename) << endl;
+		return false;
+	}
+
+	unique_ptr<Quackle::Game> game(archive.game(index));
+	QTextStream stream(&file);
+	GCGIO io;
+	io.write(*game, stream);
+	return true;
+}
+
+int GCGArchive::extractGCGs(const Quackle::GameArchive &archive, const QString &directory)
+{
+	QDir dir(directory);
+	int written = 0;
+	for (int i = 0; i < archive.gameCount(); ++i)
+	{
+		const QString filename = dir.filePath(Util::stdStringToQString(archive.gameId(i)) + ".gcg");
+		if (writeGCG(archive, i, filename))
+			++written;
+	}
+
+	return written;
+}
@@ -0,0 +1,50 @@
+/*
+ *  Quackle -- Crossword game artificial intelligence and analysis tool
+ *  Copyright (C) 2005-2019 Jason Katz-Brown, John O'Laughlin, and John Fultz.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef QUACKLE_GCGARCHIVE_H
+#define QUACKLE_GCGARCHIVE_H
+
+#include <QStringList>
+
+#include "gamearchive.h"
+
+namespace QuackleIO
+{
+
+// Converts between gcgs and game archives, with GCGIO reading and
+// writing the gcgs.
+class GCGArchive
+{
+public:
+	// Has GCGIO read each file, on a thread per core, and saves the
+	// games to archiveFilename, each under its file's base name. A
+	// file that can't be read or whose name is taken is reported
+	// and left out. Returns the number of games archived, or -1 if
+	// the archive can't be written.
+	static int archiveGCGs(const QStringList &filenames, const QString &archiveFilename);
+
+	// writes one game of archive as a gcg
+	static bool writeGCG(const Quackle::GameArchive &archive, int index, const QString &filename);
+
+	// Writes every game of archive to directory as <id>.gcg. Returns
+	// the number written.
+	static int extractGCGs(const Quackle::GameArchive &archive, const QString &directory);
+};
+
+}
+
+#endif
@@ -0,0 +1,438 @@
+/*
+ *  Quackle -- Crossword game artificial intelligence and analysis tool
+ *  Copyright (C) 2005-2019 Jason Katz-Brown, John O'Laughlin, and John Fultz.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+#include <QtCore>
+
+#include <datamanager.h>
+
+#include "gcgbulkreader.h"
+#include "gcgio.h"
+
+using namespace QuackleIO;
+
+namespace
+{
+
+// a run of bytes of the file being parsed
+struct Token
+{
+	const char *start;
+	const char *end;
+
+	size_t length() const { return end - start; }
+	bool startsWith(const char *prefix) const
+	{
+		const size_t prefixLength = strlen(prefix);
+		return length() >= prefixLength && memcmp(start, prefix, prefixLength) == 0;
+	}
+	bool endsWith(char c) const { return end > start && end[-1] == c; }
+};
+
+bool isSpace(char c)
+{
+	return c == ' ' || c == '\t' || c == '\v' || c == '\f';
+}
+
+bool isDigit(char c)
+{
+	return c >= '0' && c <= '9';
+}
+
+void splitTokens(const char *start, const char *end, vector<Token> &tokens)
+{
+	tokens.clear();
+	while (start < end)
+	{
+		while (start < end && isSpace(*start))
+			++start;
+		const char *tokenEnd = start;
+		while (tokenEnd < end && !isSpace(*tokenEnd))
+			++tokenEnd;
+		if (tokenEnd > start)
+			tokens.push_back(Token{start, tokenEnd});
+		start = tokenEnd;
+	}
+}
+
+// like QString::toInt after GCGIO::readSignedInt strips a sign:
+// anything but digits reads as 0
+int readSignedInt(const Token &token)
+{
+	const char *at = token.start;
+	int sign = 1;
+	if (at < token.end && (*at == '+' || *at == '-'))
+		sign = *at++ == '-' ? -1 : 1;
+
+	if (at == token.end)
+		return 0;
+
+	int ret = 0;
+	for (; at < token.end; ++at)
+	{
+		if (!isDigit(*at))
+			return 0;
+		ret = ret * 10 + (*at - '0');
+	}
+
+	return sign * ret;
+}
+
+class Parser
+{
+public:
+	Parser(GCGRecord &record) : m_record(record), m_utf8(false) {}
+
+	// false with m_error set if the line is malformed
+	bool parseLine(const char *start, const char *end);
+
+	UVString m_error;
+
+private:
+	bool parsePlayer();
+	bool parseMove();
+	UVString text(const char *start, const char *end) const;
+	UVString text(const Token &token) const { return text(token.start, token.end); }
+	Quackle::LetterString letters(const Token &token) const;
+	int cumulativeScore(size_t index) const { return index < m_tokens.size() ? readSignedInt(m_tokens[index]) : 0; }
+	bool fail(const UVString &error) { m_error = error; return false; }
+
+	GCGRecord &m_record;
+	vector<Token> m_tokens;
+	bool m_utf8;
+};
+
+// gcgs are latin-1 unless they say they're utf-8
+UVString Parser::text(const char *start, const char *end) const
+{
+	UVString ret;
+	for (const char *at = start; at < end; ++at)
+	{
+		unsigned int codePoint = (unsigned char)*at;
+		if (m_utf8 && codePoint >= 0x80)
+		{
+#if QUACKLE_USE_WCHAR_FOR_USER_VISIBLE
+			const int continuation = codePoint >= 0xF0 ? 3 : codePoint >= 0xE0 ? 2 : 1;
+			codePoint &= 0x3F >> continuation;
+			for (int i = 0; i < continuation && at + 1 < end; ++i)
+				codePoint = (codePoint << 6) | ((unsigned char)*++at & 0x3F);
+#else
+			ret += *at;
+			continue;
+#endif
+		}
+
+#if QUACKLE_USE_WCHAR_FOR_USER_VISIBLE
+		ret += (UVChar)codePoint;
+#else
+		if (codePoint < 0x80)
+			ret += (char)codePoint;
+		else
+		{
+			ret += (char)(0xC0 | (codePoint >> 6));
+			ret += (char)(0x80 | (codePoint & 0x3F));
+		}
+#endif
+	}
+
+	return ret;
+}
+
+// the token's bytes are encoded where they are if they're already
+// what text() would make of them
+Quackle::LetterString Parser::letters(const Token &token) const
+{
+#if !QUACKLE_USE_WCHAR_FOR_USER_VISIBLE
+	if (m_utf8 || all_of(token.start, token.end, [](char c) { return (unsigned char)c < 0x80; }))
+		return QUACKLE_ALPHABET_PARAMETERS->encode(token.start, token.length());
+#endif
+
+	return QUACKLE_ALPHABET_PARAMETERS->encode(text(token));
+}
+
+bool Parser::parseLine(const char *start, const char *end)
+{
+	splitTokens(start, end, m_tokens);
+	if (m_tokens.empty())
+		return true;
+
+	const Token &first = m_tokens.front();
+	if (first.startsWith("#player"))
+		return parsePlayer();
+	else if (first.startsWith("#title"))
+		m_record.title = text(min(start + 7, end), end);
+	else if (first.startsWith("#description"))
+		m_record.description = text(min(start + 13, end), end);
+	else if (first.startsWith("#note") && !m_record.turns.empty())
+		m_record.turns.back().note = text(min(start + 6, end), end);
+	else if (first.startsWith("#character-encoding"))
+	{
+		const UVString encoding = m_tokens.size() > 1 ? text(m_tokens[1]) : UVString();
+		UVString upper;
+		for (const auto &c : encoding)
+			upper += (c >= 'a' && c <= 'z') ? c - 'a' + 'A' : c;
+
+		if (upper == MARK_UV("UTF-8") || upper == MARK_UV("UTF8"))
+			m_utf8 = true;
+		else if (upper == MARK_UV("ISO-8859-1") || upper == MARK_UV("LATIN1") || upper == MARK_UV("LATIN-1"))
+			m_utf8 = false;
+		else
+			return fail(MARK_UV("unsupported character encoding ") + encoding);
+	}
+	else if (first.startsWith(">"))
+		return parseMove();
+
+	return true;
+}
+
+bool Parser::parsePlayer()
+{
+	GCGPlayer player;
+	const Token &first = m_tokens.front();
+	player.id = isDigit(first.end[-1]) ? first.end[-1] - '0' : 0;
+
+	if (m_tokens.size() < 2)
+		return fail(MARK_UV("no player abbreviation in #player"));
+	player.abbreviation = text(m_tokens[1]);
+
+	if (m_tokens.size() < 3)
+		return fail(MARK_UV("no player name in #player"));
+	for (size_t i = 2; i < m_tokens.size(); ++i)
+	{
+		if (i > 2)
+			player.name += MARK_UV(" ");
+		player.name += text(m_tokens[i]);
+	}
+
+	m_record.players.push_back(player);
+	return true;
+}
+
+bool Parser::parseMove()
+{
+	GCGTurn turn;
+	turn.player = -1;
+	turn.cumulativeScore = 0;
+
+	Token abbreviation = m_tokens.front();
+	++abbreviation.start;
+	if (abbreviation.endsWith(':'))
+		--abbreviation.end;
+	const UVString abbreviationText = text(abbreviation);
+	for (size_t i = 0; i < m_record.players.size(); ++i)
+		if (m_record.players[i].abbreviation == abbreviationText)
+			turn.player = i;
+
+	if (m_tokens.size() < 3)
+		return fail(MARK_UV("incomplete move"));
+
+	const Token &rack = m_tokens[1];
+	const Token &bite = m_tokens[2];
+
+	// end of game unused tiles bonus
+	if (rack.startsWith("(") && rack.endsWith(')'))
+	{
+		turn.move = Quackle::Move::createUnusedTilesBonus(letters(Token{rack.start + 1, rack.end - 1}), readSignedInt(bite));
+		turn.cumulativeScore = cumulativeScore(3);
+		m_record.turns.push_back(turn);
+		return true;
+	}
+
+	turn.rack = letters(rack);
+
+	// these amend the last turn rather than being turns of their own
+	if (bite.startsWith("--") || bite.startsWith("(challenge)"))
+	{
+		if (m_record.turns.empty())
+			return true;
+
+		GCGTurn &last = m_record.turns.back();
+		if (bite.startsWith("--"))
+			last.move.setIsChallengedPhoney(true);
+		else
+		{
+			if (m_tokens.size() < 4)
+				return fail(MARK_UV("incomplete move"));
+			last.move.setScoreAddition(readSignedInt(m_tokens[3]));
+		}
+
+		if (last.player == turn.player)
+			last.cumulativeScore = cumulativeScore(4);
+		return true;
+	}
+
+	if (bite.startsWith("-"))
+	{
+		const Token exchanged = Token{bite.start + 1, bite.end};
+		const bool isLetterCount = exchanged.length() > 0 && all_of(exchanged.start, exchanged.end, isDigit);
+		const int letterCount = isLetterCount ? readSignedInt(exchanged) : 0;
+
+		if (exchanged.length() == 0 || (isLetterCount && letterCount == 0))
+			turn.move = Quackle::Move::createPassMove();
+		else if (isLetterCount)
+		{
+			Quackle::LetterString encodedLetters;
+			for (int i = 0; i < letterCount && i < LETTER_STRING_MAXIMUM_LENGTH; ++i)
+				encodedLetters.push_back(QUACKLE_BLANK_MARK);
+			turn.move = Quackle::Move::createExchangeMove(encodedLetters, true);
+		}
+		else
+			turn.move = Quackle::Move::createExchangeMove(letters(exchanged), false);
+
+		turn.cumulativeScore = cumulativeScore(4);
+	}
+	else if (bite.startsWith("(time)"))
+	{
+		if (m_tokens.size() < 4)
+			return fail(MARK_UV("incomplete move"));
+
+		turn.move = Quackle::Move::createTimePenalty(-readSignedInt(m_tokens[3]));
+		turn.cumulativeScore = cumulativeScore(4);
+	}
+	else if (bite.startsWith("(") && bite.endsWith(')'))
+	{
+		// the tiles left on the rack of a player whose opponent went out
+		if (m_tokens.size() < 4)
+			return fail(MARK_UV("incomplete move"));
+
+		turn.move = Quackle::Move::createUnusedTilesBonus(letters(Token{bite.start + 1, bite.end - 1}), readSignedInt(m_tokens[3]));
+		turn.cumulativeScore = cumulativeScore(4);
+	}
+	else
+	{
+		if (m_tokens.size() < 4)
+			return fail(MARK_UV("incomplete move"));
+
+		turn.move = Quackle::Move::createPlaceMove(text(bite), letters(m_tokens[3]));
+		turn.move.score = m_tokens.size() > 4 ? readSignedInt(m_tokens[4]) : -1;
+		turn.cumulativeScore = cumulativeScore(5);
+	}
+
+	m_record.turns.push_back(turn);
+	return true;
+}
+
+}
+
+GCGBulkReader::GCGBulkReader()
+	: m_threadCount(max(1u, thread::hardware_concurrency()))
+{
+}
+
+void GCGBulkReader::setThreadCount(int threadCount)
+{
+	m_threadCount = max(1, threadCount);
+}
+
+bool GCGBulkReader::parse(const char *data, size_t length, GCGRecord &record)
+{
+	Parser parser(record);
+	const char *end = data + length;
+	int lineNumber = 0;
+	for (const char *line = data; line < end; )
+	{
+		const char *lineEnd = find(line, end, '\n');
+		const char *next = lineEnd < end ? lineEnd + 1 : end;
+		if (lineEnd > line && lineEnd[-1] == '\r')
+			--lineEnd;
+		++lineNumber;
+
+		if (!parser.parseLine(line, lineEnd))
+		{
+			UVStringStream error;
+			error << "line " << lineNumber << ": " << parser.m_error;
+			record.error = error.str();
+			return false;
+		}
+
+		line = next;
+	}
+
+	return true;
+}
+
+void GCGBulkReader::readFile(const QString &filename, int flags, GCGRecord &record) const
+{
+	QFile file(filename);
+	if (!file.open(QIODevice::ReadOnly))
+	{
+		record.error = MARK_UV("could not open file");
+		return;
+	}
+
+	// map where possible, as it saves copying the file
+	QByteArray contents;
+	size_t length = file.size();
+	const char *data = length > 0 ? reinterpret_cast<const char *>(file.map(0, length)) : 0;
+	if (!data)
+	{
+		contents = file.readAll();
+		data = contents.constData();
+		length = contents.size();
+	}
+
+	if (!parse(data, length, record))
+		return;
+
+	if (flags & BuildGames)
+	{
+		GCGIO io;
+		const QByteArray bytes(QByteArray::fromRawData(data, length));
+		QTextStream stream(bytes);
+		record.game.reset(io.read(stream, flags & Logania::MaintainBoardPreparation));
+	}
+}
+
+int GCGBulkReader::read(const QStringList &filenames, int flags, const Handler &handler)
+{
+	atomic<int> nextFile(0);
+	int readCount = 0;
+	mutex handlerMutex;
+
+	Quackle::DataManager *dataManager = QUACKLE_DATAMANAGER;
+	auto worker = [&]() {
+		Quackle::DataManagerScope scope(dataManager);
+		for (int i = nextFile++; i < filenames.size(); i = nextFile++)
+		{
+			GCGRecord record;
+			record.filename = filenames[i];
+			record.index = i;
+			readFile(filenames[i], flags, record);
+
+			lock_guard<mutex> lock(handlerMutex);
+			if (record.error.empty())
+				++readCount;
+			handler(record);
+		}
+	};
+
+	const int threadCount = min(m_threadCount, max(1, filenames.size()));
+	vector<thread> threads;
+	for (int i = 1; i < threadCount; ++i)
+		threads.emplace_back(worker);
+	worker();
+	for (auto &it : threads)
+		it.join();
+
+	return readCount;
+}
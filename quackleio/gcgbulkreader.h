@@ -0,0 +1,126 @@
+/*
+ *  Quackle -- Crossword game artificial intelligence and analysis tool
+ *  Copyright (C) 2005-2019 Jason Katz-Brown, John O'Laughlin, and John Fultz.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QUACKLE_GCGBULKREADER_H
+#define QUACKLE_GCGBULKREADER_H
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include <QStringList>
+
+#include "game.h"
+#include "logania.h"
+
+namespace QuackleIO
+{
+
+struct GCGPlayer
+{
+	int id;
+	UVString abbreviation;
+	UVString name;
+};
+
+// A move line of a gcg as written; nothing is checked against a board.
+struct GCGTurn
+{
+	// index into GCGRecord::players, or -1 if the abbreviation is unknown
+	int player;
+
+	Quackle::LetterString rack;
+
+	// A Place, Exchange, BlindExchange, Pass, UnusedTilesBonus or
+	// TimePenalty, scored as the gcg claims. A phoney taken off or a
+	// challenge bonus doesn't get a turn of its own but marks the
+	// last turn, as GCGIO does.
+	Quackle::Move move;
+
+	// the player's total after the turn
+	int cumulativeScore;
+
+	UVString note;
+};
+
+struct GCGRecord
+{
+	GCGRecord() : index(-1) {}
+
+	QString filename;
+
+	// position of filename in the list read
+	int index;
+
+	// why the file couldn't be read in full, or empty
+	UVString error;
+
+	UVString title;
+	UVString description;
+	vector<GCGPlayer> players;
+	vector<GCGTurn> turns;
+
+	// with BuildGames, the game as GCGIO reads it
+	unique_ptr<Quackle::Game> game;
+};
+
+// Reads many gcgs at once: files are memory-mapped and parsed on a
+// pool of threads without Qt strings. By default only a GCGRecord
+// summary of each game is made, which is much faster than having
+// GCGIO replay every move on a board.
+class GCGBulkReader
+{
+public:
+	// BuildGames also has GCGIO read each file into a Game; it can be
+	// or'd with Logania::MaintainBoardPreparation
+	enum BulkFlags { SummaryOnly = 0x0000, BuildGames = 0x0100 };
+
+	// handed each record as it's read
+	typedef function<void(GCGRecord &record)> Handler;
+
+	GCGBulkReader();
+
+	// defaults to the number of cores
+	void setThreadCount(int threadCount);
+	int threadCount() const;
+
+	// Reads every file, calling handler once per file in no
+	// particular order; calls are never concurrent. A file that
+	// can't be read is reported in its record's error and doesn't
+	// stop the rest. Returns the number of files read without error.
+	int read(const QStringList &filenames, int flags, const Handler &handler);
+
+	// Fills record's summary from the text of a gcg. Returns false
+	// and sets record.error on a malformed line, leaving what came
+	// before it in record.
+	static bool parse(const char *data, size_t length, GCGRecord &record);
+
+private:
+	void readFile(const QString &filename, int flags, GCGRecord &record) const;
+
+	int m_threadCount;
+};
+
+inline int GCGBulkReader::threadCount() const
+{
+	return m_threadCount;
+}
+
+}
+
+#endif
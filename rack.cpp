@@ -41,39 +41,27 @@ bool Rack::unload(const LetterString &used)
 {
 	// UVcout << *this << ".unload(" << used << ")" << endl;
 
-	LetterString newtiles = m_tiles;
-	bool ret = true;
-
-	LetterString::const_iterator usedEnd(used.end());
-	for (LetterString::const_iterator usedIt = used.begin(); usedIt != usedEnd; ++usedIt)
+	// how many of each letter are still to be taken off
+	unsigned char counts[256] = {0};
+	for (const auto &it : used)
+		++counts[static_cast<unsigned char>(it)];
+
+	unsigned int found = 0;
+	LetterString newtiles;
+	for (const auto &it : m_tiles)
 	{
-		bool found = false;
-
-		LetterString::iterator newEnd(newtiles.end());
-		for (LetterString::iterator newIt = newtiles.begin(); newIt != newEnd; ++newIt)
+		unsigned char &count = counts[static_cast<unsigned char>(it)];
+		if (count > 0)
 		{
-			if (*newIt == *usedIt)
-			{
-				*newIt = QUACKLE_NULL_MARK;
-				found = true;
-				break;
-			}
+			--count;
+			++found;
 		}
-
-		if (!found)
-			ret = false;
+		else
+			newtiles += it;
 	}
 
-	// UVcout << "newtiles: " << newtiles << endl;
-
-	m_tiles.clear();
-
-	LetterString::const_iterator newEnd(newtiles.end());
-	for (LetterString::const_iterator newIt = newtiles.begin(); newIt != newEnd; ++newIt)
-		if (*newIt != QUACKLE_NULL_MARK)
-			m_tiles += *newIt; 
-
-	return ret;
+	m_tiles = newtiles;
+	return found == used.length();
 }
 
 void Rack::load(const LetterString &tiles)
@@ -92,7 +80,8 @@ bool Rack::contains(const LetterString &used) const
 
 void Rack::shuffle()
 {
-	random_shuffle(m_tiles.begin(), m_tiles.end());
+	for (int i = (int)m_tiles.length() - 1; i > 0; --i)
+		iter_swap(m_tiles.begin() + i, m_tiles.begin() + DataManager::self()->randomInteger(0, i));
 }
 
 int Rack::score() const
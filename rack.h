@@ -67,6 +67,9 @@ public:
 	// sum of scores of letters on rack
 	int score() const;
 
+	// the plain letters on the rack, without blanks
+	LetterMask letterMask() const;
+
 	UVString xml() const;
 	UVString toString() const;
 
@@ -98,6 +101,11 @@ inline bool Rack::empty() const
 	return m_tiles.empty();
 }
 
+inline LetterMask Rack::letterMask() const
+{
+	return LetterMasks::fromLetters(m_tiles);
+}
+
 }
 
 const Quackle::Rack operator-(const Quackle::Rack &rack, const Quackle::Move &move);
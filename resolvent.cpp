@@ -67,6 +67,8 @@ MoveList Resolvent::moves(int nmoves)
     delegatee->setParameters(parameters());
     delegatee->setDispatch(currentPosition().nestedness() > 0? 0 : m_dispatch);
     delegatee->setPosition(m_simulator.currentPosition());
+    if (hasPreviousPosition())
+        delegatee->setPreviousPosition(previousPosition());
     delegatee->setConsideredMoves(m_simulator.consideredMoves());
     MoveList moves = delegatee->moves(nmoves);
     delete delegatee;
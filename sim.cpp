@@ -16,9 +16,13 @@
  *  along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
 #include <iostream>
+#include <limits>
 #include <math.h>
 
+#include "analysiscache.h"
+#include "binaryio.h"
 #include "computerplayer.h"
 #include "datamanager.h"
 #include "game.h"
@@ -35,7 +39,7 @@ using namespace Quackle;
 std::atomic_long SimmedMove::objectIdCounter{0};
 
 Simulator::Simulator()
-	: m_logfileIsOpen(false), m_hasHeader(false), m_dispatch(0), m_iterations(0), m_ignoreOppos(false)
+	: m_logfileIsOpen(false), m_hasHeader(false), m_dispatch(0), m_iterations(0), m_ignoreOppos(false), m_cachePlies(0), m_checkedAnalysisCache(false), m_storedIterations(0)
 {
 	m_originalGame.addPosition();
 	setThreadCount(2);
@@ -50,10 +54,19 @@ Simulator::~Simulator()
 void Simulator::setPosition(const GamePosition &position)
 {
 	if (hasSimulationResults())
+	{
 		writeLogFooter();
+		storeInAnalysisCache();
+	}
+
+	m_checkedAnalysisCache = false;
+	m_storedIterations = 0;
 
 	m_originalGame.setCurrentPosition(position);
 
+	m_inferredOppoLeaves.clear();
+	m_inferredOppoLeaveCumulative.clear();
+
 	m_consideredMoves.clear();
 	m_simmedMoves.clear();
 	for (const auto &it : m_originalGame.currentPosition().moves())
@@ -260,6 +273,8 @@ void Simulator::simulate(int plies, int iterations)
 			break;
 		simulate(plies);
 	}
+
+	storeInAnalysisCache();
 }
 
 void Simulator::simulate(int plies)
@@ -268,6 +283,9 @@ void Simulator::simulate(int plies)
 	UVcout << "let's simulate for " << plies << " plies" << endl;
 #endif
 
+	if (!m_checkedAnalysisCache)
+		resumeFromAnalysisCache(plies);
+
 	++m_iterations;
 
 	randomizeOppoRacks();
@@ -289,6 +307,13 @@ void Simulator::simulate(int plies)
 	constants.levelCount = (int)((plies - constants.decimalTurns) / constants.playerCount);
 	constants.ignoreOppos = m_ignoreOppos;
 	constants.isLogging = isLogging();
+	constants.dataManager = QUACKLE_DATAMANAGER;
+	constants.seed = QUACKLE_DATAMANAGER->randomInteger(0, numeric_limits<int>::max());
+
+	// no rollouts are running between iterations, so it's safe to
+	// take the new snapshot in place
+	m_context.snapshot();
+	constants.context = &m_context;
 
 	m_sendQueue.setConstants(constants);
 
@@ -316,6 +341,7 @@ void Simulator::simulate(int plies)
 
 		SimmedMoveMessage message;
 		message.id = moveIt.id();
+		message.index = messageCount;
 		message.move = moveIt.move;
 		message.levels.setNumberLevels(constants.levelCount + 1);
 		message.levels = moveIt.levels;
@@ -340,6 +366,12 @@ void Simulator::simulate(int plies)
 
 void Simulator::simulateOnePosition(SimmedMoveMessage &message, const SimmedMoveConstants &constants)
 {
+	DataManagerScope scope(constants.dataManager);
+
+	// so a rollout's draws don't depend on which thread it runs on
+	seed_seq seed = {constants.seed, message.index};
+	RandomNumberScope random(seed);
+
 	Game game = constants.game;
 	double residual = 0;
 
@@ -373,7 +405,7 @@ void Simulator::simulateOnePosition(SimmedMoveMessage &message, const SimmedMove
 			else if (constants.ignoreOppos && playerId != constants.startPlayerId)
 				move = Move::createPassMove();
 			else
-				move = game.currentPosition().staticBestMove();
+				move = game.currentPosition().staticBestMove(*constants.context);
 
 			int deadwoodScore = 0;
 			if (game.currentPosition().doesMoveEndGame(move))
@@ -508,8 +540,10 @@ void Simulator::randomizeOppoRacks()
 		if ((it == m_originalGame.currentPosition().currentPlayer()))
 			continue;
 
-		// TODO -- some kind of inference engine can be inserted here
+		// tiles we know about trump tiles we inferred
 		Rack rack = m_partialOppoRack;
+		if (rack.empty() && !m_inferredOppoLeaves.empty())
+			rack = randomInferredOppoLeave();
 
 		// We must refill the partial rack from a bag that does not 
 		// contain the partial rack.
@@ -526,11 +560,197 @@ void Simulator::randomizeOppoRacks()
 	m_originalGame.currentPosition().ensureProperBag();
 }
 
+namespace
+{
+
+const uint32_t simulationStateMagic = 0x4d495351; // "QSIM"
+const uint8_t simulationStateVersion = 1;
+
+void writeAveragedValue(BinaryWriter &writer, const AveragedValue &value)
+{
+	writer.writeDouble(value.valueSum());
+	writer.writeDouble(value.squaredValueSum());
+	writer.writeU64(value.incorporatedValues());
+}
+
+AveragedValue readAveragedValue(BinaryReader &reader)
+{
+	const double valueSum = reader.readDouble();
+	const double squaredValueSum = reader.readDouble();
+	return AveragedValue(valueSum, squaredValueSum, (long int)reader.readU64());
+}
+
+}
+
+string Simulator::serializeState() const
+{
+	BinaryWriter writer;
+	writer.writeU32(simulationStateMagic);
+	writer.writeU8(simulationStateVersion);
+	writer.writeU64(AnalysisCache::positionHash(currentPosition()));
+	writer.writeI32(m_iterations);
+
+	writer.writeU32(m_simmedMoves.size());
+	for (const auto &moveIt : m_simmedMoves)
+	{
+		writer.writeMove(moveIt.move);
+		writer.writeU8(moveIt.includeInSimulation());
+
+		writer.writeU32(moveIt.levels.size());
+		for (const auto &levelIt : moveIt.levels)
+		{
+			writer.writeU32(levelIt.statistics.size());
+			for (const auto &statisticsIt : levelIt.statistics)
+			{
+				writeAveragedValue(writer, statisticsIt.score);
+				writeAveragedValue(writer, statisticsIt.bingos);
+			}
+		}
+
+		writeAveragedValue(writer, moveIt.residual);
+		writeAveragedValue(writer, moveIt.gameSpread);
+		writeAveragedValue(writer, moveIt.wins);
+	}
+
+	return writer.data();
+}
+
+bool Simulator::readState(const string &state, SimmedMoveList *moves, int *iterations) const
+{
+	BinaryReader reader(state);
+	if (reader.readU32() != simulationStateMagic || reader.readU8() != simulationStateVersion)
+		return false;
+
+	if (reader.readU64() != AnalysisCache::positionHash(currentPosition()))
+		return false;
+
+	*iterations = reader.readI32();
+
+	moves->clear();
+	const unsigned int moveCount = reader.readU32();
+	for (unsigned int i = 0; i < moveCount && reader.ok(); ++i)
+	{
+		SimmedMove simmedMove(reader.readMove());
+		simmedMove.setIncludeInSimulation(reader.readU8());
+
+		const unsigned int levelCount = reader.readU32();
+		for (unsigned int j = 0; j < levelCount && reader.ok(); ++j)
+		{
+			Level level;
+			const unsigned int statisticsCount = reader.readU32();
+			for (unsigned int k = 0; k < statisticsCount && reader.ok(); ++k)
+			{
+				PositionStatistics statistics;
+				statistics.score = readAveragedValue(reader);
+				statistics.bingos = readAveragedValue(reader);
+				level.statistics.push_back(statistics);
+			}
+			simmedMove.levels.push_back(level);
+		}
+
+		simmedMove.residual = readAveragedValue(reader);
+		simmedMove.gameSpread = readAveragedValue(reader);
+		simmedMove.wins = readAveragedValue(reader);
+		moves->push_back(simmedMove);
+	}
+
+	return reader.ok() && reader.atEnd();
+}
+
+bool Simulator::deserializeState(const string &state)
+{
+	SimmedMoveList moves;
+	int iterations;
+	if (!readState(state, &moves, &iterations))
+		return false;
+
+	m_simmedMoves = moves;
+	m_iterations = iterations;
+	return true;
+}
+
+bool Simulator::mergeState(const string &state, bool addMissingMoves)
+{
+	SimmedMoveList moves;
+	int iterations;
+	if (!readState(state, &moves, &iterations))
+		return false;
+
+	for (const auto &mergingIt : moves)
+	{
+		bool found = false;
+		for (auto &moveIt : m_simmedMoves)
+		{
+			if (moveIt.move == mergingIt.move)
+			{
+				moveIt.merge(mergingIt);
+				found = true;
+				break;
+			}
+		}
+
+		if (!found && addMissingMoves)
+			m_simmedMoves.push_back(mergingIt);
+	}
+
+	m_iterations += iterations;
+	return true;
+}
+
+void Simulator::resumeFromAnalysisCache(int plies)
+{
+	m_checkedAnalysisCache = true;
+	m_cachePlies = plies;
+
+	AnalysisCache *cache = QUACKLE_ANALYSIS_CACHE;
+	if (!cache || currentPosition().nestedness() > 0)
+		return;
+
+	// our moves have no statistics yet, so merging is restoring
+	string state;
+	if (!cache->findSimulation(currentPosition(), plies, m_partialOppoRack, m_inferredOppoLeaves, &state) || !mergeState(state, false))
+		return;
+
+	m_storedIterations = m_iterations;
+}
+
+void Simulator::storeInAnalysisCache()
+{
+	AnalysisCache *cache = QUACKLE_ANALYSIS_CACHE;
+	if (!cache || !m_checkedAnalysisCache || m_iterations <= m_storedIterations || currentPosition().nestedness() > 0)
+		return;
+
+	cache->storeSimulation(currentPosition(), m_cachePlies, m_partialOppoRack, m_inferredOppoLeaves, serializeState());
+	m_storedIterations = m_iterations;
+}
+
 void Simulator::setPartialOppoRack(const Rack &rack)
 {
 	m_partialOppoRack = rack;
 }
 
+void Simulator::setInferredOppoLeaves(const ProbableRackList &leaves)
+{
+	m_inferredOppoLeaves = leaves;
+
+	m_inferredOppoLeaveCumulative.clear();
+	double sum = 0;
+	for (const auto &it : m_inferredOppoLeaves)
+	{
+		sum += it.probability;
+		m_inferredOppoLeaveCumulative.push_back(sum);
+	}
+}
+
+const Rack &Simulator::randomInferredOppoLeave() const
+{
+	const int resolution = numeric_limits<int>::max();
+	const double target = m_inferredOppoLeaveCumulative.back() * DataManager::self()->randomInteger(0, resolution - 1) / resolution;
+
+	const size_t index = upper_bound(m_inferredOppoLeaveCumulative.begin(), m_inferredOppoLeaveCumulative.end(), target) - m_inferredOppoLeaveCumulative.begin();
+	return m_inferredOppoLeaves[min(index, m_inferredOppoLeaves.size() - 1)].rack;
+}
+
 void Simulator::randomizeDrawingOrder()
 {
 	m_originalGame.currentPosition().setDrawingOrder(m_originalGame.currentPosition().bag().someShuffledTiles());
@@ -696,11 +916,26 @@ void LevelList::setNumberLevels(unsigned int number)
 		push_back(Level());
 }
 
+void LevelList::merge(const LevelList &other)
+{
+	setNumberLevels(other.size());
+	for (unsigned int i = 0; i < other.size(); ++i)
+		(*this)[i].merge(other[i]);
+}
+
 void SimmedMove::clear()
 {
 	levels.clear();
 }
 
+void SimmedMove::merge(const SimmedMove &other)
+{
+	levels.merge(other.levels);
+	residual.merge(other.residual);
+	gameSpread.merge(other.gameSpread);
+	wins.merge(other.wins);
+}
+
 PositionStatistics SimmedMove::getPositionStatistics(int level, int playerIndex) const
 {
 	return levels[level].statistics[playerIndex];
@@ -719,6 +954,12 @@ AveragedValue PositionStatistics::getStatistic(StatisticType type) const
 	return AveragedValue();
 }
 
+void PositionStatistics::merge(const PositionStatistics &other)
+{
+	score.merge(other.score);
+	bingos.merge(other.bingos);
+}
+
 ////////////
 
 void Level::setNumberScores(unsigned int number)
@@ -727,6 +968,13 @@ void Level::setNumberScores(unsigned int number)
 		statistics.push_back(PositionStatistics());
 }
 
+void Level::merge(const Level &other)
+{
+	setNumberScores(other.statistics.size());
+	for (unsigned int i = 0; i < other.statistics.size(); ++i)
+		statistics[i].merge(other.statistics[i]);
+}
+
 //////////
 
 UVOStream& operator<<(UVOStream &o, const Quackle::AveragedValue &value)
@@ -28,12 +28,15 @@
 #include <vector>
 
 #include "alphabetparameters.h"
+#include "enginecontext.h"
+#include "enumerator.h"
 #include "game.h"
 
 namespace Quackle
 {
 
 class ComputerDispatch;
+class DataManager;
 
 struct AveragedValue
 {
@@ -43,8 +46,18 @@ struct AveragedValue
     {
     }
 
+    // value with these sums already incorporated, eg as read back
+    // from a file
+    AveragedValue(long double valueSum, long double squaredValueSum, long int incorporatedValues)
+        : m_valueSum(valueSum), m_squaredValueSum(squaredValueSum), m_incorporatedValues(incorporatedValues)
+    {
+    }
+
     void incorporateValue(double newValue);
 
+    // incorporate every value that was incorporated into other
+    void merge(const AveragedValue &other);
+
     // zero everything
     void clear();
 
@@ -75,6 +88,13 @@ inline void AveragedValue::incorporateValue(double newValue)
     ++m_incorporatedValues;
 }
 
+inline void AveragedValue::merge(const AveragedValue &other)
+{
+    m_valueSum += other.m_valueSum;
+    m_squaredValueSum += other.m_squaredValueSum;
+    m_incorporatedValues += other.m_incorporatedValues;
+}
+
 inline long double AveragedValue::valueSum() const
 {
     return m_valueSum;
@@ -105,6 +125,8 @@ struct PositionStatistics
     enum StatisticType { StatisticScore, StatisticBingos };
     AveragedValue getStatistic(StatisticType type) const;
 
+    void merge(const PositionStatistics &other);
+
     AveragedValue score;
     AveragedValue bingos;
 };
@@ -116,6 +138,9 @@ struct Level
     // expand the scores list to be at least number long
     void setNumberScores(unsigned int number);
 
+    // merge each player's statistics, expanding as needed
+    void merge(const Level &other);
+
     PositionStatisticsList statistics;
 };
 
@@ -124,6 +149,9 @@ class LevelList : public vector<Level>
 public:
     // expand the levels list to be at least number long
     void setNumberLevels(unsigned int number);
+
+    // merge each level, expanding as needed
+    void merge(const LevelList &other);
 };
 
 struct SimmedMove
@@ -144,6 +172,9 @@ struct SimmedMove
     // clear all level values
     void clear();
 
+    // add the statistics of other, a simulation of the same move
+    void merge(const SimmedMove &other);
+
     bool includeInSimulation() const;
     void setIncludeInSimulation(bool includeInSimulation);
 
@@ -180,6 +211,10 @@ class SimmedMoveMessage
 {
 public:
     long id;
+
+    // the move's place among those simmed this iteration
+    unsigned int index;
+
     Move move;
     LevelList levels;
     vector<double> score;
@@ -203,6 +238,18 @@ public:
     int levelCount;
     bool ignoreOppos;
     bool isLogging;
+
+    // parameters snapshot shared by every rollout of an iteration,
+    // the simulator's m_context
+    const EngineContext *context;
+
+    // data manager current where the iteration was started, made
+    // current in the threads doing its rollouts
+    DataManager *dataManager;
+
+    // drawn from the starting thread's generator; each rollout seeds
+    // its own from this and its message's index
+    unsigned int seed;
 };
 
 class SimmedMoveMessageQueue
@@ -321,6 +368,13 @@ public:
     void setPartialOppoRack(const Rack &rack);
     const Rack &partialOppoRack() const;
 
+    // Set the leaves the oppo likely kept, weighted by probability,
+    // as found by an Inferrer. Unless a partial oppo rack is set,
+    // each iteration starts the oppo rack from one of these picked
+    // at random by weight. setPosition clears them.
+    void setInferredOppoLeaves(const ProbableRackList &leaves);
+    const ProbableRackList &inferredOppoLeaves() const;
+
     // Set oppo's racks to something random, including
     // tiles specified by setPartialOppoRack above.
     // Possibly inference-aided randomness.
@@ -329,6 +383,16 @@ public:
     // set drawing order for the first refill
     void randomizeDrawingOrder();
 
+    // If there's an analysis cache, pick up the statistics of an
+    // earlier simulation of this position. Called by the first
+    // simulate() after setPosition.
+    void resumeFromAnalysisCache(int plies);
+
+    // Save the statistics to the analysis cache if there is one and
+    // we've run more iterations than it has. Called when a chunk of
+    // simulate(plies, iterations) finishes and by setPosition.
+    void storeInAnalysisCache();
+
     // returns maximal number of iterations over all moves since
     // resetting numbers
     int iterations() const;
@@ -339,6 +403,21 @@ public:
     // full simulation information
     const SimmedMoveList &simmedMoves() const;
 
+    // Compact binary copy of the statistics gathered so far, for
+    // saving or for sending to another process.
+    string serializeState() const;
+
+    // Replace our moves and their statistics with those in state.
+    // Returns false, changing nothing, if state is corrupt or is
+    // for a different position.
+    bool deserializeState(const string &state);
+
+    // Add the statistics in state to ours as if its iterations had
+    // run here. Moves we aren't simulating are added unless
+    // addMissingMoves is false. Returns false, changing nothing, if
+    // state is corrupt or is for a different position.
+    bool mergeState(const string &state, bool addMissingMoves = true);
+
     // Return the moves sorted by simulated equity.
     // If prune is true, does not include plays that aren't included
     // in simulation anymore.
@@ -353,6 +432,8 @@ protected:
     void writeLogHeader();
     void writeLogFooter();
 
+    bool readState(const string &state, SimmedMoveList *moves, int *iterations) const;
+
     UVOFStream m_logfileStream;
     string m_logfile;
     bool m_logfileIsOpen;
@@ -360,6 +441,10 @@ protected:
     UVString m_xmlIndent;
 
     Rack m_partialOppoRack;
+    ProbableRackList m_inferredOppoLeaves;
+    vector<double> m_inferredOppoLeaveCumulative;
+
+    const Rack &randomInferredOppoLeave() const;
 
     Game m_originalGame;
     ComputerDispatch *m_dispatch;
@@ -372,6 +457,13 @@ protected:
     int m_iterations;
     bool m_ignoreOppos;
 
+    // retaken at the start of every iteration
+    EngineContext m_context;
+
+    int m_cachePlies;
+    bool m_checkedAnalysisCache;
+    int m_storedIterations;
+
     // Pair of thread and bool requesting to terminate
     std::vector<std::thread> m_threadPool;
     SimmedMoveMessageQueue m_sendQueue;
@@ -413,6 +505,11 @@ inline const Rack &Simulator::partialOppoRack() const
 	return m_partialOppoRack;
 }
 
+inline const ProbableRackList &Simulator::inferredOppoLeaves() const
+{
+	return m_inferredOppoLeaves;
+}
+
 inline void Simulator::setConsideredMoves(const MoveList &moves)
 {
 	m_consideredMoves = moves;
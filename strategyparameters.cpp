@@ -32,6 +32,7 @@ StrategyParameters::StrategyParameters()
 	, m_hasVcPlace(false)
 	, m_hasBogowin(false)
 	, m_hasSuperleaves(false)
+	, m_hash(0)
 {
 }
 
@@ -42,6 +43,46 @@ void StrategyParameters::initialize(const string &lexicon)
 	m_hasVcPlace = loadVcPlace(DataManager::self()->findDataFile("strategy", lexicon, "vcplace"));
 	m_hasBogowin = loadBogowin(DataManager::self()->findDataFile("strategy", lexicon, "bogowin"));
 	m_hasSuperleaves = loadSuperleaves(DataManager::self()->findDataFile("strategy", lexicon, "superleaves")); 	
+	updateHash();
+}
+
+// FNV-1a
+static uint64_t hashBytes(uint64_t hash, const void *data, size_t length)
+{
+	const unsigned char *bytes = static_cast<const unsigned char *>(data);
+	for (size_t i = 0; i < length; ++i)
+	{
+		hash ^= bytes[i];
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+void StrategyParameters::updateHash()
+{
+	const bool has[] = { m_hasSyn2, m_hasWorths, m_hasVcPlace, m_hasBogowin, m_hasSuperleaves };
+	uint64_t hash = hashBytes(14695981039346656037ULL, has, sizeof(has));
+
+	if (m_hasSyn2)
+		hash = hashBytes(hash, m_syn2, sizeof(m_syn2));
+	if (m_hasWorths)
+		hash = hashBytes(hash, m_tileWorths, sizeof(m_tileWorths));
+	if (m_hasVcPlace)
+		hash = hashBytes(hash, m_vcPlace, sizeof(m_vcPlace));
+	if (m_hasBogowin)
+		hash = hashBytes(hash, m_bogowin, sizeof(m_bogowin));
+	if (m_hasSuperleaves)
+	{
+		for (const auto &it : m_superleaves)
+		{
+			const uint8_t length = it.first.length();
+			hash = hashBytes(hash, &length, sizeof(length));
+			hash = hashBytes(hash, it.first.begin(), length);
+			hash = hashBytes(hash, &it.second, sizeof(it.second));
+		}
+	}
+
+	m_hash = hash;
 }
 
 bool StrategyParameters::loadSyn2(const string &filename)
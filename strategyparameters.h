@@ -19,6 +19,7 @@
 #ifndef QUACKLE_STRATEGYPARAMETERS_H
 #define QUACKLE_STRATEGYPARAMETERS_H
 
+#include <cstdint>
 #include <map>
 #include "alphabetparameters.h"
 
@@ -37,6 +38,10 @@ public:
 	bool hasBogowin() const;
 	bool hasSuperleaves() const;
 
+	// hash of the loaded tables, to tell apart analysis done with
+	// different strategy files
+	uint64_t hash() const;
+
 	// letters are raw letters include bottom marks
 	double syn2(Letter letter1, Letter letter2) const;
 	double tileWorth(Letter letter) const;
@@ -52,6 +57,7 @@ protected:
 	bool loadSuperleaves(const string &filename);
 	
 	int mapLetter(Letter letter) const;
+	void updateHash();
 
 	double m_syn2[QUACKLE_FIRST_LETTER + QUACKLE_MAXIMUM_ALPHABET_SIZE][QUACKLE_FIRST_LETTER + QUACKLE_MAXIMUM_ALPHABET_SIZE];
 	double m_tileWorths[QUACKLE_FIRST_LETTER + QUACKLE_MAXIMUM_ALPHABET_SIZE];
@@ -67,6 +73,7 @@ protected:
 	bool m_hasVcPlace;
 	bool m_hasBogowin;
 	bool m_hasSuperleaves;
+	uint64_t m_hash;
 };
 
 inline bool StrategyParameters::hasSyn2() const
@@ -94,6 +101,11 @@ inline bool StrategyParameters::hasSuperleaves() const
 	return m_hasSuperleaves;
 }
 
+inline uint64_t StrategyParameters::hash() const
+{
+	return m_hash;
+}
+
 inline int StrategyParameters::mapLetter(Letter letter) const
 {
 	// no mapping needed
@@ -18,25 +18,41 @@
 
 #include <QtCore>
 
+#include <QProcess>
+
 #include <iostream>
 #include <limits>
 #include <algorithm>
-
+#include <atomic>
+#include <cmath>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
+
+#include <alphagramindex.h>
+#include <binaryio.h>
 #include <bogowinplayer.h>
 #include <computerplayercollection.h>
 #include <resolvent.h>
 #include <datamanager.h>
+#include <distributedsim.h>
 #include <endgameplayer.h>
 #include <game.h>
 #include <gameparameters.h>
 #include <lexiconparameters.h>
 #include <strategyparameters.h>
 #include <enumerator.h>
+#include <gamearchive.h>
 #include <reporter.h>
+#include <sim.h>
+#include <wordquery.h>
 
 #include <quackleio/dictimplementation.h>
 #include <quackleio/flexiblealphabet.h>
 #include <quackleio/froggetopt.h>
+#include <quackleio/gcgarchive.h>
+#include <quackleio/gcgbulkreader.h>
 #include <quackleio/gcgio.h>
 #include <quackleio/util.h>
 
@@ -86,6 +102,29 @@ const char *usage =
 "       'randomracks' spit out random racks (forever?).\n"
 "       'leavecalc' spit out roughish values of leaves in 'leaves' file.\n"
 "       'anagram' anagrams letters supplied in --letters.\n"
+"       'distsim' sims all positions on --workers worker processes.\n"
+"       'simworker' serves the distsim listening at --socket.\n"
+"       'corruptrecords' checks that binary records claiming more\n"
+"                        letters than fit are rejected.\n"
+"       'gaddagbench' times move generation on the gaddag as loaded and\n"
+"                     compacted, over positions from --repetitions games.\n"
+"       'alphagrams' writes the lexicon's alphagram index, to be put\n"
+"                    next to its dawg.\n"
+"       'wordqueries' checks that regexes the word query compiles match\n"
+"                     the same words of the lexicon as QRegExp.\n"
+"       'validate' lists plays in the --position games that form words\n"
+"                  not in the lexicon.\n"
+"       'gcgstats' bulk-reads the --position games and sums up their\n"
+"                  moves.\n"
+"       'archive' saves the --position games to --archive and times\n"
+"                 reading positions back.\n"
+"       'unarchive' writes the games of --archive out as gcgs.\n"
+"       'parallelselfplay' plays --repetitions selfplay games on\n"
+"                          --threads threads, each seeded from --seed\n"
+"                          and its number, and writes results to --stats.\n"
+"       'replaycheck' plays --repetitions (default 10) games between\n"
+"                     simming players on one thread and on --threads\n"
+"                     threads, and checks each game came out the same.\n"
 "--position=game.gcg; this option can be repeated to specify positions\n"
 "                     to test.\n"
 "--lexicon=; sets the lexicon (default 'twl06').\n"
@@ -95,7 +134,14 @@ const char *usage =
 "--letters; letters to anagram.\n"
 "--build; when mode is anagram, do not require that all letters be used.\n"
 "--quiet; print nothing during selfplay games (default false).\n"
-"--repetitions=integer; the number of games for selfplay (default 1000).\n";
+"--repetitions=integer; the number of games for selfplay or iterations\n"
+"                       for distsim (default 1000).\n"
+"--workers=integer; the number of worker processes for distsim (default 2).\n"
+"--socket=path; the socket distsim listens at (default in the temp dir).\n"
+"--archive=file; the game archive (default 'games.qga').\n"
+"--threads=integer; threads for parallelselfplay (default one per core).\n"
+"--stats=file; parallelselfplay writes file.csv and file.json\n"
+"              (default 'selfplay').\n";
 
 void TestHarness::executeFromArguments()
 {
@@ -106,12 +152,18 @@ void TestHarness::executeFromArguments()
 	QString computer2;
 	QString seedString;
 	QString repString;
+	QString workersString;
+	QString socketPath;
+	QString archiveFile;
+	QString threadsString;
+	QString statsFile;
 	bool build;
 	QString letters;
 	bool help;
 	bool report;
 	unsigned int seed = numeric_limits<unsigned int>::max();
 	unsigned int reps = 1000;
+	int workers = 2;
 
 	opts.addOption('c', "computer", &computer);
 	opts.addOption('d', "computer2", &computer2);
@@ -121,6 +173,11 @@ void TestHarness::executeFromArguments()
 	opts.addOption('s', "seed", &seedString);
 	opts.addOption('r', "repetitions", &repString);
 	opts.addOption('t', "letters", &letters);
+	opts.addOption('w', "workers", &workersString);
+	opts.addOption('o', "socket", &socketPath);
+	opts.addOption('g', "archive", &archiveFile);
+	opts.addOption('n', "threads", &threadsString);
+	opts.addOption('u', "stats", &statsFile);
 	opts.addRepeatableOption("position", &m_positions);
 
 	opts.addSwitch("report", &report);
@@ -151,6 +208,15 @@ void TestHarness::executeFromArguments()
 	        seed = seedString.toUInt();
 	if (!repString.isNull())
 	        reps = repString.toUInt();
+	if (!workersString.isNull())
+		workers = workersString.toInt();
+	if (archiveFile.isNull())
+		archiveFile = "games.qga";
+	int threads = max(1u, thread::hardware_concurrency());
+	if (!threadsString.isNull())
+		threads = max(1, threadsString.toInt());
+	if (statsFile.isNull())
+		statsFile = "selfplay";
 
 
 	m_computerPlayerToTest = checkPlayerName(computer);
@@ -178,10 +244,34 @@ void TestHarness::executeFromArguments()
 		selfPlayGames(seed, reps, report, false);
 	else if (mode == "playability")
 		selfPlayGames(seed, reps, report, true);
+	else if (mode == "parallelselfplay")
+		parallelSelfPlayGames(seed, reps, threads, statsFile);
+	else if (mode == "replaycheck")
+		checkSelfPlayReplay(seed, repString.isNull() ? 10 : reps, threads);
 	else if (mode == "worddump")
 		wordDump();
 	else if (mode == "bingos")
 		bingos();
+	else if (mode == "distsim")
+		distributedSim(socketPath, workers, reps, seed);
+	else if (mode == "simworker")
+		simulationWorker(socketPath);
+	else if (mode == "corruptrecords")
+		checkCorruptRecords();
+	else if (mode == "gaddagbench")
+		gaddagBenchmark(seed, reps);
+	else if (mode == "alphagrams")
+		writeAlphagramIndex();
+	else if (mode == "wordqueries")
+		checkWordQueries();
+	else if (mode == "validate")
+		validatePositions();
+	else if (mode == "gcgstats")
+		gcgStatistics();
+	else if (mode == "archive")
+		archivePositions(archiveFile);
+	else if (mode == "unarchive")
+		unarchivePositions(archiveFile);
 }
 
 void TestHarness::startUp()
@@ -211,6 +301,10 @@ void TestHarness::startUp()
    	m_dataManager.lexiconParameters()->loadGaddag(Quackle::LexiconParameters::findDictionaryFile(QuackleIO::Util::qstringToStdString(m_lexicon + ".gaddag")));
 	UVcout << ".";
 
+	const string alphagramFile = Quackle::LexiconParameters::findDictionaryFile(QuackleIO::Util::qstringToStdString(m_lexicon + ".alphagrams"));
+	if (!alphagramFile.empty())
+		m_dataManager.lexiconParameters()->loadAlphagramIndex(alphagramFile);
+
 	m_dataManager.strategyParameters()->initialize(QuackleIO::Util::qstringToStdString(m_lexicon));
 
 	UVcout << endl;
@@ -390,10 +484,7 @@ void TestHarness::enumerateAll()
 {
 	Quackle::Bag B;
 	Enumerator E(B);
-	ProbableRackList racks;
-	E.enumerate(&racks);
-	for (ProbableRackList::iterator it = racks.begin(); it != racks.end(); ++it)
-		UVcout << (*it).rack << " " << (*it).probability << endl;
+	E.enumerate([](const ProbableRack &rack) { UVcout << rack.rack << " " << rack.probability << endl; }, QUACKLE_PARAMETERS->rackSize());
 }
 
 struct PowerRack
@@ -650,6 +741,368 @@ void TestHarness::testReport(bool html)
 	}
 }
 
+void TestHarness::distributedSim(const QString &socketPath, int workers, unsigned int iterations, unsigned int seed)
+{
+	const QString path = socketPath.isNull()? QDir(QDir::tempPath()).filePath(QString("quackle-sim-%1.sock").arg(QCoreApplication::applicationPid())) : socketPath;
+	if (seed == numeric_limits<unsigned int>::max())
+		seed = m_dataManager.randomInteger(0, numeric_limits<int>::max());
+
+	Quackle::Simulator simulator;
+	Quackle::DistributedSimulator distributed(simulator);
+	if (!distributed.listen(QuackleIO::Util::qstringToStdString(path)))
+	{
+		UVcout << "Couldn't listen at " << QuackleIO::Util::qstringToString(path) << "." << endl;
+		return;
+	}
+
+	QStringList arguments;
+	arguments << "--mode=simworker" << QString("--socket=%1").arg(path) << QString("--lexicon=%1").arg(m_lexicon) << QString("--alphabet=%1").arg(m_alphabet) << "--quiet";
+
+	QList<QProcess *> processes;
+	for (int i = 0; i < workers; ++i)
+	{
+		QProcess *process = new QProcess;
+		process->setProcessChannelMode(QProcess::ForwardedChannels);
+		process->start(QCoreApplication::applicationFilePath(), arguments);
+		processes.push_back(process);
+	}
+
+	if (!distributed.waitForWorkers(workers, 60))
+		UVcout << "Only " << distributed.workerCount() << " of " << workers << " workers connected." << endl;
+
+	// enough units that a slow worker doesn't hold up the rest
+	const int iterationsPerUnit = max(1, static_cast<int>(iterations) / max(1, workers * 8));
+
+	for (QStringList::iterator it = m_positions.begin(); it != m_positions.end(); ++it)
+	{
+		Quackle::Game *game = createNewGame(*it);
+		if (!game)
+			continue;
+
+		Quackle::GamePosition position = game->currentPosition();
+		position.kibitz(10);
+		simulator.setPosition(position);
+
+		QElapsedTimer time;
+		time.start();
+		const bool complete = distributed.simulate(2, iterations, iterationsPerUnit, seed);
+		UVcout << QuackleIO::Util::qstringToString(*it) << ": " << simulator.iterations() << " iterations on " << distributed.workerCount() << " workers in " << time.elapsed() << " ms" << (complete? "" : " (incomplete)") << endl;
+
+		const MoveList moves = simulator.moves(true);
+		for (MoveList::const_iterator moveIt = moves.begin(); moveIt != moves.end(); ++moveIt)
+			UVcout << *moveIt << endl;
+
+		delete game;
+	}
+
+	distributed.shutdownWorkers();
+	distributed.close();
+
+	for (QList<QProcess *>::iterator it = processes.begin(); it != processes.end(); ++it)
+	{
+		(*it)->waitForFinished();
+		delete *it;
+	}
+}
+
+void TestHarness::simulationWorker(const QString &socketPath)
+{
+	Quackle::SimulationWorker worker;
+	const bool ok = worker.connectAndServe(QuackleIO::Util::qstringToStdString(socketPath));
+	if (!m_quiet)
+		UVcout << "Simulated " << worker.unitsDone() << " work units" << (ok? "" : " before losing the connection") << "." << endl;
+}
+
+void TestHarness::checkCorruptRecords()
+{
+	// a move whose tiles claim a length of 200, followed by the rest
+	// of a record
+	Quackle::BinaryWriter writer;
+	writer.writeU8(Quackle::Move::Place);
+	writer.writeU8(1);
+	for (int i = 0; i < 3; ++i)
+		writer.writeI32(7);
+	writer.writeU8(0);
+	for (int i = 0; i < 3; ++i)
+		writer.writeDouble(0);
+	writer.writeU8(200);
+	for (int i = 0; i < 200; ++i)
+		writer.writeU8(QUACKLE_FIRST_LETTER);
+	writer.writeI32(42);
+
+	Quackle::BinaryReader letterReader(writer.data());
+	letterReader.readU8();
+	letterReader.readU8();
+	for (int i = 0; i < 3; ++i)
+		letterReader.readI32();
+	letterReader.readU8();
+	for (int i = 0; i < 3; ++i)
+		letterReader.readDouble();
+	const LetterString letters = letterReader.readLetters();
+	const bool lettersRejected = !letterReader.ok() && letters.empty() && letterReader.readI32() == 42;
+
+	Quackle::BinaryReader moveReader(writer.data());
+	moveReader.readMove();
+	const bool moveRejected = !moveReader.ok();
+
+	UVcout << "Letters of length 200: " << (lettersRejected? "rejected" : "NOT REJECTED") << endl;
+	UVcout << "Move with tiles of length 200: " << (moveRejected? "rejected" : "NOT REJECTED") << endl;
+	if (!lettersRejected || !moveRejected)
+		exit(1);
+}
+
+void TestHarness::validatePositions()
+{
+	int wordCount = 0;
+	int unacceptableCount = 0;
+	for (QStringList::iterator it = m_positions.begin(); it != m_positions.end(); ++it)
+	{
+		Quackle::Game *game = createNewGame(*it);
+		if (!game)
+			continue;
+
+		// every word of the game is checked in one batch
+		Quackle::WordList words;
+		vector<const Quackle::GamePosition *> formedIn;
+		for (const auto &position : game->history())
+		{
+			if (position.committedMove().action != Quackle::Move::Place)
+				continue;
+
+			for (const auto &word : position.allWordsFormedBy(position.committedMove()))
+			{
+				words.push_back(word.wordTiles());
+				formedIn.push_back(&position);
+			}
+		}
+
+		const vector<bool> acceptable = game->currentPosition().areAcceptableWords(words);
+		for (size_t i = 0; i < words.size(); ++i)
+		{
+			if (acceptable[i])
+				continue;
+
+			UVcout << QuackleIO::Util::qstringToString(*it) << ": turn " << formedIn[i]->turnNumber() << ", " << formedIn[i]->currentPlayer().name() << " played " << formedIn[i]->committedMove() << " forming " << QUACKLE_ALPHABET_PARAMETERS->userVisible(words[i]) << endl;
+			++unacceptableCount;
+		}
+
+		wordCount += words.size();
+		delete game;
+	}
+
+	UVcout << unacceptableCount << " of " << wordCount << " words formed are not in " << QuackleIO::Util::qstringToString(m_lexicon) << "." << endl;
+}
+
+void TestHarness::gcgStatistics()
+{
+	QElapsedTimer timer;
+	timer.start();
+
+	int turnCount = 0;
+	int placeCount = 0;
+	int bingoCount = 0;
+	long long placeScore = 0;
+	QuackleIO::GCGBulkReader reader;
+	const int readCount = reader.read(m_positions, QuackleIO::GCGBulkReader::SummaryOnly, [&](QuackleIO::GCGRecord &record) {
+		if (!record.error.empty())
+			UVcout << QuackleIO::Util::qstringToString(record.filename) << ": " << record.error << endl;
+
+		for (const auto &turn : record.turns)
+		{
+			++turnCount;
+			if (turn.move.action != Quackle::Move::Place || turn.move.isChallengedPhoney())
+				continue;
+
+			++placeCount;
+			placeScore += turn.move.score;
+			if ((int)turn.move.wordTilesWithNoPlayThru().length() == QUACKLE_PARAMETERS->rackSize())
+				++bingoCount;
+		}
+	});
+
+	UVcout << "Read " << readCount << " of " << m_positions.size() << " games in " << timer.elapsed() << " ms on " << reader.threadCount() << " threads." << endl;
+	UVcout << turnCount << " turns, " << placeCount << " plays averaging " << (placeCount? (double)placeScore / placeCount : 0) << " points, " << bingoCount << " bingos." << endl;
+}
+
+void TestHarness::archivePositions(const QString &archiveFile)
+{
+	QElapsedTimer timer;
+	timer.start();
+
+	const int archived = QuackleIO::GCGArchive::archiveGCGs(m_positions, archiveFile);
+	if (archived < 0)
+		return;
+	UVcout << "Archived " << archived << " of " << m_positions.size() << " games in " << timer.elapsed() << " ms." << endl;
+
+	Quackle::GameArchive archive;
+	timer.restart();
+	if (!archive.load(QuackleIO::Util::qstringToStdString(archiveFile)) || archive.gameCount() == 0)
+	{
+		UVcout << "Could not load " << QuackleIO::Util::qstringToString(archiveFile) << "." << endl;
+		return;
+	}
+	UVcout << "Loaded the archive in " << timer.elapsed() << " ms." << endl;
+
+	const int lookups = 100000;
+	int turns = 0;
+	timer.restart();
+	for (int i = 0; i < lookups; ++i)
+	{
+		const int game = archive.findGame(archive.gameId(i % archive.gameCount()));
+		const Quackle::ArchivedTurn turn = archive.turn(game, i % max(1, archive.turnCount(game)));
+		if (turn.playerId >= 0)
+			++turns;
+	}
+	UVcout << "Read " << turns << " turns by game id in " << timer.nsecsElapsed() / lookups << " ns each." << endl;
+
+	const int positions = 1000;
+	timer.restart();
+	for (int i = 0; i < positions; ++i)
+	{
+		const int game = i % archive.gameCount();
+		archive.position(game, i % max(1, archive.turnCount(game)));
+	}
+	UVcout << "Rebuilt positions in " << timer.nsecsElapsed() / positions / 1000 << " us each." << endl;
+}
+
+void TestHarness::unarchivePositions(const QString &archiveFile)
+{
+	Quackle::GameArchive archive;
+	if (!archive.load(QuackleIO::Util::qstringToStdString(archiveFile)))
+	{
+		UVcout << "Could not load " << QuackleIO::Util::qstringToString(archiveFile) << "." << endl;
+		return;
+	}
+
+	QDir::current().mkpath(m_gamesDir);
+	const int written = QuackleIO::GCGArchive::extractGCGs(archive, m_gamesDir);
+	UVcout << "Wrote " << written << " of " << archive.gameCount() << " games to " << QuackleIO::Util::qstringToString(m_gamesDir) << "." << endl;
+}
+
+void TestHarness::writeAlphagramIndex()
+{
+	Quackle::AlphagramIndex index;
+	index.build(*m_dataManager.lexiconParameters());
+	if (index.isEmpty())
+	{
+		UVcout << "No dawg for " << QuackleIO::Util::qstringToString(m_lexicon) << endl;
+		return;
+	}
+
+	const string filename = QuackleIO::Util::qstringToStdString(m_lexicon + ".alphagrams");
+	if (index.save(filename))
+		UVcout << "Wrote " << index.wordCount() << " words to " << filename << "." << endl;
+	else
+		UVcout << "Could not write " << filename << "." << endl;
+}
+
+void TestHarness::checkWordQueries()
+{
+	// anchors on alternatives, groups, classes and counted repeats,
+	// and syntax left to QRegExp
+	const char *expressions[] = { "^AB|CD$", "AB|CD$", "J|^Q", "^|Z", "^(AN|BE)(T|S)?$", "(ING|ED)$", "^RE(A|E)+", "^.{3}$", "A{2,3}", "X.*Z", "Q[^U]", "^[^AEIOU]+$", "^A*$", "\\w+", "\\bA", "\\d", "A$B", "(^A)" };
+
+	Quackle::WordQueryEngine engine(QUACKLE_LEXICON_PARAMETERS);
+	const vector<Quackle::WordWithInfo> words = engine.query(Quackle::WordQuery());
+
+	int mismatchedCount = 0;
+	for (const auto &expression : expressions)
+	{
+		const QString text(expression);
+		Quackle::WordQuery query;
+		if (!query.setRegex(QuackleIO::Util::qstringToString(text)))
+		{
+			UVcout << expression << ": left to QRegExp (" << query.error() << ")" << endl;
+			continue;
+		}
+
+		QRegExp regexp(text);
+		regexp.setCaseSensitivity(Qt::CaseInsensitive);
+
+		int matchCount = 0;
+		int mismatches = 0;
+		for (const auto &word : words)
+		{
+			const bool regexpMatches = regexp.indexIn(QuackleIO::Util::letterStringToQString(word.wordLetterString)) >= 0;
+			if (regexpMatches)
+				++matchCount;
+			if (regexpMatches != query.matches(word.wordLetterString))
+				++mismatches;
+		}
+
+		// the lexicon walk has to find the same words
+		const int found = (int)engine.query(query).size();
+		if (found != matchCount)
+			++mismatches;
+
+		UVcout << expression << ": " << matchCount << " words, " << mismatches << " mismatches" << endl;
+		if (mismatches > 0)
+			++mismatchedCount;
+	}
+
+	if (mismatchedCount > 0)
+		exit(1);
+}
+
+void TestHarness::gaddagBenchmark(unsigned int seed, unsigned int games)
+{
+	Quackle::LexiconParameters *lexicon = m_dataManager.lexiconParameters();
+	if (!lexicon->hasGaddag())
+	{
+		UVcout << "No gaddag for " << QuackleIO::Util::qstringToString(m_lexicon) << endl;
+		return;
+	}
+
+	if (seed != numeric_limits<unsigned int>::max())
+		m_dataManager.seedRandomNumbers(seed);
+
+	// the positions of static player games, so both layouts see the same ones
+	Quackle::StaticPlayer staticPlayer;
+	vector<Quackle::GamePosition> positions;
+	for (unsigned int i = 0; i < games; i++)
+	{
+		Quackle::Game game;
+		Quackle::PlayerList players;
+		players.push_back(Quackle::Player(MARK_UV("A"), Quackle::Player::ComputerPlayerType, 0));
+		players.push_back(Quackle::Player(MARK_UV("B"), Quackle::Player::ComputerPlayerType, 1));
+		game.setPlayers(players);
+		game.addPosition();
+
+		while (!game.currentPosition().gameOver())
+		{
+			positions.push_back(game.currentPosition());
+			game.haveComputerPlay(&staticPlayer);
+		}
+	}
+
+	vector<Quackle::MoveList> moves[2];
+	for (int compact = 0; compact < 2; compact++)
+	{
+		if (compact)
+			lexicon->compactGaddag();
+
+		QElapsedTimer time;
+		time.start();
+		for (auto &it : positions)
+		{
+			it.kibitz(20);
+			moves[compact].push_back(it.moves());
+		}
+
+		UVcout << (compact? "compact: " : "standard: ") << lexicon->gaddagBytes() << " bytes, " << positions.size() << " positions in " << time.elapsed() << " ms" << endl;
+	}
+
+	bool same = true;
+	for (size_t i = 0; i < positions.size() && same; i++)
+	{
+		same = moves[0][i].size() == moves[1][i].size();
+		for (size_t j = 0; j < moves[0][i].size() && same; j++)
+			same = moves[0][i][j] == moves[1][i][j] && moves[0][i][j].equity == moves[1][i][j].equity;
+	}
+
+	UVcout << (same? "Both layouts found the same moves." : "The layouts found different moves!") << endl;
+}
+
 void TestHarness::selfPlayGames(unsigned int seed, unsigned int reps, bool reports, bool playability)
 {
 	if (seed != numeric_limits<unsigned int>::max()) {
@@ -787,9 +1240,331 @@ void TestHarness::selfPlayGame(unsigned int gameNumber, bool reports, bool playa
 	outFileReport.close();
 }
 
-static void dumpGaddag(const GaddagNode *node, const LetterString &prefix)
+// a running mean and variance of a sample
+struct Tally
+{
+	Tally() : count(0), sum(0), sumSquares(0) {}
+
+	void add(double value)
+	{
+		++count;
+		sum += value;
+		sumSquares += value * value;
+	}
+
+	double mean() const
+	{
+		return count ? sum / count : 0;
+	}
+
+	// sample standard deviation
+	double deviation() const
+	{
+		if (count < 2)
+			return 0;
+		return sqrt(max(0.0, (sumSquares - sum * sum / count) / (count - 1)));
+	}
+
+	// half the width of the mean's 95% confidence interval
+	double margin() const
+	{
+		return count ? 1.96 * deviation() / sqrt((double)count) : 0;
+	}
+
+	QJsonObject toJson() const
+	{
+		QJsonObject ret;
+		ret["mean"] = mean();
+		ret["low"] = mean() - margin();
+		ret["high"] = mean() + margin();
+		return ret;
+	}
+
+	long long count;
+	double sum;
+	double sumSquares;
+};
+
+struct SelfPlayGameResult
+{
+	int scores[2];
+	int bingos[2];
+	int moves[2];
+	double seconds[2];
+	bool finished;
+};
+
+// Totals of one player's games; scores are also counted by value
+// for the distribution.
+struct SelfPlayTotals
+{
+	Tally wins;
+	Tally scores;
+	Tally spreads;
+	Tally bingosPerGame;
+	Tally bingosPerMove;
+	Tally secondsPerMove;
+	map<int, long long> scoreCounts;
+
+	int scorePercentile(double fraction) const
+	{
+		const long long rank = (long long)(fraction * (scores.count - 1));
+		long long seen = 0;
+		for (const auto &it : scoreCounts)
+		{
+			seen += it.second;
+			if (seen > rank)
+				return it.first;
+		}
+		return 0;
+	}
+
+	QJsonObject toJson() const
+	{
+		QJsonObject distribution;
+		distribution["stddev"] = scores.deviation();
+		distribution["min"] = scoreCounts.empty() ? 0 : scoreCounts.begin()->first;
+		distribution["p10"] = scorePercentile(0.1);
+		distribution["p25"] = scorePercentile(0.25);
+		distribution["median"] = scorePercentile(0.5);
+		distribution["p75"] = scorePercentile(0.75);
+		distribution["p90"] = scorePercentile(0.9);
+		distribution["max"] = scoreCounts.empty() ? 0 : scoreCounts.rbegin()->first;
+
+		QJsonObject ret;
+		ret["winRate"] = wins.toJson();
+		ret["score"] = scores.toJson();
+		ret["scoreDistribution"] = distribution;
+		ret["spread"] = spreads.toJson();
+		ret["bingosPerGame"] = bingosPerGame.toJson();
+		ret["bingosPerMove"] = bingosPerMove.toJson();
+		ret["secondsPerMove"] = secondsPerMove.toJson();
+		return ret;
+	}
+};
+
+// Sims its top few plays for a set number of iterations rather than
+// for a set time, so its choices depend only on the random numbers.
+class FixedIterationSimPlayer : public Quackle::ComputerPlayer
+{
+public:
+	FixedIterationSimPlayer()
+	{
+		m_name = MARK_UV("Fixed Iteration Sim Player");
+		m_id = 9001;
+	}
+
+	virtual Quackle::ComputerPlayer *clone() { return new FixedIterationSimPlayer; }
+
+	virtual Quackle::Move move()
+	{
+		currentPosition().kibitz(5);
+		m_simulator.setIncludedMoves(m_simulator.currentPosition().moves());
+		m_simulator.simulate(2, 20);
+		return m_simulator.moves(/* prune */ true, /* sort by win */ true).front();
+	}
+};
+
+static SelfPlayGameResult playSelfPlayGame(Quackle::ComputerPlayer *playerA, Quackle::ComputerPlayer *playerB)
+{
+	Quackle::Game game;
+	Quackle::PlayerList players;
+
+	Quackle::Player compyA(playerA->name() + MARK_UV(" A"), Quackle::Player::ComputerPlayerType, 0);
+	compyA.setAbbreviatedName(MARK_UV("A"));
+	compyA.setComputerPlayer(playerA);
+	players.push_back(compyA);
+
+	Quackle::Player compyB(playerB->name() + MARK_UV(" B"), Quackle::Player::ComputerPlayerType, 1);
+	compyB.setAbbreviatedName(MARK_UV("B"));
+	compyB.setComputerPlayer(playerB);
+	players.push_back(compyB);
+
+	game.setPlayers(players);
+	game.associateKnownComputerPlayers();
+	game.addPosition();
+
+	SelfPlayGameResult result = { { 0, 0 }, { 0, 0 }, { 0, 0 }, { 0, 0 }, false };
+
+	const int playahead = 50;
+	for (int i = 0; i < playahead && !game.currentPosition().gameOver(); ++i)
+	{
+		const int player = game.currentPosition().currentPlayer().id();
+
+		QElapsedTimer timer;
+		timer.start();
+		const Quackle::Move move(game.haveComputerPlay());
+		result.seconds[player] += timer.nsecsElapsed() / 1e9;
+
+		++result.moves[player];
+		if (move.isBingo)
+			++result.bingos[player];
+	}
+
+	result.finished = game.currentPosition().gameOver();
+	for (const auto &it : game.currentPosition().endgameAdjustedScores())
+		result.scores[it.id()] = it.score();
+
+	return result;
+}
+
+void TestHarness::parallelSelfPlayGames(unsigned int seed, unsigned int reps, int threadCount, const QString &statsFile)
+{
+	if (seed == numeric_limits<unsigned int>::max())
+		seed = random_device()();
+	UVcout << "Playing " << reps << " games on " << threadCount << " threads using seed " << seed << endl;
+
+	QFile csvFile(statsFile + ".csv");
+	if (!csvFile.open(QIODevice::WriteOnly | QIODevice::Text))
+	{
+		UVcout << "Could not open " << QuackleIO::Util::qstringToString(csvFile.fileName()) << endl;
+		return;
+	}
+	QTextStream csv(&csvFile);
+	csv << "game,seed,finished,score_a,score_b,bingos_a,bingos_b,moves_a,moves_b,seconds_a,seconds_b" << endl;
+
+	SelfPlayTotals totals[2];
+	unsigned int played = 0;
+	unsigned int unfinished = 0;
+	mutex resultsMutex;
+	atomic<unsigned int> nextGame(0);
+
+	QElapsedTimer timer;
+	timer.start();
+
+	Quackle::DataManager *dataManager = &m_dataManager;
+	auto worker = [&]() {
+		Quackle::DataManagerScope scope(dataManager);
+
+		unique_ptr<Quackle::ComputerPlayer> playerA(m_computerPlayerToTest->clone());
+		playerA->setParameters(m_computerPlayerToTest->parameters());
+		unique_ptr<Quackle::ComputerPlayer> playerB(m_computerPlayer2ToTest->clone());
+		playerB->setParameters(m_computerPlayer2ToTest->parameters());
+
+		for (unsigned int gameNumber = nextGame++; gameNumber < reps; gameNumber = nextGame++)
+		{
+			seed_seq gameSeed = { seed, gameNumber };
+			Quackle::RandomNumberScope random(gameSeed);
+			const SelfPlayGameResult result = playSelfPlayGame(playerA.get(), playerB.get());
+
+			lock_guard<mutex> lock(resultsMutex);
+			csv << gameNumber << "," << seed << "," << (result.finished ? 1 : 0);
+			for (const auto *values : { result.scores, result.bingos, result.moves })
+				csv << "," << values[0] << "," << values[1];
+			csv << "," << result.seconds[0] << "," << result.seconds[1] << endl;
+
+			++played;
+			if (!result.finished)
+				++unfinished;
+
+			for (int player = 0; player < 2; ++player)
+			{
+				const int other = 1 - player;
+				SelfPlayTotals &it = totals[player];
+				it.wins.add(result.scores[player] > result.scores[other] ? 1 : result.scores[player] == result.scores[other] ? 0.5 : 0);
+				it.scores.add(result.scores[player]);
+				++it.scoreCounts[result.scores[player]];
+				it.spreads.add(result.scores[player] - result.scores[other]);
+				it.bingosPerGame.add(result.bingos[player]);
+				if (result.moves[player] > 0)
+				{
+					it.bingosPerMove.add((double)result.bingos[player] / result.moves[player]);
+					it.secondsPerMove.add(result.seconds[player] / result.moves[player]);
+				}
+			}
+
+			if (!m_quiet && played % 100 == 0)
+				UVcout << played << " games played" << endl;
+		}
+	};
+
+	vector<thread> threads;
+	for (int i = 1; i < threadCount; ++i)
+		threads.emplace_back(worker);
+	worker();
+	for (auto &it : threads)
+		it.join();
+
+	const double seconds = timer.elapsed() / 1000.0;
+
+	QJsonObject summary;
+	summary["games"] = (double)played;
+	summary["unfinishedGames"] = (double)unfinished;
+	summary["seed"] = (double)seed;
+	summary["threads"] = threadCount;
+	summary["seconds"] = seconds;
+	summary["confidence"] = 0.95;
+	const Quackle::ComputerPlayer *computerPlayers[2] = { m_computerPlayerToTest, m_computerPlayer2ToTest };
+	const char *keys[2] = { "playerA", "playerB" };
+	for (int player = 0; player < 2; ++player)
+	{
+		QJsonObject totalsJson = totals[player].toJson();
+		totalsJson["name"] = QuackleIO::Util::uvStringToQString(computerPlayers[player]->name());
+		summary[keys[player]] = totalsJson;
+	}
+
+	QFile jsonFile(statsFile + ".json");
+	if (jsonFile.open(QIODevice::WriteOnly | QIODevice::Text))
+		jsonFile.write(QJsonDocument(summary).toJson());
+	else
+		UVcout << "Could not open " << QuackleIO::Util::qstringToString(jsonFile.fileName()) << endl;
+
+	UVcout << "Played " << played << " games in " << seconds << " seconds." << endl;
+	for (int player = 0; player < 2; ++player)
+	{
+		const SelfPlayTotals &it = totals[player];
+		UVcout << computerPlayers[player]->name() << (player ? " B" : " A") << ": wins " << 100 * it.wins.mean() << "% +/- " << 100 * it.wins.margin()
+		       << ", score " << it.scores.mean() << " +/- " << it.scores.margin()
+		       << ", bingos per game " << it.bingosPerGame.mean() << " +/- " << it.bingosPerGame.margin()
+		       << ", " << 1000 * it.secondsPerMove.mean() << " ms per move" << endl;
+	}
+}
+
+void TestHarness::checkSelfPlayReplay(unsigned int seed, unsigned int reps, int threadCount)
+{
+	if (seed == numeric_limits<unsigned int>::max())
+		seed = random_device()();
+
+	FixedIterationSimPlayer simPlayer;
+	Quackle::ComputerPlayer *const testedPlayers[2] = { m_computerPlayerToTest, m_computerPlayer2ToTest };
+	m_computerPlayerToTest = &simPlayer;
+	m_computerPlayer2ToTest = &simPlayer;
+
+	const int threadCounts[2] = { 1, max(threadCount, 2) };
+	QStringList rows[2];
+	for (int run = 0; run < 2; ++run)
+	{
+		const QString statsFile = QString("replay%1").arg(threadCounts[run]);
+		parallelSelfPlayGames(seed, reps, threadCounts[run], statsFile);
+
+		// every column but the move times, in order of game
+		QFile csvFile(statsFile + ".csv");
+		if (!csvFile.open(QIODevice::ReadOnly | QIODevice::Text))
+			continue;
+
+		QTextStream csv(&csvFile);
+		csv.readLine();
+		while (!csv.atEnd())
+			rows[run].append(csv.readLine().section(',', 0, -3));
+
+		sort(rows[run].begin(), rows[run].end(), [](const QString &first, const QString &second) {
+			return first.section(',', 0, 0).toUInt() < second.section(',', 0, 0).toUInt();
+		});
+	}
+
+	m_computerPlayerToTest = testedPlayers[0];
+	m_computerPlayer2ToTest = testedPlayers[1];
+
+	const bool replayed = !rows[0].isEmpty() && rows[0] == rows[1];
+	UVcout << "Games on " << threadCounts[0] << " and " << threadCounts[1] << " threads: " << (replayed ? "the same" : "DIFFERENT") << endl;
+	if (!replayed)
+		exit(1);
+}
+
+template <class Node>
+static void dumpGaddag(Node node, const LetterString &prefix)
 {
-    for (const GaddagNode* child = node->firstChild(); child; child = child->nextSibling()) {
+    for (Node child = node->firstChild(); child; child = child->nextSibling()) {
 	Letter childLetter = child->letter();
 	LetterString newPrefix(prefix);
 	newPrefix += childLetter;
@@ -805,9 +1580,13 @@ static void dumpGaddag(const GaddagNode *node, const LetterString &prefix)
 
 void TestHarness::wordDump()
 {
-    if (QUACKLE_LEXICON_PARAMETERS->hasGaddag()) {
-	dumpGaddag(QUACKLE_LEXICON_PARAMETERS->gaddagRoot(),
-		      LetterString());
+    const Quackle::LexiconParameters *lexicon = QUACKLE_LEXICON_PARAMETERS;
+    if (lexicon->hasCompactGaddag()) {
+	dumpGaddag(lexicon->compactGaddagRoot(), LetterString());
+    } else if (lexicon->hasNarrowGaddag()) {
+	dumpGaddag(lexicon->narrowGaddagRoot(), LetterString());
+    } else if (lexicon->hasGaddag()) {
+	dumpGaddag(lexicon->gaddagRoot(), LetterString());
     } else {
 	UVcout << "wordDump: no gaddag" << endl;
     }
@@ -82,9 +82,57 @@ public:
 	// Allocates and loads a game from the file.
 	Quackle::Game *createNewGame(const QString &filename);
 
+	// Sims the positions across workers worker processes started
+	// from this executable, each running simulationWorker().
+	void distributedSim(const QString &socketPath, int workers, unsigned int iterations, unsigned int seed);
+
+	// Serves the distributedSim listening at socketPath.
+	void simulationWorker(const QString &socketPath);
+
+	// Feeds binary records with an overlong letter string to the
+	// reader and exits with an error unless they're rejected.
+	void checkCorruptRecords();
+
+	// Times kibitzing positions from static player games with the
+	// gaddag as loaded and then compacted.
+	void gaddagBenchmark(unsigned int seed, unsigned int games);
+
+	// Writes the lexicon's alphagram index to the current directory.
+	void writeAlphagramIndex();
+
+	// Runs regexes through WordQuery and QRegExp over every word of
+	// the lexicon and exits with an error if they disagree on any.
+	void checkWordQueries();
+
+	// Lists the plays in the positions that form unacceptable words.
+	void validatePositions();
+
+	// Bulk-reads the positions and prints totals of their moves.
+	void gcgStatistics();
+
+	// Archives the positions to archiveFile and times reading
+	// positions back out of it.
+	void archivePositions(const QString &archiveFile);
+
+	// Writes every game of archiveFile to the games directory as a gcg.
+	void unarchivePositions(const QString &archiveFile);
+
 	void selfPlayGames(unsigned int seed, unsigned int reps, bool reports, bool playability);
 	void selfPlayGame(unsigned int gameNumber, bool reports, bool playability);
 
+	// Plays reps selfplay games on threadCount threads, each with its
+	// own clones of the computer players. Game n draws its tiles, and
+	// seeds its players' simulation rollouts, from a generator seeded
+	// with seed and n, so any game can be replayed alone. Each game is
+	// written to statsFile.csv and the totals, with 95% confidence
+	// intervals, to statsFile.json.
+	void parallelSelfPlayGames(unsigned int seed, unsigned int reps, int threadCount, const QString &statsFile);
+
+	// Plays the same seeded games between fixed-iteration simming
+	// players on one thread and then on threadCount, and exits with
+	// an error unless every game's result is the same.
+	void checkSelfPlayReplay(unsigned int seed, unsigned int reps, int threadCount);
+
 	// Sets the positions that will be tested.
 	void setPositions(const QStringList &positions)
 	{
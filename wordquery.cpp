@@ -0,0 +1,806 @@
+/*
+ *  Quackle -- Crossword game artificial intelligence and analysis tool
+ *  Copyright (C) 2005-2019 Jason Katz-Brown, John O'Laughlin, and John Fultz.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cctype>
+
+#include "datamanager.h"
+#include "lexiconparameters.h"
+#include "wordquery.h"
+
+using namespace Quackle;
+
+namespace
+{
+
+// a node count no sensible query comes near, to stop nested
+// quantifiers from multiplying without bound
+const size_t MaximumNodes = 4096;
+
+bool isRegexSpecial(UVChar c)
+{
+	switch (c)
+	{
+	case '.': case '[': case ']': case '(': case ')': case '|':
+	case '*': case '+': case '?': case '{': case '}': case '^':
+	case '$': case '\\':
+		return true;
+	default:
+		return false;
+	}
+}
+
+bool isPatternSpecial(UVChar c)
+{
+	return c == '?' || c == '.' || c == '*' || c == '[' || c == ']';
+}
+
+}
+
+WordQuery::WordQuery()
+	: m_positionCount(0), m_last(0), m_minimumLength(1), m_maximumLength(LETTER_STRING_MAXIMUM_LENGTH), m_hasLetters(false), m_requireAllLetters(false)
+{
+	setPattern(MARK_UV("*"));
+}
+
+bool WordQuery::setPattern(const UVString &pattern)
+{
+	return compile(pattern, false);
+}
+
+bool WordQuery::setRegex(const UVString &regex)
+{
+	return compile(regex, true);
+}
+
+void WordQuery::setLengthRange(int minimum, int maximum)
+{
+	m_minimumLength = max(minimum, 1);
+	m_maximumLength = min(maximum, LETTER_STRING_MAXIMUM_LENGTH);
+}
+
+void WordQuery::setLetters(const LetterString &letters, bool requireAll)
+{
+	m_letters = letters;
+	m_hasLetters = true;
+	m_requireAllLetters = requireAll;
+}
+
+bool WordQuery::fail(const UVString &error)
+{
+	if (m_error.empty())
+		m_error = error;
+	return false;
+}
+
+bool WordQuery::compile(const UVString &expression, bool isRegex)
+{
+	m_nodes.clear();
+	m_positionCount = 0;
+	m_error.clear();
+	fill(m_follow, m_follow + 64, 0);
+	fill(m_positionsFor, m_positionsFor + QUACKLE_MAXIMUM_ALPHABET_SIZE, 0);
+	m_last = 0;
+
+	size_t i = 0;
+	int root = addNode(Node::Concat);
+	if (isRegex)
+	{
+		// ^ and $ bind to their own top-level alternative, so ^AB|CD$
+		// is ^AB or CD$; anywhere else they're rejected below
+		const int alternation = addNode(Node::Alternate);
+		if (alternation < 0)
+			root = -1;
+		else
+			m_nodes[root].children.push_back(alternation);
+
+		while (root >= 0)
+		{
+			const int alternative = parseAnchoredAlternative(expression, i);
+			if (alternative < 0)
+				root = -1;
+			else
+				m_nodes[alternation].children.push_back(alternative);
+
+			if (i >= expression.size() || expression[i] != '|')
+				break;
+			++i;
+		}
+	}
+	else
+	{
+		while (root >= 0 && i < expression.size())
+		{
+			const int atom = parsePatternAtom(expression, i);
+			if (atom < 0)
+				root = -1;
+			else
+				m_nodes[root].children.push_back(atom);
+		}
+	}
+
+	if (root >= 0 && i < expression.size())
+	{
+		fail(MARK_UV("unexpected ") + expression.substr(i, 1));
+		root = -1;
+	}
+
+	if (root < 0 || !m_error.empty() || m_positionCount > StartPosition)
+	{
+		if (m_positionCount > StartPosition)
+			fail(MARK_UV("too many letters in expression"));
+		fail(MARK_UV("could not parse expression"));
+
+		// match nothing rather than everything
+		fill(m_follow, m_follow + 64, 0);
+		fill(m_positionsFor, m_positionsFor + QUACKLE_MAXIMUM_ALPHABET_SIZE, 0);
+		m_last = 0;
+		return false;
+	}
+
+	m_positionCount = 0;
+	const Glushkov result = glushkov(root);
+	m_follow[StartPosition] = result.first;
+	m_last = result.last | (result.nullable ? startState() : 0);
+	return true;
+}
+
+int WordQuery::addNode(Node::Type type, LetterMask mask)
+{
+	if (m_nodes.size() >= MaximumNodes)
+	{
+		fail(MARK_UV("expression too large"));
+		return -1;
+	}
+
+	if (type == Node::Letters)
+		++m_positionCount;
+
+	Node node;
+	node.type = type;
+	node.mask = mask;
+	m_nodes.push_back(node);
+	return (int)m_nodes.size() - 1;
+}
+
+int WordQuery::addAnyRun()
+{
+	const int ret = addNode(Node::Star);
+	const int any = addNode(Node::Letters, LetterMasks::full());
+	if (ret < 0 || any < 0)
+		return -1;
+	m_nodes[ret].children.push_back(any);
+	return ret;
+}
+
+int WordQuery::cloneNode(int node)
+{
+	const int ret = addNode(m_nodes[node].type, m_nodes[node].mask);
+	if (ret < 0)
+		return -1;
+
+	// copied, as cloning children can reallocate m_nodes
+	const vector<int> children = m_nodes[node].children;
+	for (const auto &child : children)
+	{
+		const int clone = cloneNode(child);
+		if (clone < 0)
+			return -1;
+		m_nodes[ret].children.push_back(clone);
+	}
+
+	return ret;
+}
+
+int WordQuery::parseAnchoredAlternative(const UVString &expression, size_t &i)
+{
+	const bool anchoredStart = i < expression.size() && expression[i] == '^';
+	if (anchoredStart)
+		++i;
+
+	const int alternative = parseConcatenation(expression, i);
+	const bool anchoredEnd = i < expression.size() && expression[i] == '$';
+	if (anchoredEnd)
+		++i;
+
+	const int ret = addNode(Node::Concat);
+	if (alternative < 0 || ret < 0)
+		return -1;
+
+	// unanchored ends match any run of letters
+	if (!anchoredStart)
+	{
+		const int before = addAnyRun();
+		if (before < 0)
+			return -1;
+		m_nodes[ret].children.push_back(before);
+	}
+
+	m_nodes[ret].children.push_back(alternative);
+
+	if (!anchoredEnd)
+	{
+		const int after = addAnyRun();
+		if (after < 0)
+			return -1;
+		m_nodes[ret].children.push_back(after);
+	}
+
+	return ret;
+}
+
+int WordQuery::parseAlternation(const UVString &expression, size_t &i)
+{
+	int ret = parseConcatenation(expression, i);
+	if (ret < 0 || i >= expression.size() || expression[i] != '|')
+		return ret;
+
+	const int alternative = ret;
+	ret = addNode(Node::Alternate);
+	if (ret < 0)
+		return -1;
+	m_nodes[ret].children.push_back(alternative);
+
+	while (i < expression.size() && expression[i] == '|')
+	{
+		++i;
+		const int next = parseConcatenation(expression, i);
+		if (next < 0)
+			return -1;
+		m_nodes[ret].children.push_back(next);
+	}
+
+	return ret;
+}
+
+int WordQuery::parseConcatenation(const UVString &expression, size_t &i)
+{
+	const int ret = addNode(Node::Concat);
+	if (ret < 0)
+		return -1;
+
+	while (i < expression.size() && expression[i] != '|' && expression[i] != ')')
+	{
+		if (expression[i] == '$')
+			break;
+
+		const int atom = parseAtom(expression, i);
+		if (atom < 0)
+			return -1;
+
+		const int quantified = parseQuantifier(expression, i, atom);
+		if (quantified < 0)
+			return -1;
+		m_nodes[ret].children.push_back(quantified);
+	}
+
+	return ret;
+}
+
+int WordQuery::parseQuantifier(const UVString &expression, size_t &i, int atom)
+{
+	if (i >= expression.size())
+		return atom;
+
+	int minimum = 1;
+	int maximum = 1;
+	switch (expression[i])
+	{
+	case '*':
+		minimum = 0;
+		maximum = -1;
+		++i;
+		break;
+
+	case '+':
+		maximum = -1;
+		++i;
+		break;
+
+	case '?':
+		minimum = 0;
+		++i;
+		break;
+
+	case '{':
+	{
+		size_t j = i + 1;
+		minimum = 0;
+		if (j >= expression.size() || !isdigit((unsigned char)expression[j]))
+		{
+			fail(MARK_UV("expected a count after {"));
+			return -1;
+		}
+		while (j < expression.size() && isdigit((unsigned char)expression[j]))
+			minimum = min(minimum * 10 + (expression[j++] - '0'), 1000);
+
+		maximum = minimum;
+		if (j < expression.size() && expression[j] == ',')
+		{
+			++j;
+			if (j < expression.size() && isdigit((unsigned char)expression[j]))
+			{
+				maximum = 0;
+				while (j < expression.size() && isdigit((unsigned char)expression[j]))
+					maximum = min(maximum * 10 + (expression[j++] - '0'), 1000);
+			}
+			else
+				maximum = -1;
+		}
+
+		if (j >= expression.size() || expression[j] != '}' || (maximum >= 0 && maximum < minimum))
+		{
+			fail(MARK_UV("bad repetition count"));
+			return -1;
+		}
+		i = j + 1;
+
+		// a word can't hold more repeats than it has letters
+		minimum = min(minimum, LETTER_STRING_MAXIMUM_LENGTH + 1);
+		if (maximum > LETTER_STRING_MAXIMUM_LENGTH)
+			maximum = LETTER_STRING_MAXIMUM_LENGTH;
+		break;
+	}
+
+	default:
+		return atom;
+	}
+
+	const int ret = addNode(Node::Concat);
+	if (ret < 0)
+		return -1;
+
+	// atom itself serves as the first copy
+	int copy = atom;
+	for (int n = 0; n < minimum; ++n)
+	{
+		if (n > 0 && (copy = cloneNode(atom)) < 0)
+			return -1;
+		m_nodes[ret].children.push_back(copy);
+	}
+
+	if (maximum < 0)
+	{
+		const int star = addNode(Node::Star);
+		if (star < 0)
+			return -1;
+		if (minimum > 0 && (copy = cloneNode(atom)) < 0)
+			return -1;
+		m_nodes[star].children.push_back(copy);
+		m_nodes[ret].children.push_back(star);
+	}
+	else
+	{
+		for (int n = minimum; n < maximum; ++n)
+		{
+			const int optional = addNode(Node::Alternate);
+			const int empty = addNode(Node::Empty);
+			if (optional < 0 || empty < 0)
+				return -1;
+			if ((n > 0 || minimum > 0) && (copy = cloneNode(atom)) < 0)
+				return -1;
+			m_nodes[optional].children.push_back(copy);
+			m_nodes[optional].children.push_back(empty);
+			m_nodes[ret].children.push_back(optional);
+		}
+	}
+
+	return ret;
+}
+
+int WordQuery::parseAtom(const UVString &expression, size_t &i)
+{
+	const UVChar c = expression[i];
+	switch (c)
+	{
+	case '(':
+	{
+		++i;
+		const int ret = parseAlternation(expression, i);
+		if (ret < 0)
+			return -1;
+		if (i >= expression.size() || expression[i] != ')')
+		{
+			fail(MARK_UV("missing )"));
+			return -1;
+		}
+		++i;
+		return ret;
+	}
+
+	case '[':
+	{
+		LetterMask mask;
+		if (!parseClass(expression, i, mask))
+			return -1;
+		return addNode(Node::Letters, mask);
+	}
+
+	case '.':
+		++i;
+		return addNode(Node::Letters, LetterMasks::full());
+
+	case '\\':
+	{
+		// only escaped metacharacters are literals; classes like \w
+		// and assertions like \b are left to a full regex engine
+		++i;
+		Letter letter;
+		if (i >= expression.size() || !isRegexSpecial(expression[i]) || !parseLetter(expression, i, letter))
+		{
+			fail(MARK_UV("unsupported escape"));
+			return -1;
+		}
+		return addNode(Node::Letters, LetterMasks::bit(letter));
+	}
+
+	default:
+	{
+		if (isRegexSpecial(c))
+		{
+			fail(MARK_UV("unexpected ") + UVString(1, c));
+			return -1;
+		}
+
+		Letter letter;
+		if (!parseLetter(expression, i, letter))
+			return -1;
+		return addNode(Node::Letters, LetterMasks::bit(letter));
+	}
+	}
+}
+
+int WordQuery::parsePatternAtom(const UVString &expression, size_t &i)
+{
+	switch (expression[i])
+	{
+	case '?':
+	case '.':
+		++i;
+		return addNode(Node::Letters, LetterMasks::full());
+
+	case '*':
+		++i;
+		return addAnyRun();
+
+	case '[':
+	{
+		LetterMask mask;
+		if (!parseClass(expression, i, mask))
+			return -1;
+		return addNode(Node::Letters, mask);
+	}
+
+	default:
+	{
+		if (isPatternSpecial(expression[i]))
+		{
+			fail(MARK_UV("unexpected ") + expression.substr(i, 1));
+			return -1;
+		}
+
+		Letter letter;
+		if (!parseLetter(expression, i, letter))
+			return -1;
+		return addNode(Node::Letters, LetterMasks::bit(letter));
+	}
+	}
+}
+
+bool WordQuery::parseClass(const UVString &expression, size_t &i, LetterMask &mask)
+{
+	++i;
+	mask = 0;
+
+	const bool negated = i < expression.size() && expression[i] == '^';
+	if (negated)
+		++i;
+
+	while (i < expression.size() && expression[i] != ']')
+	{
+		Letter first;
+		if (!parseLetter(expression, i, first))
+			return false;
+
+		Letter last = first;
+		if (i + 1 < expression.size() && expression[i] == '-' && expression[i + 1] != ']')
+		{
+			++i;
+			if (!parseLetter(expression, i, last))
+				return false;
+			if (last < first)
+				return fail(MARK_UV("bad range in class"));
+		}
+
+		for (Letter letter = first; letter <= last; ++letter)
+			mask |= LetterMasks::bit(letter);
+	}
+
+	if (i >= expression.size())
+		return fail(MARK_UV("missing ]"));
+	++i;
+
+	if (negated)
+		mask = ~mask & LetterMasks::full();
+	return true;
+}
+
+// Reads the shortest run of text at i that encodes to exactly one
+// letter, the same way AlphabetParameters::encode splits words,
+// trying upper case too. Blank letters stand for their letter.
+bool WordQuery::parseLetter(const UVString &expression, size_t &i, Letter &letter)
+{
+	const AlphabetParameters *alphabet = QUACKLE_ALPHABET_PARAMETERS;
+	for (size_t length = 1; i + length <= expression.size(); ++length)
+	{
+		if (length > 1 && isRegexSpecial(expression[i + length - 1]))
+			break;
+
+		UVString text = expression.substr(i, length);
+		for (int attempt = 0; attempt < 2; ++attempt)
+		{
+			UVString leftover;
+			const LetterString encoded = alphabet->encode(text, &leftover);
+			if (leftover.empty() && encoded.length() == 1 && alphabet->isSomeLetter(encoded[0]))
+			{
+				letter = alphabet->clearBlankness(encoded[0]);
+				i += length;
+				return true;
+			}
+
+			for (auto &c : text)
+				if (c >= 'a' && c <= 'z')
+					c = c - 'a' + 'A';
+		}
+	}
+
+	return fail(MARK_UV("not a letter: ") + expression.substr(i, 1));
+}
+
+WordQuery::Glushkov WordQuery::glushkov(int node)
+{
+	Glushkov ret = { false, 0, 0 };
+	const Node &n = m_nodes[node];
+	switch (n.type)
+	{
+	case Node::Empty:
+		ret.nullable = true;
+		break;
+
+	case Node::Letters:
+	{
+		const int position = m_positionCount++;
+		ret.first = ret.last = uint64_t(1) << position;
+		for (int letter = 0; letter < QUACKLE_MAXIMUM_ALPHABET_SIZE; ++letter)
+			if (n.mask & (LetterMask(1) << letter))
+				m_positionsFor[letter] |= ret.first;
+		break;
+	}
+
+	case Node::Concat:
+		ret.nullable = true;
+		for (const auto &child : n.children)
+		{
+			const Glushkov next = glushkov(child);
+			for (int position = 0; position < StartPosition; ++position)
+				if (ret.last & (uint64_t(1) << position))
+					m_follow[position] |= next.first;
+
+			if (ret.nullable)
+				ret.first |= next.first;
+			ret.last = next.nullable ? (ret.last | next.last) : next.last;
+			ret.nullable = ret.nullable && next.nullable;
+		}
+		break;
+
+	case Node::Alternate:
+		for (const auto &child : n.children)
+		{
+			const Glushkov next = glushkov(child);
+			ret.nullable = ret.nullable || next.nullable;
+			ret.first |= next.first;
+			ret.last |= next.last;
+		}
+		break;
+
+	case Node::Star:
+	{
+		ret = glushkov(n.children.front());
+		for (int position = 0; position < StartPosition; ++position)
+			if (ret.last & (uint64_t(1) << position))
+				m_follow[position] |= ret.first;
+		ret.nullable = true;
+		break;
+	}
+	}
+
+	return ret;
+}
+
+WordQuery::State WordQuery::advance(State state, Letter letter) const
+{
+	State next = 0;
+	for (int position = 0; state; ++position, state >>= 1)
+		if (state & 1)
+			next |= m_follow[position];
+	return next & m_positionsFor[letter - QUACKLE_FIRST_LETTER];
+}
+
+bool WordQuery::matches(const LetterString &word) const
+{
+	const int length = (int)word.length();
+	if (length < m_minimumLength || length > m_maximumLength)
+		return false;
+
+	if (m_hasLetters)
+	{
+		if (m_requireAllLetters && length != (int)m_letters.length())
+			return false;
+
+		int counts[QUACKLE_FIRST_LETTER + QUACKLE_MAXIMUM_ALPHABET_SIZE] = { 0 };
+		int blanks = 0;
+		for (const auto &letter : m_letters)
+		{
+			if (letter == QUACKLE_BLANK_MARK)
+				++blanks;
+			else
+				++counts[QUACKLE_ALPHABET_PARAMETERS->clearBlankness(letter)];
+		}
+
+		for (const auto &letter : word)
+		{
+			const Letter plain = QUACKLE_ALPHABET_PARAMETERS->clearBlankness(letter);
+			if (counts[plain] > 0)
+				--counts[plain];
+			else if (blanks > 0)
+				--blanks;
+			else
+				return false;
+		}
+	}
+
+	State state = startState();
+	for (const auto &letter : word)
+	{
+		state = advance(state, QUACKLE_ALPHABET_PARAMETERS->clearBlankness(letter));
+		if (!state)
+			return false;
+	}
+
+	return isAccepting(state);
+}
+
+////////
+
+struct WordQueryEngine::Walk
+{
+	Walk(const WordQuery &query)
+		: query(query), blanks(0)
+	{
+		fill(counts, counts + QUACKLE_FIRST_LETTER + QUACKLE_MAXIMUM_ALPHABET_SIZE, 0);
+		minimumLength = query.minimumLength();
+		maximumLength = query.maximumLength();
+
+		if (query.hasLetters())
+		{
+			for (const auto &letter : query.letters())
+			{
+				if (letter == QUACKLE_BLANK_MARK)
+					++blanks;
+				else
+					++counts[QUACKLE_ALPHABET_PARAMETERS->clearBlankness(letter)];
+			}
+
+			const int letterCount = (int)query.letters().length();
+			maximumLength = min(maximumLength, letterCount);
+			if (query.requireAllLetters())
+				minimumLength = max(minimumLength, letterCount);
+		}
+	}
+
+	const WordQuery &query;
+	int counts[QUACKLE_FIRST_LETTER + QUACKLE_MAXIMUM_ALPHABET_SIZE];
+	int blanks;
+	int minimumLength;
+	int maximumLength;
+	LetterString prefix;
+	vector<WordWithInfo> results;
+};
+
+WordQueryEngine::WordQueryEngine(const LexiconParameters *lexicon)
+	: m_lexicon(lexicon), m_alphagramIndex(&m_ownedAlphagramIndex)
+{
+	if (lexicon->hasAlphagramIndex())
+		m_alphagramIndex = &lexicon->alphagramIndex();
+	else
+		m_ownedAlphagramIndex.build(*lexicon);
+}
+
+vector<WordWithInfo> WordQueryEngine::query(const WordQuery &query) const
+{
+	Walk walk(query);
+	if (m_lexicon->hasDawg() && walk.minimumLength <= walk.maximumLength)
+		this->walk(walk, 1, query.startState());
+
+	sort(walk.results.begin(), walk.results.end(), [](const WordWithInfo &word1, const WordWithInfo &word2) { return word1.wordLetterString < word2.wordLetterString; });
+	return walk.results;
+}
+
+void WordQueryEngine::walk(Walk &walk, int index, WordQuery::State state) const
+{
+	const bool limitLetters = walk.query.hasLetters();
+
+	unsigned int p;
+	Letter letter;
+	bool t;
+	bool lastchild;
+	bool british;
+	int playability;
+
+	do
+	{
+		m_lexicon->dawgAt(index, p, letter, t, lastchild, british, playability);
+		index++;
+
+		const WordQuery::State next = walk.query.advance(state, letter);
+		if (!next)
+			continue;
+
+		int *used = 0;
+		if (limitLetters)
+		{
+			if (walk.counts[letter] > 0)
+				used = &walk.counts[letter];
+			else if (walk.blanks > 0)
+				used = &walk.blanks;
+			else
+				continue;
+			--*used;
+		}
+
+		walk.prefix.push_back(letter);
+		const int length = (int)walk.prefix.length();
+
+		if (t && length >= walk.minimumLength && walk.query.isAccepting(next))
+		{
+			WordWithInfo word;
+			word.wordLetterString = walk.prefix;
+			word.playability = playability;
+			word.british = british;
+			walk.results.push_back(word);
+		}
+
+		if (p && length < walk.maximumLength)
+			this->walk(walk, p, next);
+
+		walk.prefix.pop_back();
+		if (used)
+			++*used;
+	} while (!lastchild);
+}
+
+vector<WordWithInfo> WordQueryEngine::anagrams(const LetterString &letters) const
+{
+	const bool hasBlank = find(letters.begin(), letters.end(), (Letter)QUACKLE_BLANK_MARK) != letters.end();
+	if (!hasBlank && !m_alphagramIndex->isEmpty())
+		return m_alphagramIndex->anagrams(QUACKLE_ALPHABET_PARAMETERS->clearBlankness(letters));
+
+	WordQuery query;
+	query.setLetters(letters, true);
+	return this->query(query);
+}
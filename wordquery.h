@@ -0,0 +1,210 @@
+/*
+ *  Quackle -- Crossword game artificial intelligence and analysis tool
+ *  Copyright (C) 2005-2019 Jason Katz-Brown, John O'Laughlin, and John Fultz.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QUACKLE_WORDQUERY_H
+#define QUACKLE_WORDQUERY_H
+
+#include <cstdint>
+#include <vector>
+
+#include "alphabetparameters.h"
+#include "alphagramindex.h"
+#include "generator.h"
+
+namespace Quackle
+{
+
+class LexiconParameters;
+
+// A set of conditions on words: a pattern or regular expression,
+// a length range and letters the word must be made from. Patterns
+// and regexes are compiled to a position automaton over letters,
+// so they can be matched a letter at a time during a lexicon walk.
+class WordQuery
+{
+public:
+	WordQuery();
+
+	// Word-judge style pattern matching the whole word: ? or . is
+	// any letter, * any run of letters, and [AEIOU] or [^AEIOU] one
+	// letter of (or not of) a class. Replaces any regex. Returns
+	// false and sets error() if the pattern can't be compiled.
+	bool setPattern(const UVString &pattern);
+
+	// Regular expression over letters: literals, ., classes with
+	// ranges, grouping, | and the quantifiers * + ? {m} {m,} {m,n}.
+	// Like a regex search it matches anywhere in the word unless
+	// anchored with ^ or $, which may only start or end a top-level
+	// alternative. Escapes other than of metacharacters, such as \w,
+	// aren't compiled. Replaces any pattern.
+	bool setRegex(const UVString &regex);
+
+	// words from minimum to maximum letters long inclusive
+	void setLengthRange(int minimum, int maximum);
+
+	// Words made from letters, which may include blanks. If
+	// requireAll, every letter must be used.
+	void setLetters(const LetterString &letters, bool requireAll);
+
+	const UVString &error() const;
+
+	// whether word meets every condition
+	bool matches(const LetterString &word) const;
+
+	// automaton state before any letters are read
+	typedef uint64_t State;
+	State startState() const;
+
+	// state after reading letter from state; 0 means no match can follow
+	State advance(State state, Letter letter) const;
+	bool isAccepting(State state) const;
+
+	int minimumLength() const;
+	int maximumLength() const;
+
+	bool hasLetters() const;
+	const LetterString &letters() const;
+	bool requireAllLetters() const;
+
+private:
+	struct Node
+	{
+		enum Type { Empty, Letters, Concat, Alternate, Star };
+		Type type;
+		LetterMask mask;
+		vector<int> children;
+	};
+
+	struct Glushkov
+	{
+		bool nullable;
+		uint64_t first;
+		uint64_t last;
+	};
+
+	bool compile(const UVString &expression, bool isRegex);
+
+	int addNode(Node::Type type, LetterMask mask = 0);
+	int addAnyRun();
+	int cloneNode(int node);
+	int parseAnchoredAlternative(const UVString &expression, size_t &i);
+	int parseAlternation(const UVString &expression, size_t &i);
+	int parseConcatenation(const UVString &expression, size_t &i);
+	int parseQuantifier(const UVString &expression, size_t &i, int atom);
+	int parseAtom(const UVString &expression, size_t &i);
+	int parsePatternAtom(const UVString &expression, size_t &i);
+	bool parseClass(const UVString &expression, size_t &i, LetterMask &mask);
+	bool parseLetter(const UVString &expression, size_t &i, Letter &letter);
+	Glushkov glushkov(int node);
+	bool fail(const UVString &error);
+
+	vector<Node> m_nodes;
+	int m_positionCount;
+	UVString m_error;
+
+	// position 63 is the start state; a state's bits are the
+	// positions the letters so far could have ended on
+	static const int StartPosition = 63;
+	uint64_t m_follow[64];
+	uint64_t m_positionsFor[QUACKLE_MAXIMUM_ALPHABET_SIZE];
+	uint64_t m_last;
+
+	int m_minimumLength;
+	int m_maximumLength;
+
+	LetterString m_letters;
+	bool m_hasLetters;
+	bool m_requireAllLetters;
+};
+
+// Answers WordQueries over a lexicon's dawg, with an alphagram index
+// for exact anagrams: the lexicon's if it has one loaded, otherwise
+// one built on construction.
+class WordQueryEngine
+{
+public:
+	// lexicon must outlive the engine
+	WordQueryEngine(const LexiconParameters *lexicon);
+
+	// every word matching query, alphabetically
+	vector<WordWithInfo> query(const WordQuery &query) const;
+
+	// every word using all of letters, which may include blanks
+	vector<WordWithInfo> anagrams(const LetterString &letters) const;
+
+	const AlphagramIndex &alphagramIndex() const;
+
+private:
+	struct Walk;
+	void walk(Walk &walk, int index, WordQuery::State state) const;
+
+	const LexiconParameters *m_lexicon;
+
+	// either the lexicon's or m_ownedAlphagramIndex
+	const AlphagramIndex *m_alphagramIndex;
+	AlphagramIndex m_ownedAlphagramIndex;
+};
+
+inline const UVString &WordQuery::error() const
+{
+	return m_error;
+}
+
+inline WordQuery::State WordQuery::startState() const
+{
+	return uint64_t(1) << StartPosition;
+}
+
+inline bool WordQuery::isAccepting(State state) const
+{
+	return (state & m_last) != 0;
+}
+
+inline int WordQuery::minimumLength() const
+{
+	return m_minimumLength;
+}
+
+inline int WordQuery::maximumLength() const
+{
+	return m_maximumLength;
+}
+
+inline bool WordQuery::hasLetters() const
+{
+	return m_hasLetters;
+}
+
+inline const LetterString &WordQuery::letters() const
+{
+	return m_letters;
+}
+
+inline bool WordQuery::requireAllLetters() const
+{
+	return m_requireAllLetters;
+}
+
+inline const AlphagramIndex &WordQueryEngine::alphagramIndex() const
+{
+	return *m_alphagramIndex;
+}
+
+}
+
+#endif